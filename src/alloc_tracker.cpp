@@ -0,0 +1,120 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_tracker.hpp"
+
+namespace
+{
+    std::atomic<std::size_t> s_allocationCount{0};
+    std::atomic<std::size_t> s_deallocationCount{0};
+    std::atomic<std::size_t> s_allocatedBytes{0};
+}
+
+#ifdef ENVELOPE_TRACK_ALLOCATIONS
+
+// replacement global allocation functions, every other form forwards to these
+void* operator new(std::size_t size)
+{
+    s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return ::operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    s_deallocationCount.fetch_add(1, std::memory_order_relaxed);
+    std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+    ::operator delete(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+
+#endif // ENVELOPE_TRACK_ALLOCATIONS
+
+bool AllocTracker::isEnabled()
+{
+#ifdef ENVELOPE_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::size_t AllocTracker::getAllocationCount()
+{
+    return s_allocationCount.load(std::memory_order_relaxed);
+}
+std::size_t AllocTracker::getDeallocationCount()
+{
+    return s_deallocationCount.load(std::memory_order_relaxed);
+}
+std::size_t AllocTracker::getAllocatedBytes()
+{
+    return s_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+void AllocTracker::reset()
+{
+    s_allocationCount.store(0, std::memory_order_relaxed);
+    s_deallocationCount.store(0, std::memory_order_relaxed);
+    s_allocatedBytes.store(0, std::memory_order_relaxed);
+}
+
+AllocScope::AllocScope()
+: m_startAllocations(AllocTracker::getAllocationCount())
+, m_startDeallocations(AllocTracker::getDeallocationCount())
+, m_startBytes(AllocTracker::getAllocatedBytes())
+{
+}
+
+std::size_t AllocScope::getAllocations() const
+{
+    return AllocTracker::getAllocationCount() - m_startAllocations;
+}
+std::size_t AllocScope::getDeallocations() const
+{
+    return AllocTracker::getDeallocationCount() - m_startDeallocations;
+}
+std::size_t AllocScope::getBytes() const
+{
+    return AllocTracker::getAllocatedBytes() - m_startBytes;
+}
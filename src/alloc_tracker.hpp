@@ -0,0 +1,44 @@
+#ifndef ALLOC_TRACKER_HPP
+#define ALLOC_TRACKER_HPP
+
+#include <cstddef>
+
+/*
+    Counts calls to the global operator new / delete.
+
+    Only active when built with ENVELOPE_TRACK_ALLOCATIONS,
+    otherwise every counter reads zero. Used to check that
+    the block renderer and the UI frame loop stay allocation free
+    once they are warmed up.
+*/
+
+class AllocTracker
+{
+    public:
+
+        static bool isEnabled();    // true when the counting operators are compiled in
+
+        static std::size_t getAllocationCount();
+        static std::size_t getDeallocationCount();
+        static std::size_t getAllocatedBytes();
+
+        static void reset();
+};
+
+// snapshot of the counters, measures everything allocated during its lifetime
+class AllocScope
+{
+    public:
+        AllocScope();
+
+        std::size_t getAllocations() const;     // allocations since construction
+        std::size_t getDeallocations() const;   // deallocations since construction
+        std::size_t getBytes() const;           // bytes requested since construction
+
+    private:
+        std::size_t m_startAllocations;
+        std::size_t m_startDeallocations;
+        std::size_t m_startBytes;
+};
+
+#endif // ALLOC_TRACKER_HPP
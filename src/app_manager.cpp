@@ -3,100 +3,76 @@
 #include <iostream>
 
 #include "app_manager.hpp"
-#include "knob.hpp"
-#include "button.hpp"
+#include "alloc_tracker.hpp"
+#include "preset.hpp"
+#include "render_stats.hpp"
+#include "trace.hpp"
+
+namespace
+{
+#ifdef ENVELOPE_MEASURE_LATENCY
+    const bool MEASURE_LATENCY = true;
+#else
+    const bool MEASURE_LATENCY = false;
+#endif
+
+#ifdef ENVELOPE_TRACE
+    const bool TRACE_ENABLED = true;
+#else
+    const bool TRACE_ENABLED = false;
+#endif
+
+    // the series reserve their storage, nothing is needed when they're unused
+    const std::size_t LATENCY_CAPACITY = MEASURE_LATENCY ? 100000 : 0;
+
+    // packet arrival to update is measured in every build
+    const std::size_t REMOTE_LATENCY_CAPACITY = 100000;
+}
 
 AppManager::AppManager()
 : m_window(sf::VideoMode(750, 750), "Envelope Visualizer 9000")
 
-, m_attackSlider(0.01f, 3.f, "Attack")
-, m_decaySlider(0.01f, 3.f, "Decay")
-, m_sustainSlider(0.01f, 1.f, "Sustain")
-, m_releaseSlider(0.01f, 3.f, "Release")
-
-, m_attackSlopeKnob(Knob::KnobType::Centered, -10.f, 10.f, 0.f, 22.f, "")
-, m_decaySlopeKnob(Knob::KnobType::Centered, -10.f, 10.f, 0.f, 22.f, "")
-, m_releaseSlopeKnob(Knob::KnobType::Centered, -10.f, 10.f, 0.f, 22.f, "")
-
-, m_envelopeTypeButton(Button::ButtonShape::Rectangle, Button::ButtonType::StateCycling, Button::TitleLocation::Below, "Envelope Type", 125.f, 50.f)
-, m_loopButton(Button::ButtonShape::Rectangle, Button::ButtonType::Latching, Button::TitleLocation::Below, "Loop", 125.f, 50.f)
-, m_trigButton(Button::ButtonShape::Circle, Button::ButtonType::Momentary, Button::TitleLocation::Centered, "TRIG", 75.f)
-, m_resetButton(Button::ButtonShape::Circle, Button::ButtonType::Momentary, Button::TitleLocation::Centered, "RESET", 75.f)
-
 , m_envelope()
-, m_envelopeVisualizer(m_envelope)
+, m_controlPanel(m_envelope)
+
+, m_isRemoteGateOn(false)
+, m_isRemoteTriggerPending(false)
+, m_isRemoteResetPending(false)
+, m_lastRemoteArrival(0)
+, m_remoteLatency("OSC packet to update", REMOTE_LATENCY_CAPACITY)
+
+, m_isKeyGateOn(false)
+, m_mouseLatency("TRIG button", LATENCY_CAPACITY)
+, m_keyLatency("space bar", LATENCY_CAPACITY)
+, m_oscLatency("OSC gate", LATENCY_CAPACITY)
+, m_gateInputSeries(nullptr)
+, m_gateInputTime(0)
+
+, m_frameStart(std::chrono::steady_clock::now())
+, m_cpuTime(0.0f)
+, m_envelopeUpdateTime(0.0f)
+, m_visualizerUpdateTime(0.0f)
 {
     // get window dimensions
     sf::Vector2u windowSize = m_window.getSize();
     sf::Vector2f windowSizeF(static_cast<float>(windowSize.x), static_cast<float>(windowSize.y));
 
-    // position sliders
-    float sliderStartX = (2.f / 29.f) * windowSizeF.x; 
-    float sliderEndX = (20.f / 29.f) * windowSizeF.x;
-
-    float attackY = (3.f / 29.f) * windowSizeF.y;
-    m_attackSlider.setPosition(sf::Vector2f(sliderStartX, attackY), sf::Vector2f(sliderEndX, attackY));
-    m_attackSlider.setValue(m_envelope.getAttackTime());
-
-    float decayY = (6.f / 29.f) * windowSizeF.y;
-    m_decaySlider.setPosition(sf::Vector2f(sliderStartX, decayY), sf::Vector2f(sliderEndX, decayY));
-    m_decaySlider.setValue(m_envelope.getDecayTime());
-
-    float sustainY = (9.f / 29.f) * windowSizeF.y;
-    m_sustainSlider.setPosition(sf::Vector2f(sliderStartX, sustainY), sf::Vector2f(sliderEndX, sustainY));
-    m_sustainSlider.setValue(m_envelope.getSustainLevel());
-
-    float releaseY = (12.f / 29.f) * windowSizeF.y;
-    m_releaseSlider.setPosition(sf::Vector2f(sliderStartX, releaseY), sf::Vector2f(sliderEndX, releaseY));
-    m_releaseSlider.setValue(m_envelope.getReleaseTime());
-
-    // initialize knobs
-
-    float knobX = (23.f / 29.f) * windowSizeF.x;
-
-    m_attackSlopeKnob.setPosition(sf::Vector2f(knobX, attackY));
-    m_decaySlopeKnob.setPosition(sf::Vector2f(knobX, decayY));
-    m_releaseSlopeKnob.setPosition(sf::Vector2f(knobX, releaseY));
+    m_controlPanel.layOut(windowSizeF);
 
-    // initialize buttons
-
-    // envelope type button
-    float envButtonX = (5.5f / 29.f) * windowSizeF.x;
-    float envButtonY = (14.5f / 29.f) * windowSizeF.y;
-    m_envelopeTypeButton.setPosition(sf::Vector2f(envButtonX, envButtonY));
-
-    std::vector<sf::String> labels = {"ADSR", "ASR", "AD"};
-    // std::vector<sf::String> colors = {sf::Color(r, g, b), sf::Color(r, g, b), sf::Color(r, g, b)};
-    std::vector<sf::Color> colors = {sf::Color::Magenta, sf::Color::Yellow, sf::Color::Green};
-    m_envelopeTypeButton.setStates(labels, colors);
-
-    // loop button
-    float loopButtonX = (13.5f / 29.f) * windowSizeF.x;
-    float loopButtonY = (14.5f / 29.f) * windowSizeF.y;
-    m_loopButton.setPosition(sf::Vector2f(loopButtonX, loopButtonY));
-
-    // trig button
-    float trigButtonX = (23.f / 29.f) * windowSizeF.x;
-    float trigButtonY = (18.f / 29.f) * windowSizeF.y;
-
-    m_trigButton.setPosition(sf::Vector2f(trigButtonX, trigButtonY));
-    m_trigButton.setUnpressedColor(sf::Color::Green);
-
-    // reset button
-    float resetButtonX = (23.f / 29.f) * windowSizeF.x;
-    float resetButtonY = (24.f / 29.f) * windowSizeF.y;
-
-    m_resetButton.setPosition(sf::Vector2f(resetButtonX, resetButtonY));
-    m_resetButton.setUnpressedColor(sf::Color::Red);
-
-    // initialize visualizer window
-    float vizX = (1.f / 29.f) * windowSizeF.x;
-    float vizY = (17.f / 29.f) * windowSizeF.y;
+    // nothing else depends on the bus, without it the app just doesn't publish
+    if (!m_cvBus.create("envelope_cv", 1))
+    {
+        std::cerr << "CV bus unavailable, not publishing the envelope" << std::endl;
+    }
 
-    float vizWidth = ((19.f / 29.f) * windowSizeF.x) - vizX;
-    float vizHeight = ((28.f / 29.f) * windowSizeF.y) - vizY;
+    // HUD in the top right corner
+    m_hud.setPosition(sf::Vector2f(windowSizeF.x - m_hud.getSize().x - 10.f, 10.f));
 
-    m_envelopeVisualizer.setPosition(sf::Vector2f(vizX, vizY), sf::Vector2f(vizWidth, vizHeight), m_envelope);
+    m_pendingArrivals.reserve(OscEndpoint::QUEUE_SIZE);
+    if (m_oscEndpoint.open(OscEndpoint::DEFAULT_PORT))
+    {
+        std::cout << "Listening for OSC on 127.0.0.1:" << m_oscEndpoint.getPort() << std::endl;
+    }
 }
 
 AppManager::~AppManager()
@@ -105,126 +81,295 @@ AppManager::~AppManager()
 
 void AppManager::run()
 {
+    std::size_t frameCount = 0;
+    std::size_t allocatingFrames = 0;
+
+    TRACE_THREAD_NAME("main");
+
     while(m_window.isOpen())
     {
+        TRACE_SCOPE("frame");
+        AllocScope frameAllocations;
+
+        RenderStats::reset();
+
         handleEvents();    // handle user inputs
         update();           // Update application state
         render();           // Render everything to the screen
+
+        // shown from the next frame on
+        std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+        float frameTime = std::chrono::duration<float>(frameEnd - m_frameStart).count();
+        m_frameStart = frameEnd;
+        m_hud.addFrame(frameTime, m_cpuTime, m_envelopeUpdateTime, m_visualizerUpdateTime,
+                       RenderStats::getDrawCalls(), RenderStats::getRebuiltVertices());
+
+        frameCount++;
+        if (frameAllocations.getAllocations() > 0)
+        {
+            allocatingFrames++;
+        }
+    }
+
+    if (AllocTracker::isEnabled())
+    {
+        std::cout << allocatingFrames << " of " << frameCount << " frames allocated memory" << std::endl;
+    }
+
+    if (Trace::isRunning())
+    {
+        stopTrace();
+    }
+
+    // one table, empty series print nothing
+    if (MEASURE_LATENCY || m_remoteLatency.getCount() > 0)
+    {
+        std::cout << "Input to first nonzero envelope output, OSC packets to the update that used them:" << std::endl;
+        LatencySeries::printHeader(std::cout);
+        m_mouseLatency.printSummary(std::cout);
+        m_keyLatency.printSummary(std::cout);
+        m_oscLatency.printSummary(std::cout);
+        m_remoteLatency.printSummary(std::cout);
     }
 }
 
 void AppManager::handleEvents()
 {
+    TRACE_SCOPE("AppManager::handleEvents");
+
     sf::Event event;
     while(m_window.pollEvent(event))
     {
+        // SFML events carry no time, taking it here is as early as it gets
+        std::int64_t eventTime = MEASURE_LATENCY ? getLatencyClock() : 0;
+
         if(event.type == sf::Event::Closed)
         {
             m_window.close();
         }
 
-        // sliders
-        m_attackSlider.handleEvent(event, m_window);
-        m_decaySlider.handleEvent(event, m_window);
-        m_sustainSlider.handleEvent(event, m_window);
-        m_releaseSlider.handleEvent(event, m_window);
+        // presets
+        if(event.type == sf::Event::KeyPressed && event.key.control)
+        {
+            if(event.key.code == sf::Keyboard::S)
+            {
+                savePreset("preset.envp");
+            }
+            else if(event.key.code == sf::Keyboard::O)
+            {
+                loadPreset("preset.envp");
+            }
+            else if(event.key.code == sf::Keyboard::T && TRACE_ENABLED)
+            {
+                if (Trace::isRunning())
+                {
+                    stopTrace();
+                }
+                else
+                {
+                    Trace::start();
+                    std::cout << "Tracing, ctrl+T again to stop" << std::endl;
+                }
+            }
+        }
+
+        if(event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3)
+        {
+            m_hud.toggle();
+        }
+
+        // space bar gate, key repeats ignored
+        if(event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Space && !m_isKeyGateOn)
+        {
+            m_isKeyGateOn = true;
+            markGateInput(m_keyLatency, eventTime);
+        }
+        else if(event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Space)
+        {
+            m_isKeyGateOn = false;
+        }
 
-        // knobs
-        m_attackSlopeKnob.handleEvent(event, m_window);
-        m_decaySlopeKnob.handleEvent(event, m_window);
-        m_releaseSlopeKnob.handleEvent(event, m_window);
+        // widgets
+        if (m_controlPanel.handleEvent(event, m_window))
+        {
+            markGateInput(m_mouseLatency, eventTime);
+        }
+    }
+}
+
+void AppManager::applyRemoteControl()
+{
+    TRACE_SCOPE("AppManager::applyRemoteControl");
 
-        // buttons
-        m_envelopeTypeButton.handleEvent(event, m_window);
-        m_loopButton.handleEvent(event, m_window);
-        m_trigButton.handleEvent(event, m_window);
-        m_resetButton.handleEvent(event, m_window);
+    ControlMessage message;
+    while (m_oscEndpoint.pop(message))
+    {
+        // messages of one packet share an arrival time
+        if (message.arrivalTime != m_lastRemoteArrival && m_pendingArrivals.size() < m_pendingArrivals.capacity())
+        {
+            m_pendingArrivals.push_back(message.arrivalTime);
+            m_lastRemoteArrival = message.arrivalTime;
+        }
+
+        switch (message.type)
+        {
+            case ControlMessage::GATE_ON:
+                m_isRemoteGateOn = true;
+                m_isRemoteTriggerPending = true;
+                markGateInput(m_oscLatency, message.arrivalTime);
+                break;
+            case ControlMessage::GATE_OFF:
+                m_isRemoteGateOn = false;
+                break;
+            case ControlMessage::RESET:
+                m_isRemoteGateOn = false;
+                m_isRemoteTriggerPending = false;
+                m_isRemoteResetPending = true;
+                break;
+            case ControlMessage::ENVELOPE_TYPE:
+                m_controlPanel.setEnvelopeType(static_cast<int>(message.value));
+                break;
+            case ControlMessage::LOOPING:
+                m_controlPanel.setLooping(message.value != 0.0f);
+                break;
+            case ControlMessage::PARAMETER:
+                m_controlPanel.setParameter(message.parameter, message.value);
+                break;
+        }
+    }
+}
+
+void AppManager::markGateInput(LatencySeries& series, std::int64_t time)
+{
+    // the latest gate on this frame wins
+    if (MEASURE_LATENCY)
+    {
+        m_gateInputSeries = &series;
+        m_gateInputTime = time;
     }
 }
 
 void AppManager::update()
 {
-    // sliders
-    m_envelope.setAttackTime(m_attackSlider.getValue());
-    m_envelope.setDecayTime(m_decaySlider.getValue());
-    m_envelope.setSustainLevel(m_sustainSlider.getValue());
-    m_envelope.setReleaseTime(m_releaseSlider.getValue());
+    TRACE_SCOPE("AppManager::update");
 
-    // knobs
-    m_envelope.setAttackCurve(m_attackSlopeKnob.getValue());
-    m_envelope.setDecayCurve(m_decaySlopeKnob.getValue());
-    m_envelope.setReleaseCurve(m_releaseSlopeKnob.getValue());
+    applyRemoteControl();
 
-    // buttons
-    m_envelope.setEnvelopeType(static_cast<Envelope::EnvelopeType>(m_envelopeTypeButton.getButtonState()));
-    m_envelope.setLooping(m_loopButton.isPressed());
+    // the space bar or an OSC gate is on, or an OSC gate went on and off
+    // again since the last frame
+    bool isRemoteTrigger = m_isRemoteGateOn || m_isRemoteTriggerPending;
+    m_isRemoteTriggerPending = false;
 
+    if (m_controlPanel.updateEnvelope(m_isKeyGateOn || isRemoteTrigger, m_isRemoteResetPending) &&
+        m_gateInputSeries != nullptr)
+    {
+        m_latencyProbe.markInput(*m_gateInputSeries, m_gateInputTime);
+    }
+    m_isRemoteResetPending = false;
 
+    float deltaTime = m_clock.restart().asSeconds();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+        TRACE_SCOPE("Envelope::update");
+        m_envelope.update(deltaTime);
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    m_envelopeUpdateTime = std::chrono::duration<float>(end - start).count();
 
+    m_controlPanel.updateVisualizer();
+    m_visualizerUpdateTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - end).count();
 
+    // a gate that didn't start a note this frame (the envelope was busy) isn't measured
+    m_gateInputSeries = nullptr;
 
-    // if the trigger button is pressed,
-    if (m_trigButton.isPressed()) 
+    if (MEASURE_LATENCY)
     {
-        // if the envelope is NOT active
-        if (!m_envelope.isActive())
-        {
-            // start an envelope
-            m_envelope.trigger();
-        }
+        m_latencyProbe.markOutput(m_envelope.getAmplitude(), getLatencyClock());
     }
-    // if the trigger button is NOT pressed,
-    else
+
+    // the first envelope output the packets had a hand in
+    if (!m_pendingArrivals.empty())
     {
-        // If trigger is NOT pressed, handle the release
-        // Check if envelope is in an active phase that allows for release
-        if (m_envelope.isActive() &&
-        (m_envelope.getPhase() == Envelope::Phase::ATTACK || 
-         m_envelope.getPhase() == Envelope::Phase::DECAY ||
-         m_envelope.getPhase() == Envelope::Phase::SUSTAIN))
+        std::int64_t now = getLatencyClock();
+
+        for (std::int64_t arrival : m_pendingArrivals)
         {
-            m_envelope.release();
+            m_remoteLatency.add(now - arrival);
         }
+        m_pendingArrivals.clear();
+    }
 
+    if (CvVoiceState* state = m_cvBus.beginFrame())
+    {
+        state->amplitude = m_envelope.getAmplitude();
+        state->progress = m_envelope.getProgress();
+        state->phase = static_cast<std::uint32_t>(m_envelope.getPhase());
+        m_cvBus.endFrame();
     }
+}
 
+void AppManager::savePreset(const std::string& path)
+{
+    PresetRecord preset = {};
+    preset.version = PRESET_RECORD_VERSION;
+    m_controlPanel.getPreset(preset);
+    preset.setName("default");
 
+    if (PresetLibrary::write(path, {preset}))
+    {
+        std::cout << "Saved preset to " << path << std::endl;
+    }
+}
+void AppManager::loadPreset(const std::string& path)
+{
+    PresetLibrary library;
+    if (!library.open(path) || library.getPresetCount() == 0)
+    {
+        return;
+    }
 
-    if (m_resetButton.isPressed()) 
+    // set the widgets, update() passes the values on to the envelope
+    const PresetRecord& preset = library.getPreset(0);
+    if (!preset.isValid())
     {
-        m_envelope.reset();
+        std::cerr << path << ": preset has an unknown version or envelope type" << std::endl;
+        return;
     }
 
-    float deltaTime = m_clock.restart().asSeconds();
-    m_envelope.update(deltaTime);
-    m_envelopeVisualizer.update(m_envelope);
+    m_controlPanel.setPreset(preset);
 
+    std::cout << "Loaded preset " << preset.getName() << " from " << path << std::endl;
 }
 
 void AppManager::render()
 {
-    m_window.clear();
+    TRACE_SCOPE("AppManager::render");
 
-    // draw sliders
-    m_attackSlider.draw(m_window);
-    m_decaySlider.draw(m_window);
-    m_sustainSlider.draw(m_window);
-    m_releaseSlider.draw(m_window);
+    m_window.clear();
 
-    // draw knobs
-    m_attackSlopeKnob.draw(m_window);
-    m_decaySlopeKnob.draw(m_window);
-    m_releaseSlopeKnob.draw(m_window);
+    m_controlPanel.draw(m_window);
 
-    // draw buttons
-    m_loopButton.draw(m_window);
-    m_envelopeTypeButton.draw(m_window);
-    m_trigButton.draw(m_window);
-    m_resetButton.draw(m_window);
+    // over everything else
+    m_hud.draw(m_window);
 
-    // draw envelope visualizer area
-    m_envelopeVisualizer.draw(m_window);
+    m_cpuTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_frameStart).count();
 
+    // waits for vsync when it's on
+    TRACE_SCOPE("display");
     m_window.display();
 }
 
+void AppManager::stopTrace()
+{
+    Trace::stop();
+    if (Trace::write("trace.json"))
+    {
+        std::cout << "Wrote " << Trace::getEventCount() << " trace events to trace.json";
+        if (Trace::getDroppedCount() > 0)
+        {
+            std::cout << " (" << Trace::getDroppedCount() << " dropped, buffers full)";
+        }
+        std::cout << std::endl;
+    }
+}
+
@@ -3,13 +3,18 @@
 #ifndef APP_MANAGER_HPP
 #define APP_MANAGER_HPP
 
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
 #include <SFML/Graphics.hpp>
 
-#include "slider.hpp"
-#include "knob.hpp"
-#include "button.hpp"
-#include "envelope_visualizer.hpp"
+#include "control_panel.hpp"
 #include "envelope_generator.hpp"
+#include "cv_bus.hpp"
+#include "osc_endpoint.hpp"
+#include "latency_probe.hpp"
+#include "hud_overlay.hpp"
 
 class AppManager
 {
@@ -24,26 +29,58 @@ class AppManager
         void update();
         void render();
 
+        // OSC messages set the widgets like a user would, so update() sees them
+        void applyRemoteControl();
+
+        // the input this frame's trigger came from, ENVELOPE_MEASURE_LATENCY builds only
+        void markGateInput(LatencySeries& series, std::int64_t time);
+
+        // ctrl+S / ctrl+O, single preset library next to the executable
+        void savePreset(const std::string& path);
+        void loadPreset(const std::string& path);
+
+        // ctrl+T in ENVELOPE_TRACE builds, trace.json next to the executable
+        void stopTrace();
+
         sf::RenderWindow m_window;
         sf::Clock m_clock;
 
         Envelope m_envelope;
 
-        Slider m_attackSlider;
-        Slider m_decaySlider;
-        Slider m_sustainSlider;
-        Slider m_releaseSlider;
+        // widgets and visualizer, envelope_bench_ui uses the same
+        ControlPanel m_controlPanel;
+
+        // the envelope for other processes, envelope_cv_reader shows it
+        CvBus m_cvBus;
+
+        // OSC input on localhost, see osc_endpoint.hpp
+        OscEndpoint m_oscEndpoint;
+        bool m_isRemoteGateOn;
+        bool m_isRemoteTriggerPending;  // a gate on that update() hasn't seen, it may be off again already
+        bool m_isRemoteResetPending;
+
+        // packet arrival to the envelope update that first used it
+        std::int64_t m_lastRemoteArrival;
+        std::vector<std::int64_t> m_pendingArrivals;    // reserved, this frame's packets
+        LatencySeries m_remoteLatency;
 
-        Knob m_attackSlopeKnob;
-        Knob m_decaySlopeKnob;
-        Knob m_releaseSlopeKnob;
+        // space bar gate
+        bool m_isKeyGateOn;
 
-        Button m_loopButton;
-        Button m_envelopeTypeButton;
-        Button m_trigButton;
-        Button m_resetButton;
+        // trigger to first nonzero output per input, see latency_probe.hpp
+        LatencySeries m_mouseLatency;
+        LatencySeries m_keyLatency;
+        LatencySeries m_oscLatency;
+        LatencyProbe m_latencyProbe;
+        LatencySeries* m_gateInputSeries;
+        std::int64_t m_gateInputTime;
 
-        EnvelopeVisualizer m_envelopeVisualizer;
+        // F3, frame times and render counters
+        HudOverlay m_hud;
+        std::chrono::steady_clock::time_point m_frameStart;
+        float m_cpuTime;                // frame start to display()
+        float m_envelopeUpdateTime;
+        float m_visualizerUpdateTime;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include "automation.hpp"
+#include "hash.hpp"
+#include "simd.hpp"
+
+namespace
+{
+    const char AUTOMATION_MAGIC[8] = {'E', 'N', 'V', 'A', 'U', 'T', 'O', 'M'};
+    const std::uint32_t AUTOMATION_FORMAT_VERSION = 1;
+
+    const int PARAMETER_COUNT = static_cast<int>(AutomationParameter::COUNT);
+
+    const char* PARAMETER_NAMES[PARAMETER_COUNT] = {"attackTime", "attackCurve", "decayTime", "decayCurve",
+                                                    "sustainLevel", "releaseTime", "releaseCurve"};
+
+    struct AutomationHeader
+    {
+        char magic[8];
+        std::uint32_t formatVersion;
+        std::uint32_t laneCount;
+    };
+
+    struct LaneHeader
+    {
+        std::uint8_t parameter;
+        std::uint8_t reserved[3];
+        std::uint32_t pointCount;
+    };
+
+    static_assert(sizeof(AutomationHeader) == 16, "AutomationHeader layout is part of the file format");
+    static_assert(sizeof(LaneHeader) == 8, "LaneHeader layout is part of the file format");
+
+    std::uint64_t secondsToSamples(double seconds, float sampleRate)
+    {
+        return static_cast<std::uint64_t>(std::llround(std::max(seconds, 0.0) * sampleRate));
+    }
+
+    template <typename T>
+    bool readValue(std::istream& in, T& value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+
+    template <typename T>
+    void writeValue(std::ostream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    std::uint64_t getBytesLeft(std::istream& in)
+    {
+        std::streampos position = in.tellg();
+        in.seekg(0, std::ios::end);
+        std::streampos end = in.tellg();
+        in.seekg(position);
+        return (position >= 0 && end > position) ? static_cast<std::uint64_t>(end - position) : 0;
+    }
+
+    void sortPoints(std::vector<AutomationLane>& lanes)
+    {
+        for (AutomationLane& lane : lanes)
+        {
+            std::stable_sort(lane.points.begin(), lane.points.end(),
+                [](const AutomationPoint& a, const AutomationPoint& b) { return a.sample < b.sample; });
+        }
+    }
+
+    bool loadBinary(std::istream& file, const std::string& path, float sampleRate, std::vector<AutomationLane>& lanes)
+    {
+        AutomationHeader header;
+        if (!readValue(file, header) || header.formatVersion != AUTOMATION_FORMAT_VERSION)
+        {
+            std::cerr << "Unsupported automation file " << path << std::endl;
+            return false;
+        }
+
+        for (std::uint32_t i = 0; i < header.laneCount; i++)
+        {
+            LaneHeader laneHeader;
+            if (!readValue(file, laneHeader) || laneHeader.parameter >= PARAMETER_COUNT)
+            {
+                std::cerr << "Corrupt automation lane in " << path << std::endl;
+                return false;
+            }
+
+            // a count from a corrupt header could ask for gigabytes, check it against the file first
+            const std::uint64_t pointSize = sizeof(double) + sizeof(float);
+            if (laneHeader.pointCount > getBytesLeft(file) / pointSize)
+            {
+                std::cerr << "Truncated automation file " << path << std::endl;
+                return false;
+            }
+
+            AutomationLane lane{static_cast<AutomationParameter>(laneHeader.parameter), {}};
+            lane.points.reserve(laneHeader.pointCount);
+
+            for (std::uint32_t point = 0; point < laneHeader.pointCount; point++)
+            {
+                double seconds = 0.0;
+                float value = 0.0f;
+                if (!readValue(file, seconds) || !readValue(file, value))
+                {
+                    std::cerr << "Truncated automation file " << path << std::endl;
+                    return false;
+                }
+                lane.points.push_back({secondsToSamples(seconds, sampleRate), value});
+            }
+
+            lanes.push_back(std::move(lane));
+        }
+        return true;
+    }
+
+    bool loadCsv(std::istream& file, const std::string& path, float sampleRate, std::vector<AutomationLane>& lanes)
+    {
+        int laneIndex[PARAMETER_COUNT];
+        std::fill(laneIndex, laneIndex + PARAMETER_COUNT, -1);
+
+        std::string line;
+        int lineNumber = 0;
+
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+
+            std::replace(line.begin(), line.end(), ',', ' ');
+            std::istringstream fields(line);
+
+            std::string name;
+            double seconds = 0.0;
+            float value = 0.0f;
+
+            if (!(fields >> name) || name[0] == '#')
+            {
+                continue;   // blank line or comment
+            }
+
+            AutomationParameter found;
+            if (!findAutomationParameter(name.c_str(), found))
+            {
+                std::cerr << path << ":" << lineNumber << ": unknown parameter " << name << std::endl;
+                return false;
+            }
+            int parameter = static_cast<int>(found);
+            if (!(fields >> seconds >> value))
+            {
+                std::cerr << path << ":" << lineNumber << ": expected <parameter>,<time>,<value>" << std::endl;
+                return false;
+            }
+
+            if (laneIndex[parameter] < 0)
+            {
+                laneIndex[parameter] = static_cast<int>(lanes.size());
+                lanes.push_back({static_cast<AutomationParameter>(parameter), {}});
+            }
+            lanes[laneIndex[parameter]].points.push_back({secondsToSamples(seconds, sampleRate), value});
+        }
+        return true;
+    }
+
+    // out[i] = start + step * i
+    void fillRamp(float* out, int count, float start, float step)
+    {
+        int i = 0;
+#ifdef ENVELOPE_SSE2
+        __m128 starts = _mm_set1_ps(start);
+        __m128 steps = _mm_set1_ps(step);
+        __m128 offsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 indices = _mm_add_ps(offsets, _mm_set1_ps(static_cast<float>(i)));
+            _mm_storeu_ps(out + i, _mm_add_ps(starts, _mm_mul_ps(indices, steps)));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            out[i] = start + static_cast<float>(i) * step;
+        }
+    }
+}
+
+bool loadAutomation(const std::string& path, float sampleRate, std::vector<AutomationLane>& lanes)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open automation " << path << std::endl;
+        return false;
+    }
+
+    char magic[sizeof(AUTOMATION_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    bool isBinary = file && std::memcmp(magic, AUTOMATION_MAGIC, sizeof(AUTOMATION_MAGIC)) == 0;
+
+    file.clear();
+    file.seekg(0);
+
+    lanes.clear();
+    bool loaded = isBinary ? loadBinary(file, path, sampleRate, lanes) : loadCsv(file, path, sampleRate, lanes);
+
+    if (!loaded)
+    {
+        lanes.clear();
+        return false;
+    }
+
+    // one lane per parameter, the player relies on it
+    bool isUsed[PARAMETER_COUNT] = {};
+    for (const AutomationLane& lane : lanes)
+    {
+        int parameter = static_cast<int>(lane.parameter);
+        if (isUsed[parameter])
+        {
+            std::cerr << path << ": more than one lane for " << PARAMETER_NAMES[parameter] << std::endl;
+            lanes.clear();
+            return false;
+        }
+        isUsed[parameter] = true;
+    }
+
+    sortPoints(lanes);
+    return true;
+}
+
+bool saveAutomation(const std::string& path, float sampleRate, const std::vector<AutomationLane>& lanes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    AutomationHeader header;
+    std::memcpy(header.magic, AUTOMATION_MAGIC, sizeof(AUTOMATION_MAGIC));
+    header.formatVersion = AUTOMATION_FORMAT_VERSION;
+    header.laneCount = static_cast<std::uint32_t>(lanes.size());
+    writeValue(file, header);
+
+    for (const AutomationLane& lane : lanes)
+    {
+        LaneHeader laneHeader = {static_cast<std::uint8_t>(lane.parameter), {0, 0, 0},
+                                 static_cast<std::uint32_t>(lane.points.size())};
+        writeValue(file, laneHeader);
+
+        // field by field, a struct would be padded to 16 bytes
+        for (const AutomationPoint& point : lane.points)
+        {
+            writeValue(file, static_cast<double>(point.sample) / sampleRate);
+            writeValue(file, point.value);
+        }
+    }
+
+    if (!file)
+    {
+        std::cerr << "Failed to write automation " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t hashAutomation(const std::vector<AutomationLane>& lanes, std::uint64_t hash)
+{
+    for (const AutomationLane& lane : lanes)
+    {
+        hash = fnv1a64(&lane.parameter, sizeof(lane.parameter), hash);
+        for (const AutomationPoint& point : lane.points)
+        {
+            hash = fnv1a64(&point.sample, sizeof(point.sample), hash);
+            hash = fnv1a64(&point.value, sizeof(point.value), hash);
+        }
+    }
+    return hash;
+}
+
+bool findAutomationParameter(const char* name, AutomationParameter& parameter)
+{
+    for (int i = 0; i < PARAMETER_COUNT; i++)
+    {
+        if (std::strcmp(name, PARAMETER_NAMES[i]) == 0)
+        {
+            parameter = static_cast<AutomationParameter>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// player
+
+AutomationPlayer::AutomationPlayer(const std::vector<AutomationLane>& lanes)
+: m_buffers(lanes.size() * MAX_BLOCK_SIZE)
+, m_position(0)
+{
+    for (const AutomationLane& lane : lanes)
+    {
+        if (lane.points.empty())
+        {
+            continue;
+        }
+
+        float* buffer = m_buffers.data() + m_cursors.size() * MAX_BLOCK_SIZE;
+        m_cursors.push_back({&lane, 0, buffer});
+
+        switch (lane.parameter)
+        {
+            case AutomationParameter::ATTACK_TIME:
+                m_modulation.attackTime = buffer;
+                break;
+            case AutomationParameter::ATTACK_CURVE:
+                m_modulation.attackCurve = buffer;
+                break;
+            case AutomationParameter::DECAY_TIME:
+                m_modulation.decayTime = buffer;
+                break;
+            case AutomationParameter::DECAY_CURVE:
+                m_modulation.decayCurve = buffer;
+                break;
+            case AutomationParameter::SUSTAIN_LEVEL:
+                m_modulation.sustainLevel = buffer;
+                break;
+            case AutomationParameter::RELEASE_TIME:
+                m_modulation.releaseTime = buffer;
+                break;
+            case AutomationParameter::RELEASE_CURVE:
+                m_modulation.releaseCurve = buffer;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void AutomationPlayer::seek(std::uint64_t sample)
+{
+    m_position = sample;
+
+    for (Cursor& cursor : m_cursors)
+    {
+        const std::vector<AutomationPoint>& points = cursor.lane->points;
+        auto next = std::upper_bound(points.begin(), points.end(), sample,
+            [](std::uint64_t position, const AutomationPoint& point) { return position < point.sample; });
+
+        cursor.index = (next == points.begin()) ? 0 : static_cast<std::size_t>(next - points.begin()) - 1;
+    }
+}
+
+std::uint64_t AutomationPlayer::getPosition() const
+{
+    return m_position;
+}
+
+const Envelope::Modulation& AutomationPlayer::renderBlock(int numSamples)
+{
+    numSamples = std::min(numSamples, MAX_BLOCK_SIZE);
+
+    for (Cursor& cursor : m_cursors)
+    {
+        renderLane(cursor, numSamples);
+    }
+
+    m_position += numSamples;
+    return m_modulation;
+}
+
+void AutomationPlayer::renderLane(Cursor& cursor, int numSamples)
+{
+    const std::vector<AutomationPoint>& points = cursor.lane->points;
+    int filled = 0;
+
+    while (filled < numSamples)
+    {
+        std::uint64_t position = m_position + filled;
+
+        // only ever moves forward, one step per breakpoint passed
+        while (cursor.index + 1 < points.size() && points[cursor.index + 1].sample <= position)
+        {
+            cursor.index++;
+        }
+
+        const AutomationPoint& from = points[cursor.index];
+        bool isBeforeFirst = position < from.sample;
+        bool isAfterLast = cursor.index + 1 == points.size();
+
+        if (isBeforeFirst || isAfterLast)
+        {
+            // held at the end value up to the first point, or for good after the last
+            std::uint64_t holdEnd = isBeforeFirst ? from.sample : std::numeric_limits<std::uint64_t>::max();
+            int count = static_cast<int>(std::min<std::uint64_t>(numSamples - filled, holdEnd - position));
+
+            std::fill(cursor.buffer + filled, cursor.buffer + filled + count, from.value);
+            filled += count;
+            continue;
+        }
+
+        const AutomationPoint& to = points[cursor.index + 1];
+        int count = static_cast<int>(std::min<std::uint64_t>(numSamples - filled, to.sample - position));
+
+        double slope = (static_cast<double>(to.value) - from.value) / static_cast<double>(to.sample - from.sample);
+
+        if (cursor.lane->parameter == AutomationParameter::SUSTAIN_LEVEL)
+        {
+            float start = static_cast<float>(from.value + slope * static_cast<double>(position - from.sample));
+            fillRamp(cursor.buffer + filled, count, start, static_cast<float>(slope));
+            filled += count;
+            continue;
+        }
+
+        // held at the ramp's value where the step starts, the breakpoint or the interval boundary after it
+        std::uint64_t intervalStart = position - position % CONTROL_INTERVAL;
+        std::uint64_t stepStart = std::max(from.sample, intervalStart);
+        count = static_cast<int>(std::min<std::uint64_t>(count, intervalStart + CONTROL_INTERVAL - position));
+
+        float value = static_cast<float>(from.value + slope * static_cast<double>(stepStart - from.sample));
+        std::fill(cursor.buffer + filled, cursor.buffer + filled + count, value);
+        filled += count;
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef AUTOMATION_HPP
+#define AUTOMATION_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envelope_generator.hpp"
+
+/*
+    Breakpoint automation for envelope parameters in offline renders.
+
+    A lane is a list of (sample, value) breakpoints for one parameter,
+    values are in the units the setters take and are interpolated
+    linearly in between. Before the first and after the last breakpoint
+    the lane holds its end value.
+
+    Lanes load from either format, told apart by the header:
+
+    CSV, one breakpoint per line, times in seconds:
+
+        <parameter>,<time>,<value>
+
+        parameter is one of attackTime, attackCurve, decayTime, decayCurve,
+        sustainLevel, releaseTime, releaseCurve. Blank lines and lines
+        starting with # are ignored.
+
+    Binary (saveAutomation()): a header, then per lane a parameter and a
+    point count followed by (float64 seconds, float32 value) pairs.
+
+    AutomationPlayer walks the lanes one block at a time and hands out
+    the block as Envelope::Modulation buffers. Each lane keeps a cursor,
+    so a block costs the same however long the lanes are.
+
+    Ramps on time and curve lanes move in steps of CONTROL_INTERVAL
+    samples, counted from the start of the timeline, each step holding
+    the ramp's value where it starts. The envelope only sets up a segment
+    again when a buffer changes, so held steps render as runs, where a
+    smooth ramp would change every sample and go sample by sample.
+    Sustain level ramps stay smooth, while sustaining they are the output.
+*/
+
+enum class AutomationParameter : std::uint8_t
+{
+    ATTACK_TIME,
+    ATTACK_CURVE,
+    DECAY_TIME,
+    DECAY_CURVE,
+    SUSTAIN_LEVEL,
+    RELEASE_TIME,
+    RELEASE_CURVE,
+    COUNT
+};
+
+struct AutomationPoint
+{
+    std::uint64_t sample;
+    float value;
+};
+
+struct AutomationLane
+{
+    AutomationParameter parameter;
+    std::vector<AutomationPoint> points;    // sorted by sample
+};
+
+// replaces lanes, at most one lane per parameter
+bool loadAutomation(const std::string& path, float sampleRate, std::vector<AutomationLane>& lanes);
+bool saveAutomation(const std::string& path, float sampleRate, const std::vector<AutomationLane>& lanes);
+
+std::uint64_t hashAutomation(const std::vector<AutomationLane>& lanes, std::uint64_t hash);
+
+// by the names the CSV format uses, false for anything else
+bool findAutomationParameter(const char* name, AutomationParameter& parameter);
+
+class AutomationPlayer
+{
+    public:
+        static constexpr int MAX_BLOCK_SIZE = 256;
+        static constexpr int CONTROL_INTERVAL = 32;     // samples per step of a time or curve ramp
+
+        explicit AutomationPlayer(const std::vector<AutomationLane>& lanes);
+
+        void seek(std::uint64_t sample);    // the only place lanes get searched
+        std::uint64_t getPosition() const;
+
+        // values for the next numSamples (up to MAX_BLOCK_SIZE) samples, then moves on
+        const Envelope::Modulation& renderBlock(int numSamples);
+
+    private:
+        struct Cursor
+        {
+            const AutomationLane* lane;
+            std::size_t index;          // last point at or before the position
+            float* buffer;
+        };
+
+        void renderLane(Cursor& cursor, int numSamples);
+
+        std::vector<Cursor> m_cursors;
+        std::vector<float> m_buffers;
+        Envelope::Modulation m_modulation;
+        std::uint64_t m_position;
+};
+
+#endif // AUTOMATION_HPP
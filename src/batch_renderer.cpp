@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "batch_renderer.hpp"
+#include "segment_codec.hpp"
+#include "wav_writer.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // keep file names portable
+    std::string sanitize(const std::string& name)
+    {
+        std::string result = name;
+        for (char& c : result)
+        {
+            bool isSafe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                          (c >= '0' && c <= '9') || c == '-' || c == '_';
+            if (!isSafe)
+            {
+                c = '_';
+            }
+        }
+        return result;
+    }
+}
+
+BatchRenderer::BatchRenderer(const PresetLibrary& presets, const std::vector<GateTimeline>& timelines,
+                             const std::vector<AutomationLane>& automation, const BatchSettings& settings)
+: m_presets(presets)
+, m_timelines(timelines)
+, m_automation(automation)
+, m_settings(settings)
+, m_nextTask(0)
+, m_completedJobs(0)
+, m_threadsUsed(0)
+, m_wallSeconds(0.0)
+{
+}
+
+std::size_t BatchRenderer::getJobCount() const
+{
+    return m_presets.getPresetCount() * m_timelines.size();
+}
+const std::vector<BatchJobResult>& BatchRenderer::getResults() const
+{
+    return m_results;
+}
+
+bool BatchRenderer::run()
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_settings.outputDirectory, error);
+    if (error)
+    {
+        std::cerr << "Cannot create " << m_settings.outputDirectory << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    if (!m_settings.cacheDirectory.empty())
+    {
+        m_cache = std::make_unique<RenderCache>(m_settings.cacheDirectory, m_settings.cacheMaxBytes);
+    }
+
+    std::size_t jobCount = getJobCount();
+
+    Clock::time_point start = Clock::now();
+
+    m_results.assign(jobCount, BatchJobResult());
+    m_nextTask = 0;
+    m_completedJobs = 0;
+    planTasks();
+
+    m_threadsUsed = m_settings.threadCount > 0 ? m_settings.threadCount : std::thread::hardware_concurrency();
+    m_threadsUsed = std::max(1u, std::min<unsigned int>(m_threadsUsed, static_cast<unsigned int>(std::max<std::size_t>(m_tasks.size(), 1))));
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < m_threadsUsed; i++)
+    {
+        workers.emplace_back(&BatchRenderer::workerLoop, this);
+    }
+
+    // progress from the calling thread while the pool works
+    while (m_settings.showProgress && m_completedJobs < jobCount)
+    {
+        std::size_t completed = m_completedJobs;
+        std::cout << "\rRendered " << completed << " / " << jobCount << " jobs ("
+                  << (100 * completed / jobCount) << "%)" << std::flush;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    m_wallSeconds = secondsSince(start);
+
+    if (m_settings.showProgress)
+    {
+        std::cout << "\rRendered " << jobCount << " / " << jobCount << " jobs (100%)" << std::endl;
+    }
+
+    return std::all_of(m_results.begin(), m_results.end(), [](const BatchJobResult& r) { return r.succeeded; });
+}
+
+void BatchRenderer::planTasks()
+{
+    std::uint64_t chunkSamples = static_cast<std::uint64_t>(std::llround(std::max(m_settings.chunkSeconds, 0.0) * m_settings.sampleRate));
+
+    m_tasks.clear();
+    m_chunkedJobs.clear();
+    m_chunkedJobs.resize(m_results.size());
+
+    for (std::size_t job = 0; job < m_results.size(); job++)
+    {
+        BatchJobResult& result = m_results[job];
+        result.presetIndex = job / m_timelines.size();
+        result.timelineIndex = job % m_timelines.size();
+
+        const GateTimeline& timeline = m_timelines[result.timelineIndex];
+
+        const PresetRecord& preset = m_presets.getPreset(result.presetIndex);
+        if (!preset.isValid())
+        {
+            std::cerr << "Preset " << preset.getName() << " has an unknown version or envelope type, skipped" << std::endl;
+            m_completedJobs++;  // failed before it started
+            continue;
+        }
+
+        bool isLong = chunkSamples > 0 && timeline.lengthSamples > chunkSamples && m_automation.empty() && !m_settings.writeSegments;
+        if (!isLong)
+        {
+            m_tasks.push_back(Task{job, 0, timeline.lengthSamples, nullptr});
+            continue;
+        }
+
+        // a long job that's cached is just read back, look it up now so it isn't split for nothing
+        auto chunked = std::make_unique<ChunkedJob>();
+
+        if (m_cache)
+        {
+            Envelope envelope;
+            setupEnvelope(envelope, result.presetIndex);
+            chunked->cacheKey = RenderCache::makeKey(envelope, timeline, m_automation, m_settings.sampleRate);
+
+            auto cached = std::make_unique<CachedRender>();
+            if (m_cache->lookup(chunked->cacheKey, *cached) && cached->getSampleCount() == timeline.lengthSamples)
+            {
+                m_tasks.push_back(Task{job, 0, timeline.lengthSamples, std::move(cached)});
+                continue;
+            }
+        }
+
+        chunked->samples = createMappedWavFile(chunked->file, getOutputPath(result.presetIndex, result.timelineIndex),
+                                               timeline.lengthSamples, 1, static_cast<unsigned int>(m_settings.sampleRate));
+        if (chunked->samples == nullptr)
+        {
+            m_completedJobs++;  // failed before it started
+            continue;
+        }
+
+        result.chunkCount = static_cast<std::size_t>((timeline.lengthSamples + chunkSamples - 1) / chunkSamples);
+        chunked->firstTask = m_tasks.size();
+        chunked->chunksLeft = result.chunkCount;
+
+        for (std::uint64_t begin = 0; begin < timeline.lengthSamples; begin += chunkSamples)
+        {
+            m_tasks.push_back(Task{job, begin, std::min(begin + chunkSamples, timeline.lengthSamples), nullptr});
+        }
+        m_chunkedJobs[job] = std::move(chunked);
+    }
+}
+
+void BatchRenderer::workerLoop()
+{
+    for (std::size_t index = m_nextTask++; index < m_tasks.size(); index = m_nextTask++)
+    {
+        Task& task = m_tasks[index];
+
+        if (m_chunkedJobs[task.jobIndex])
+        {
+            renderChunk(task);
+        }
+        else
+        {
+            renderJob(task);
+            m_completedJobs++;
+        }
+    }
+}
+
+void BatchRenderer::setupEnvelope(Envelope& envelope, std::size_t presetIndex) const
+{
+    m_presets.getPreset(presetIndex).applyTo(envelope);
+    envelope.setSilenceThreshold(m_settings.silenceThreshold);
+    envelope.setTimingMode(Envelope::TimingMode::SAMPLE_COUNT);     // the same samples however the timeline splits blocks
+}
+
+void BatchRenderer::renderJob(Task& task)
+{
+    BatchJobResult& result = m_results[task.jobIndex];
+    const GateTimeline& timeline = m_timelines[result.timelineIndex];
+    std::string path = getOutputPath(result.presetIndex, result.timelineIndex);
+    unsigned int sampleRate = static_cast<unsigned int>(m_settings.sampleRate);
+
+    Clock::time_point renderStart = Clock::now();
+
+    Envelope envelope;
+    setupEnvelope(envelope, result.presetIndex);
+    result.numSamples = timeline.lengthSamples;
+
+    if (m_settings.writeSegments)
+    {
+        EncodedEnvelope encoded;
+        encodeGateTimeline(envelope, timeline, m_settings.sampleRate, encoded);
+        result.skippedSamples = envelope.getSkippedSampleCount();
+        result.encodedBytes = getEncodedSize(encoded);
+        result.renderSeconds = secondsSince(renderStart);
+
+        Clock::time_point writeStart = Clock::now();
+        result.succeeded = saveEncodedEnvelope(getOutputPath(result.presetIndex, result.timelineIndex, ".envs"), encoded);
+        result.writeSeconds = secondsSince(writeStart);
+        return;
+    }
+
+    // a cache hit is used straight from the mapped file
+    CachedRender cached;
+    std::uint64_t key = 0;
+
+    if (task.cached)
+    {
+        result.wasCached = true;    // found while planning
+    }
+    else if (m_cache)
+    {
+        key = RenderCache::makeKey(envelope, timeline, m_automation, m_settings.sampleRate);
+        result.wasCached = m_cache->lookup(key, cached) && cached.getSampleCount() == timeline.lengthSamples;
+    }
+
+    if (result.wasCached)
+    {
+        const float* samples = task.cached ? task.cached->getSamples() : cached.getSamples();
+        result.renderSeconds = secondsSince(renderStart);
+
+        Clock::time_point writeStart = Clock::now();
+        result.succeeded = writeWavFile(path, samples, timeline.lengthSamples, 1, sampleRate);
+        result.writeSeconds = secondsSince(writeStart);
+
+        task.cached.reset();
+        return;
+    }
+
+    // a fresh render goes straight into the mapped output file, no buffer to copy out of
+    Clock::time_point createStart = Clock::now();
+    MappedFile file;
+    float* samples = createMappedWavFile(file, path, timeline.lengthSamples, 1, sampleRate);
+    result.writeSeconds = secondsSince(createStart);
+
+    if (samples == nullptr)
+    {
+        return;
+    }
+
+    renderGateTimeline(envelope, timeline, m_settings.sampleRate, samples, m_automation);
+    result.skippedSamples = envelope.getSkippedSampleCount();
+
+    if (m_cache)
+    {
+        m_cache->store(key, samples, timeline.lengthSamples);
+    }
+    result.renderSeconds = secondsSince(renderStart) - result.writeSeconds;
+
+    Clock::time_point writeStart = Clock::now();
+    result.succeeded = file.flush(m_settings.waitForDisk);
+    file.close();
+    result.writeSeconds += secondsSince(writeStart);
+}
+
+void BatchRenderer::renderChunk(Task& task)
+{
+    ChunkedJob& chunked = *m_chunkedJobs[task.jobIndex];
+    const BatchJobResult& result = m_results[task.jobIndex];
+
+    Clock::time_point renderStart = Clock::now();
+
+    Envelope envelope;
+    setupEnvelope(envelope, result.presetIndex);
+    task.skippedSamples = renderGateTimelineRange(envelope, m_timelines[result.timelineIndex], m_settings.sampleRate,
+                                                  task.begin, task.end, chunked.samples + task.begin);
+
+    task.renderSeconds = secondsSince(renderStart);
+
+    // the decrement publishes this chunk's samples and timings to whoever finishes the job
+    if (--chunked.chunksLeft == 0)
+    {
+        finishChunkedJob(task.jobIndex);
+        m_completedJobs++;
+    }
+}
+
+void BatchRenderer::finishChunkedJob(std::size_t jobIndex)
+{
+    ChunkedJob& chunked = *m_chunkedJobs[jobIndex];
+    BatchJobResult& result = m_results[jobIndex];
+    const GateTimeline& timeline = m_timelines[result.timelineIndex];
+
+    for (std::size_t i = 0; i < result.chunkCount; i++)
+    {
+        const Task& chunk = m_tasks[chunked.firstTask + i];
+        result.renderSeconds += chunk.renderSeconds;
+        result.skippedSamples += chunk.skippedSamples;
+    }
+    result.numSamples = timeline.lengthSamples;
+
+    if (m_cache)
+    {
+        m_cache->store(chunked.cacheKey, chunked.samples, timeline.lengthSamples);
+    }
+
+    // the samples are already in the file, writing is getting them to disk
+    Clock::time_point writeStart = Clock::now();
+
+    result.succeeded = chunked.file.flush(m_settings.waitForDisk);
+    chunked.file.close();
+    result.writeSeconds = secondsSince(writeStart);
+}
+
+std::string BatchRenderer::getOutputPath(std::size_t presetIndex, std::size_t timelineIndex, const char* extension) const
+{
+    // the preset index keeps names unique when presets share a name
+    std::ostringstream name;
+    name << std::setw(6) << std::setfill('0') << presetIndex << "_"
+         << sanitize(m_presets.getPreset(presetIndex).getName()) << "_"
+         << sanitize(m_timelines[timelineIndex].name) << extension;
+
+    return (std::filesystem::path(m_settings.outputDirectory) / name.str()).string();
+}
+
+void BatchRenderer::printSummary(std::ostream& out) const
+{
+    std::uint64_t totalSamples = 0;
+    double renderSeconds = 0.0;
+    double writeSeconds = 0.0;
+    std::uint64_t skippedSamples = 0;
+    std::size_t failed = 0;
+    std::size_t chunkedJobs = 0;
+    std::size_t chunks = 0;
+    std::uint64_t encodedBytes = 0;
+    std::vector<double> jobThroughput;   // samples per second, render only
+
+    for (const BatchJobResult& result : m_results)
+    {
+        totalSamples += result.numSamples;
+        renderSeconds += result.renderSeconds;
+        writeSeconds += result.writeSeconds;
+        skippedSamples += result.skippedSamples;
+        failed += result.succeeded ? 0 : 1;
+        encodedBytes += result.encodedBytes;
+
+        if (result.chunkCount > 1)
+        {
+            chunkedJobs++;
+            chunks += result.chunkCount;
+        }
+
+        if (result.renderSeconds > 0.0)
+        {
+            jobThroughput.push_back(result.numSamples / result.renderSeconds);
+        }
+    }
+    std::sort(jobThroughput.begin(), jobThroughput.end());
+
+    double megabytes = totalSamples * sizeof(float) / (1024.0 * 1024.0);
+
+    out << std::fixed << std::setprecision(2);
+    out << "Jobs:            " << m_results.size() << " (" << failed << " failed) on "
+        << m_threadsUsed << " threads\n";
+    out << "Samples:         " << totalSamples << " (" << megabytes << " MB)\n";
+    out << "Wall time:       " << m_wallSeconds << " s\n";
+
+    if (m_wallSeconds > 0.0)
+    {
+        out << "Throughput:      " << totalSamples / m_wallSeconds / 1e6 << " Msamples/s, "
+            << megabytes / m_wallSeconds << " MB/s\n";
+    }
+    if (renderSeconds > 0.0)
+    {
+        out << "Render:          " << totalSamples / renderSeconds / 1e6 << " Msamples/s per thread\n";
+    }
+    if (writeSeconds > 0.0)
+    {
+        out << "Write:           " << megabytes / writeSeconds << " MB/s per thread"
+            << (m_settings.waitForDisk ? " (to disk)\n" : " (to the page cache, --sync waits for the disk)\n");
+    }
+    if (!jobThroughput.empty())
+    {
+        out << "Per job (Msamples/s): min " << jobThroughput.front() / 1e6
+            << ", median " << jobThroughput[jobThroughput.size() / 2] / 1e6
+            << ", max " << jobThroughput.back() / 1e6 << "\n";
+    }
+    if (encodedBytes > 0)
+    {
+        out << "Segment files:   " << encodedBytes / 1024.0 << " KB, " << totalSamples * sizeof(float) / static_cast<double>(encodedBytes)
+            << "x smaller than the samples\n";
+    }
+    if (chunkedJobs > 0)
+    {
+        out << "Chunked:         " << chunkedJobs << " jobs in " << chunks << " chunks\n";
+    }
+    if (skippedSamples > 0)
+    {
+        out << "Silent tails:    " << skippedSamples << " samples skipped\n";
+    }
+    if (m_cache)
+    {
+        out << "Render cache:    " << m_cache->getHitCount() << " hits, " << m_cache->getMissCount() << " misses, "
+            << m_cache->getSizeBytes() / (1024.0 * 1024.0) << " MB on disk\n";
+    }
+    out.flush();
+}
@@ -0,0 +1,129 @@
+#ifndef BATCH_RENDERER_HPP
+#define BATCH_RENDERER_HPP
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "automation.hpp"
+#include "gate_timeline.hpp"
+#include "preset.hpp"
+#include "render_cache.hpp"
+
+/*
+    Renders every preset in a library against every gate timeline
+    and writes each combination to its own WAV file.
+
+    Jobs are handed out to a pool of worker threads. Every job uses its
+    own Envelope and nothing else is shared, so the files are identical
+    whatever the thread count. With a cache directory set, renders that
+    were done before are read back from the RenderCache instead.
+
+    Fresh renders go straight into their memory-mapped WAV file and the
+    kernel writes it out in the background, unless waitForDisk asks to
+    wait for it. Over 4 GB the files are RF64 (see wav_writer.hpp).
+    With writeSegments the jobs are encoded as segments instead, which
+    takes no rendering and a tiny fraction of the space.
+
+    With chunkSeconds set, a longer timeline is split into chunks that
+    are handed out like jobs. Every chunk brings a fresh Envelope up to
+    its start with Envelope::advance() and renders straight into its place
+    in the memory-mapped WAV file, so one long render uses every thread
+    and still writes the same bytes. Jobs with automation stay whole, the
+    parameters at a chunk start depend on everything before it.
+*/
+
+struct BatchSettings
+{
+    std::string outputDirectory = ".";
+    float sampleRate = 48000.f;
+    unsigned int threadCount = 0;   // 0 = one per hardware thread
+    bool showProgress = true;
+    float silenceThreshold = -INFINITY;     // dBFS, see Envelope::setSilenceThreshold()
+    double chunkSeconds = 0.0;              // split longer renders into chunks for several threads, 0 = never
+    bool waitForDisk = false;               // a job is done once its file is on disk, not just queued for it
+    bool writeSegments = false;             // .envs segment files (segment_codec.hpp) instead of WAVs, no automation
+
+    std::string cacheDirectory;     // empty = no render cache
+    std::uint64_t cacheMaxBytes = 1ull << 30;
+};
+
+struct BatchJobResult
+{
+    std::size_t presetIndex = 0;
+    std::size_t timelineIndex = 0;
+    std::uint64_t numSamples = 0;
+    double renderSeconds = 0.0;
+    double writeSeconds = 0.0;
+    std::uint64_t skippedSamples = 0;
+    std::size_t chunkCount = 1;
+    std::uint64_t encodedBytes = 0;         // segment files only
+    bool wasCached = false;
+    bool succeeded = false;
+};
+
+class BatchRenderer
+{
+    public:
+        BatchRenderer(const PresetLibrary& presets, const std::vector<GateTimeline>& timelines,
+                      const std::vector<AutomationLane>& automation, const BatchSettings& settings);
+
+        bool run();     // false if any job failed
+        void printSummary(std::ostream& out) const;
+
+        std::size_t getJobCount() const;
+        const std::vector<BatchJobResult>& getResults() const;
+
+    private:
+        // what a worker picks up: a whole job, or one chunk of a long one
+        struct Task
+        {
+            std::size_t jobIndex;
+            std::uint64_t begin;    // chunks only, the range of the timeline
+            std::uint64_t end;
+            std::unique_ptr<CachedRender> cached;   // whole jobs looked up while planning
+
+            double renderSeconds = 0.0;     // chunks only, written by the worker that ran it
+            std::uint64_t skippedSamples = 0;
+        };
+
+        // a job split into chunks, rendered straight into its mapped WAV file
+        struct ChunkedJob
+        {
+            MappedFile file;
+            float* samples = nullptr;
+            std::uint64_t cacheKey = 0;
+            std::size_t firstTask = 0;
+            std::atomic<std::size_t> chunksLeft{0};
+        };
+
+        void planTasks();
+        void workerLoop();
+        void setupEnvelope(Envelope& envelope, std::size_t presetIndex) const;
+        void renderJob(Task& task);
+        void renderChunk(Task& task);
+        void finishChunkedJob(std::size_t jobIndex);     // by whichever worker rendered the last chunk
+        std::string getOutputPath(std::size_t presetIndex, std::size_t timelineIndex, const char* extension = ".wav") const;
+
+        const PresetLibrary& m_presets;
+        const std::vector<GateTimeline>& m_timelines;
+        const std::vector<AutomationLane>& m_automation;   // applied to every job, may be empty
+        BatchSettings m_settings;
+        std::unique_ptr<RenderCache> m_cache;
+
+        std::vector<Task> m_tasks;
+        std::vector<std::unique_ptr<ChunkedJob>> m_chunkedJobs;    // one slot per job, null for whole jobs
+        std::atomic<std::size_t> m_nextTask;
+        std::atomic<std::size_t> m_completedJobs;
+
+        std::vector<BatchJobResult> m_results;  // one slot per job, written by whichever worker ran it
+        unsigned int m_threadsUsed;
+        double m_wallSeconds;
+};
+
+#endif // BATCH_RENDERER_HPP
@@ -6,6 +6,8 @@
 
 #include "button.hpp"
 #include "theme.hpp"
+#include "render_stats.hpp"
+#include "trace.hpp"
 
 // app manager constructor
 Button::Button(ButtonShape shape, ButtonType type, TitleLocation location, const sf::String& title, float WidthOrRadius, float height)
@@ -122,6 +124,8 @@ Button::Button(float x, float y, ButtonShape shape, ButtonType type, const sf::S
 
 void Button::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
 {
+    TRACE_SCOPE("Button::handleEvent");
+
     if (m_isDisabled)
     {
         m_shape->setFillColor(m_disabledColor);
@@ -215,14 +219,16 @@ void Button::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
     }
 }
 
-void Button::draw(sf::RenderWindow& window)
+void Button::draw(sf::RenderTarget& target)
 {
-    window.draw(*m_shape);
-    window.draw(m_titleText);
+    TRACE_SCOPE("Button::draw");
+
+    drawCounted(target, *m_shape);
+    drawCounted(target, m_titleText);
 
     if (m_buttonType == ButtonType::StateCycling && !m_cycleText.empty())
     {
-        window.draw(m_cycleText[m_currentState]);
+        drawCounted(target, m_cycleText[m_currentState]);
     }
 }
 
@@ -300,6 +306,23 @@ void Button::setStates(const std::vector<sf::String>& labels, const std::vector<
     }
 }
 
+void Button::setPressed(bool pressed)
+{
+    if (m_buttonType == ButtonType::Latching)
+    {
+        m_isPressed = pressed;
+        m_shape->setFillColor(m_isPressed ? m_pressedColor : m_unpressedColor);
+    }
+}
+void Button::setButtonState(int state)
+{
+    if (m_buttonType == ButtonType::StateCycling && state >= 0 && state < static_cast<int>(m_stateColors.size()))
+    {
+        m_currentState = state;
+        m_shape->setFillColor(m_stateColors[m_currentState]);
+    }
+}
+
 // getters
 
 Button::ButtonType Button::getButtonType() const
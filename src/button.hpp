@@ -39,7 +39,7 @@ class Button
         ~Button() = default;
 
         void handleEvent(const sf::Event& event, const sf::RenderWindow& window);
-        void draw(sf::RenderWindow& window);
+        void draw(sf::RenderTarget& target);
 
         // setters
         void setUnpressedColor(sf::Color color);
@@ -51,6 +51,8 @@ class Button
         void setTextAlignment(sf::Vector2f position);
         void setPosition(sf::Vector2f position);
         void setStates(const std::vector<sf::String>& labels, const std::vector<sf::Color>& colors);
+        void setPressed(bool pressed);          // latching buttons only
+        void setButtonState(int state);         // state cycling buttons only
 
         // getters
         ButtonType getButtonType() const;
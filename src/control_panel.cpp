@@ -0,0 +1,267 @@
+#include <vector>
+
+#include "control_panel.hpp"
+#include "trace.hpp"
+
+ControlPanel::ControlPanel(Envelope& envelope)
+: m_envelope(envelope)
+
+, m_attackSlider(0.01f, 3.f, "Attack")
+, m_decaySlider(0.01f, 3.f, "Decay")
+, m_sustainSlider(0.01f, 1.f, "Sustain")
+, m_releaseSlider(0.01f, 3.f, "Release")
+
+, m_attackSlopeKnob(Knob::KnobType::Centered, -10.f, 10.f, 0.f, 22.f, "")
+, m_decaySlopeKnob(Knob::KnobType::Centered, -10.f, 10.f, 0.f, 22.f, "")
+, m_releaseSlopeKnob(Knob::KnobType::Centered, -10.f, 10.f, 0.f, 22.f, "")
+
+, m_envelopeTypeButton(Button::ButtonShape::Rectangle, Button::ButtonType::StateCycling, Button::TitleLocation::Below, "Envelope Type", 125.f, 50.f)
+, m_loopButton(Button::ButtonShape::Rectangle, Button::ButtonType::Latching, Button::TitleLocation::Below, "Loop", 125.f, 50.f)
+, m_trigButton(Button::ButtonShape::Circle, Button::ButtonType::Momentary, Button::TitleLocation::Centered, "TRIG", 75.f)
+, m_resetButton(Button::ButtonShape::Circle, Button::ButtonType::Momentary, Button::TitleLocation::Centered, "RESET", 75.f)
+
+, m_envelopeVisualizer(envelope)
+{
+}
+
+void ControlPanel::layOut(sf::Vector2f size)
+{
+    // position sliders
+    float sliderStartX = (2.f / 29.f) * size.x;
+    float sliderEndX = (20.f / 29.f) * size.x;
+
+    float attackY = (3.f / 29.f) * size.y;
+    m_attackSlider.setPosition(sf::Vector2f(sliderStartX, attackY), sf::Vector2f(sliderEndX, attackY));
+    m_attackSlider.setValue(m_envelope.getAttackTime());
+
+    float decayY = (6.f / 29.f) * size.y;
+    m_decaySlider.setPosition(sf::Vector2f(sliderStartX, decayY), sf::Vector2f(sliderEndX, decayY));
+    m_decaySlider.setValue(m_envelope.getDecayTime());
+
+    float sustainY = (9.f / 29.f) * size.y;
+    m_sustainSlider.setPosition(sf::Vector2f(sliderStartX, sustainY), sf::Vector2f(sliderEndX, sustainY));
+    m_sustainSlider.setValue(m_envelope.getSustainLevel());
+
+    float releaseY = (12.f / 29.f) * size.y;
+    m_releaseSlider.setPosition(sf::Vector2f(sliderStartX, releaseY), sf::Vector2f(sliderEndX, releaseY));
+    m_releaseSlider.setValue(m_envelope.getReleaseTime());
+
+    // initialize knobs
+
+    float knobX = (23.f / 29.f) * size.x;
+
+    m_attackSlopeKnob.setPosition(sf::Vector2f(knobX, attackY));
+    m_decaySlopeKnob.setPosition(sf::Vector2f(knobX, decayY));
+    m_releaseSlopeKnob.setPosition(sf::Vector2f(knobX, releaseY));
+
+    // initialize buttons
+
+    // envelope type button
+    float envButtonX = (5.5f / 29.f) * size.x;
+    float envButtonY = (14.5f / 29.f) * size.y;
+    m_envelopeTypeButton.setPosition(sf::Vector2f(envButtonX, envButtonY));
+
+    std::vector<sf::String> labels = {"ADSR", "ASR", "AD"};
+    std::vector<sf::Color> colors = {sf::Color::Magenta, sf::Color::Yellow, sf::Color::Green};
+    m_envelopeTypeButton.setStates(labels, colors);
+
+    // loop button
+    float loopButtonX = (13.5f / 29.f) * size.x;
+    float loopButtonY = (14.5f / 29.f) * size.y;
+    m_loopButton.setPosition(sf::Vector2f(loopButtonX, loopButtonY));
+
+    // trig button
+    float trigButtonX = (23.f / 29.f) * size.x;
+    float trigButtonY = (18.f / 29.f) * size.y;
+
+    m_trigButton.setPosition(sf::Vector2f(trigButtonX, trigButtonY));
+    m_trigButton.setUnpressedColor(sf::Color::Green);
+
+    // reset button
+    float resetButtonX = (23.f / 29.f) * size.x;
+    float resetButtonY = (24.f / 29.f) * size.y;
+
+    m_resetButton.setPosition(sf::Vector2f(resetButtonX, resetButtonY));
+    m_resetButton.setUnpressedColor(sf::Color::Red);
+
+    // initialize visualizer window
+    float vizX = (1.f / 29.f) * size.x;
+    float vizY = (17.f / 29.f) * size.y;
+
+    float vizWidth = ((19.f / 29.f) * size.x) - vizX;
+    float vizHeight = ((28.f / 29.f) * size.y) - vizY;
+
+    m_envelopeVisualizer.setPosition(sf::Vector2f(vizX, vizY), sf::Vector2f(vizWidth, vizHeight), m_envelope);
+}
+
+bool ControlPanel::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
+{
+    // sliders
+    m_attackSlider.handleEvent(event, window);
+    m_decaySlider.handleEvent(event, window);
+    m_sustainSlider.handleEvent(event, window);
+    m_releaseSlider.handleEvent(event, window);
+
+    // knobs
+    m_attackSlopeKnob.handleEvent(event, window);
+    m_decaySlopeKnob.handleEvent(event, window);
+    m_releaseSlopeKnob.handleEvent(event, window);
+
+    // buttons
+    m_envelopeTypeButton.handleEvent(event, window);
+    m_loopButton.handleEvent(event, window);
+
+    bool wasTrigPressed = m_trigButton.isPressed();
+    m_trigButton.handleEvent(event, window);
+
+    m_resetButton.handleEvent(event, window);
+
+    return !wasTrigPressed && m_trigButton.isPressed();
+}
+
+void ControlPanel::setParameter(AutomationParameter parameter, float value)
+{
+    switch (parameter)
+    {
+        case AutomationParameter::ATTACK_TIME:
+            m_attackSlider.setValue(value);
+            break;
+        case AutomationParameter::ATTACK_CURVE:
+            m_attackSlopeKnob.setValue(value);
+            break;
+        case AutomationParameter::DECAY_TIME:
+            m_decaySlider.setValue(value);
+            break;
+        case AutomationParameter::DECAY_CURVE:
+            m_decaySlopeKnob.setValue(value);
+            break;
+        case AutomationParameter::SUSTAIN_LEVEL:
+            m_sustainSlider.setValue(value);
+            break;
+        case AutomationParameter::RELEASE_TIME:
+            m_releaseSlider.setValue(value);
+            break;
+        case AutomationParameter::RELEASE_CURVE:
+            m_releaseSlopeKnob.setValue(value);
+            break;
+        default:
+            break;
+    }
+}
+
+void ControlPanel::setEnvelopeType(int type)
+{
+    m_envelopeTypeButton.setButtonState(type);
+}
+
+void ControlPanel::setLooping(bool isLooping)
+{
+    m_loopButton.setPressed(isLooping);
+}
+
+bool ControlPanel::isLooping() const
+{
+    return m_loopButton.isPressed();
+}
+
+void ControlPanel::getPreset(PresetRecord& preset) const
+{
+    preset.envelopeType = static_cast<std::uint8_t>(m_envelopeTypeButton.getButtonState());
+    preset.flags = m_loopButton.isPressed() ? PresetRecord::LOOPING : 0;
+    preset.attackTime = m_attackSlider.getValue();
+    preset.attackCurve = m_attackSlopeKnob.getValue();
+    preset.decayTime = m_decaySlider.getValue();
+    preset.decayCurve = m_decaySlopeKnob.getValue();
+    preset.sustainLevel = m_sustainSlider.getValue();
+    preset.releaseTime = m_releaseSlider.getValue();
+    preset.releaseCurve = m_releaseSlopeKnob.getValue();
+}
+
+void ControlPanel::setPreset(const PresetRecord& preset)
+{
+    m_envelopeTypeButton.setButtonState(preset.envelopeType);
+    m_loopButton.setPressed((preset.flags & PresetRecord::LOOPING) != 0);
+    m_attackSlider.setValue(preset.attackTime);
+    m_attackSlopeKnob.setValue(preset.attackCurve);
+    m_decaySlider.setValue(preset.decayTime);
+    m_decaySlopeKnob.setValue(preset.decayCurve);
+    m_sustainSlider.setValue(preset.sustainLevel);
+    m_releaseSlider.setValue(preset.releaseTime);
+    m_releaseSlopeKnob.setValue(preset.releaseCurve);
+}
+
+bool ControlPanel::updateEnvelope(bool isGateOn, bool isResetPending)
+{
+    TRACE_SCOPE("ControlPanel::updateEnvelope");
+
+    // sliders
+    m_envelope.setAttackTime(m_attackSlider.getValue());
+    m_envelope.setDecayTime(m_decaySlider.getValue());
+    m_envelope.setSustainLevel(m_sustainSlider.getValue());
+    m_envelope.setReleaseTime(m_releaseSlider.getValue());
+
+    // knobs
+    m_envelope.setAttackCurve(m_attackSlopeKnob.getValue());
+    m_envelope.setDecayCurve(m_decaySlopeKnob.getValue());
+    m_envelope.setReleaseCurve(m_releaseSlopeKnob.getValue());
+
+    // buttons
+    m_envelope.setEnvelopeType(static_cast<Envelope::EnvelopeType>(m_envelopeTypeButton.getButtonState()));
+    m_envelope.setLooping(m_loopButton.isPressed());
+
+    bool isTriggered = false;
+
+    // if the trigger button is pressed or the caller's gate is on
+    if (m_trigButton.isPressed() || isGateOn)
+    {
+        // if the envelope is NOT active, start an envelope
+        if (!m_envelope.isActive())
+        {
+            m_envelope.trigger();
+            isTriggered = true;
+        }
+    }
+    // otherwise release it, if it's in a phase that allows for release
+    else if (m_envelope.isActive() &&
+             (m_envelope.getPhase() == Envelope::Phase::ATTACK ||
+              m_envelope.getPhase() == Envelope::Phase::DECAY ||
+              m_envelope.getPhase() == Envelope::Phase::SUSTAIN))
+    {
+        m_envelope.release();
+    }
+
+    if (m_resetButton.isPressed() || isResetPending)
+    {
+        m_envelope.reset();
+    }
+
+    return isTriggered;
+}
+
+void ControlPanel::updateVisualizer()
+{
+    m_envelopeVisualizer.update(m_envelope);
+}
+
+void ControlPanel::draw(sf::RenderTarget& target)
+{
+    // draw sliders
+    m_attackSlider.draw(target);
+    m_decaySlider.draw(target);
+    m_sustainSlider.draw(target);
+    m_releaseSlider.draw(target);
+
+    // draw knobs
+    m_attackSlopeKnob.draw(target);
+    m_decaySlopeKnob.draw(target);
+    m_releaseSlopeKnob.draw(target);
+
+    // draw buttons
+    m_loopButton.draw(target);
+    m_envelopeTypeButton.draw(target);
+    m_trigButton.draw(target);
+    m_resetButton.draw(target);
+
+    // draw envelope visualizer area
+    m_envelopeVisualizer.draw(target);
+}
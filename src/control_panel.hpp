@@ -0,0 +1,71 @@
+#ifndef CONTROL_PANEL_HPP
+#define CONTROL_PANEL_HPP
+
+#include <SFML/Graphics.hpp>
+
+#include "slider.hpp"
+#include "knob.hpp"
+#include "button.hpp"
+#include "envelope_visualizer.hpp"
+#include "envelope_generator.hpp"
+#include "automation.hpp"
+#include "preset.hpp"
+
+/*
+    The app's widgets and visualizer for one envelope: their layout, and
+    passing the widget values and the gate on to the envelope each frame.
+    AppManager and envelope_bench_ui both drive the envelope through it,
+    so the benchmark measures the app's own layout and update.
+
+    OSC messages, presets and scripts set the widgets like a user would,
+    updateEnvelope() picks the values up from there.
+*/
+
+class ControlPanel
+{
+    public:
+        ControlPanel(Envelope& envelope);
+
+        // positions from fractions of the window size, widgets start at the envelope's values
+        void layOut(sf::Vector2f size);
+
+        // returns true when the event pressed TRIG
+        bool handleEvent(const sf::Event& event, const sf::RenderWindow& window);
+
+        void setParameter(AutomationParameter parameter, float value);
+        void setEnvelopeType(int type);
+        void setLooping(bool isLooping);
+        bool isLooping() const;
+
+        // the curve knobs hold the unscaled values the setters expect
+        void getPreset(PresetRecord& preset) const;
+        void setPreset(const PresetRecord& preset);
+
+        // widgets to the envelope, then the gate (TRIG or isGateOn) and reset,
+        // returns true when the gate started a note
+        bool updateEnvelope(bool isGateOn, bool isResetPending);
+
+        void updateVisualizer();
+        void draw(sf::RenderTarget& target);
+
+    private:
+        Envelope& m_envelope;
+
+        Slider m_attackSlider;
+        Slider m_decaySlider;
+        Slider m_sustainSlider;
+        Slider m_releaseSlider;
+
+        Knob m_attackSlopeKnob;
+        Knob m_decaySlopeKnob;
+        Knob m_releaseSlopeKnob;
+
+        Button m_envelopeTypeButton;
+        Button m_loopButton;
+        Button m_trigButton;
+        Button m_resetButton;
+
+        EnvelopeVisualizer m_envelopeVisualizer;
+};
+
+#endif // CONTROL_PANEL_HPP
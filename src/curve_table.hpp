@@ -0,0 +1,209 @@
+#ifndef CURVE_TABLE_HPP
+#define CURVE_TABLE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/*
+    Quantized curve tables, built by the compiler.
+
+    Curve knobs span -10 to 10, which scaleCurveNumber() turns into an
+    exponent from 1/11 to 11. The knob range is cut into CURVE_TABLE_STEPS
+    steps per unit and every step gets a table of x^exponent sampled at
+    CURVE_TABLE_SIZE + 1 points over [0, 1].
+
+    Everything below is constexpr, so the tables are plain read-only data
+    in the binary: nothing is built at startup, and every process running
+    the same binary shares the same pages.
+
+    The render loop uses them in place of std::pow() when
+    ENVELOPE_CURVE_TABLES is defined. Exponents snap to the nearest step
+    and values are interpolated linearly, except in the first cell where
+    the shallow curves are too steep to interpolate and pow() is used.
+
+    FIXED_CURVE_TABLES holds the same tables in Q format for the fixed
+    point envelope, whose lookup stays in integers: the first cell is
+    handled by zooming in, x^e = (256x)^e * (1/256)^e, until x is past it.
+*/
+
+constexpr int CURVE_KNOB_RANGE = 10;
+constexpr int CURVE_TABLE_STEPS = 4;                    // per knob unit
+constexpr int CURVE_TABLE_COUNT = 2 * CURVE_KNOB_RANGE * CURVE_TABLE_STEPS + 1;
+constexpr int CURVE_TABLE_BITS = 8;
+constexpr int CURVE_TABLE_SIZE = 1 << CURVE_TABLE_BITS; // cells per table
+
+namespace curve_table_detail
+{
+    constexpr double LN2 = 0.6931471805599453;
+
+    // log(x) for x > 0: scale into [0.5, 1), then 2 * atanh((m - 1) / (m + 1))
+    constexpr double log(double x)
+    {
+        int exponent = 0;
+        while (x < 0.5)
+        {
+            x *= 2.0;
+            exponent--;
+        }
+        while (x >= 1.0)
+        {
+            x *= 0.5;
+            exponent++;
+        }
+
+        double z = (x - 1.0) / (x + 1.0);
+        double z2 = z * z;
+        double term = z;
+        double sum = 0.0;
+
+        for (int n = 1; n < 60; n += 2)
+        {
+            sum += term / n;
+            term *= z2;
+        }
+        return 2.0 * sum + exponent * LN2;
+    }
+
+    // exp(y) for y <= 0: take out whole ln2s, Taylor series on the rest
+    constexpr double exp(double y)
+    {
+        int halvings = 0;
+        while (y < -LN2)
+        {
+            y += LN2;
+            halvings++;
+        }
+
+        double term = 1.0;
+        double sum = 1.0;
+
+        for (int n = 1; n < 30; n++)
+        {
+            term *= y / n;
+            sum += term;
+        }
+        for (int i = 0; i < halvings; i++)
+        {
+            sum *= 0.5;
+        }
+        return sum;
+    }
+
+    // x^exponent for x in [0, 1], exponent > 0
+    constexpr double pow(double x, double exponent)
+    {
+        return (x <= 0.0) ? 0.0 : exp(exponent * log(x));
+    }
+
+    // same mapping as Envelope::scaleCurveNumber()
+    constexpr double knobToExponent(double knob)
+    {
+        return (knob >= 0.0) ? 1.0 + knob : 1.0 / (1.0 - knob);
+    }
+}
+
+struct CurveTables
+{
+    float exponents[CURVE_TABLE_COUNT];
+    float values[CURVE_TABLE_COUNT][CURVE_TABLE_SIZE + 1];
+};
+
+constexpr CurveTables buildCurveTables()
+{
+    CurveTables tables{};
+
+    for (int curve = 0; curve < CURVE_TABLE_COUNT; curve++)
+    {
+        double knob = static_cast<double>(curve) / CURVE_TABLE_STEPS - CURVE_KNOB_RANGE;
+        double exponent = curve_table_detail::knobToExponent(knob);
+
+        tables.exponents[curve] = static_cast<float>(exponent);
+        for (int i = 0; i <= CURVE_TABLE_SIZE; i++)
+        {
+            double x = static_cast<double>(i) / CURVE_TABLE_SIZE;
+            tables.values[curve][i] = static_cast<float>(curve_table_detail::pow(x, exponent));
+        }
+    }
+    return tables;
+}
+
+inline constexpr CurveTables CURVE_TABLES = buildCurveTables();
+
+// nearest table for an exponent, the inverse of scaleCurveNumber() then snapped to a step
+inline int findCurveTable(float exponent)
+{
+    float knob = (exponent >= 1.0f) ? exponent - 1.0f : 1.0f - 1.0f / exponent;
+    float step = std::round((knob + CURVE_KNOB_RANGE) * CURVE_TABLE_STEPS);
+
+    return static_cast<int>(std::min(std::max(step, 0.0f), static_cast<float>(CURVE_TABLE_COUNT - 1)));
+}
+
+// x^exponent of table curve, x in [0, 1]
+inline float lookupCurve(int curve, float x)
+{
+    float position = x * CURVE_TABLE_SIZE;
+    int cell = std::min(static_cast<int>(position), CURVE_TABLE_SIZE - 1);
+
+    if (cell == 0)
+    {
+        return std::pow(x, CURVE_TABLES.exponents[curve]);
+    }
+
+    const float* values = CURVE_TABLES.values[curve];
+    return values[cell] + (position - cell) * (values[cell + 1] - values[cell]);
+}
+
+// fixed point
+
+template <int FRACTION_BITS>
+struct FixedCurveTables
+{
+    std::int32_t values[CURVE_TABLE_COUNT][CURVE_TABLE_SIZE + 1];
+};
+
+template <int FRACTION_BITS>
+constexpr FixedCurveTables<FRACTION_BITS> buildFixedCurveTables()
+{
+    FixedCurveTables<FRACTION_BITS> tables{};
+
+    for (int curve = 0; curve < CURVE_TABLE_COUNT; curve++)
+    {
+        for (int i = 0; i <= CURVE_TABLE_SIZE; i++)
+        {
+            double value = static_cast<double>(CURVE_TABLES.values[curve][i]) * (std::int64_t(1) << FRACTION_BITS);
+            tables.values[curve][i] = static_cast<std::int32_t>(value + 0.5);
+        }
+    }
+    return tables;
+}
+
+template <int FRACTION_BITS>
+inline constexpr FixedCurveTables<FRACTION_BITS> FIXED_CURVE_TABLES = buildFixedCurveTables<FRACTION_BITS>();
+
+// x^exponent of table curve, x in [0, 1], both in Q format
+template <int FRACTION_BITS>
+inline std::int32_t lookupCurveFixed(int curve, std::int32_t x)
+{
+    static_assert(FRACTION_BITS >= CURVE_TABLE_BITS, "not enough fraction bits to index the tables");
+
+    constexpr int CELL_SHIFT = FRACTION_BITS - CURVE_TABLE_BITS;
+    constexpr std::int32_t FIRST_CELL_END = std::int32_t(1) << CELL_SHIFT;
+
+    const std::int32_t* values = FIXED_CURVE_TABLES<FRACTION_BITS>.values[curve];
+    std::int64_t factor = std::int64_t(1) << FRACTION_BITS;
+
+    while (x > 0 && x < FIRST_CELL_END)
+    {
+        x <<= CURVE_TABLE_BITS;
+        factor = (factor * values[1]) >> FRACTION_BITS;
+    }
+
+    int cell = std::min(x >> CELL_SHIFT, CURVE_TABLE_SIZE - 1);
+    std::int32_t fraction = x - (cell << CELL_SHIFT);
+    std::int64_t value = values[cell] + ((static_cast<std::int64_t>(values[cell + 1] - values[cell]) * fraction) >> CELL_SHIFT);
+
+    return static_cast<std::int32_t>((value * factor) >> FRACTION_BITS);
+}
+
+#endif // CURVE_TABLE_HPP
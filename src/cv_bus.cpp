@@ -0,0 +1,472 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cv_bus.hpp"
+
+namespace
+{
+    const char CV_BUS_MAGIC[8] = {'E', 'N', 'V', 'C', 'V', 'B', 'U', 'S'};
+
+#ifdef _WIN32
+    std::string getSystemName(const std::string& name)
+    {
+        return "Local\\" + name;
+    }
+#else
+    std::string getSystemName(const std::string& name)
+    {
+        return "/" + name;
+    }
+
+    // removes a block whose owner is gone, false if it's still in use
+    bool removeIfStale(const std::string& systemName)
+    {
+        int descriptor = shm_open(systemName.c_str(), O_RDWR, 0);
+        if (descriptor < 0)
+        {
+            return errno == ENOENT;     // went away in the meantime
+        }
+
+        // the owner's lock goes with its process, systems without flock() on
+        // shared memory can't tell and replace the block like before
+        bool isStale = flock(descriptor, LOCK_EX | LOCK_NB) == 0 || errno != EWOULDBLOCK;
+        if (isStale)
+        {
+            shm_unlink(systemName.c_str());
+        }
+        ::close(descriptor);
+        return isStale;
+    }
+#endif
+}
+
+SharedMemory::SharedMemory()
+: m_data(nullptr)
+, m_size(0)
+, m_isOwner(false)
+#ifdef _WIN32
+, m_mappingHandle(nullptr)
+#else
+, m_descriptor(-1)
+, m_inode(0)
+#endif
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+    close();
+}
+
+unsigned char* SharedMemory::getData() const
+{
+    return static_cast<unsigned char*>(m_data);
+}
+std::size_t SharedMemory::getSize() const
+{
+    return m_size;
+}
+
+#ifdef _WIN32
+
+bool SharedMemory::create(const std::string& name, std::size_t size)
+{
+    close();
+
+    std::uint64_t size64 = size;
+    m_mappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+                                         static_cast<DWORD>(size64), getSystemName(name).c_str());
+    if (m_mappingHandle != nullptr && GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        std::cerr << "Shared memory " << name << " is in use by another process" << std::endl;
+        close();
+        return false;
+    }
+
+    m_data = m_mappingHandle ? MapViewOfFile(m_mappingHandle, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+    if (m_data == nullptr)
+    {
+        std::cerr << "Failed to create shared memory " << name << std::endl;
+        close();
+        return false;
+    }
+
+    // the mapping goes away with its last handle, nothing to remove
+    m_size = size;
+    return true;
+}
+
+bool SharedMemory::open(const std::string& name)
+{
+    close();
+
+    m_mappingHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, getSystemName(name).c_str());
+    m_data = m_mappingHandle ? MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (m_data == nullptr)
+    {
+        std::cerr << "No shared memory named " << name << std::endl;
+        close();
+        return false;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    m_size = VirtualQuery(m_data, &info, sizeof(info)) ? info.RegionSize : 0;
+    return true;
+}
+
+void SharedMemory::close()
+{
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle != nullptr)
+    {
+        CloseHandle(m_mappingHandle);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mappingHandle = nullptr;
+}
+
+#else
+
+bool SharedMemory::create(const std::string& name, std::size_t size)
+{
+    close();
+
+    std::string systemName = getSystemName(name);
+    int descriptor = shm_open(systemName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    bool isInUse = descriptor < 0 && errno == EEXIST;
+    if (isInUse && removeIfStale(systemName))
+    {
+        descriptor = shm_open(systemName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        isInUse = descriptor < 0 && errno == EEXIST;
+    }
+    if (descriptor < 0)
+    {
+        if (isInUse)
+        {
+            std::cerr << "Shared memory " << name << " is in use by another process" << std::endl;
+        }
+        else
+        {
+            std::cerr << "Failed to create shared memory " << name << std::endl;
+        }
+        return false;
+    }
+
+    // held until close() or the process ends, it's what tells a live block from a stale one
+    flock(descriptor, LOCK_EX | LOCK_NB);
+
+    struct stat info;
+    if (ftruncate(descriptor, static_cast<off_t>(size)) != 0 || fstat(descriptor, &info) != 0)
+    {
+        std::cerr << "Failed to create shared memory " << name << std::endl;
+        shm_unlink(systemName.c_str());
+        ::close(descriptor);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map shared memory " << name << std::endl;
+        shm_unlink(systemName.c_str());
+        ::close(descriptor);
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_name = systemName;
+    m_isOwner = true;
+    m_descriptor = descriptor;
+    m_inode = static_cast<std::uint64_t>(info.st_ino);
+    return true;
+}
+
+bool SharedMemory::open(const std::string& name)
+{
+    close();
+
+    int descriptor = shm_open(getSystemName(name).c_str(), O_RDONLY, 0);
+    if (descriptor < 0)
+    {
+        std::cerr << "No shared memory named " << name << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0)
+    {
+        data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+    }
+    ::close(descriptor);
+
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map shared memory " << name << std::endl;
+        return false;
+    }
+
+    m_data = data;
+    m_size = static_cast<std::size_t>(info.st_size);
+    return true;
+}
+
+void SharedMemory::close()
+{
+    if (m_data != nullptr)
+    {
+        munmap(m_data, m_size);
+    }
+    if (m_isOwner)
+    {
+        // only while the name still refers to this block, never someone else's
+        int descriptor = shm_open(m_name.c_str(), O_RDONLY, 0);
+        struct stat info;
+        if (descriptor >= 0 && fstat(descriptor, &info) == 0 && static_cast<std::uint64_t>(info.st_ino) == m_inode)
+        {
+            shm_unlink(m_name.c_str());
+        }
+        if (descriptor >= 0)
+        {
+            ::close(descriptor);
+        }
+    }
+    if (m_descriptor >= 0)
+    {
+        ::close(m_descriptor);     // and with it the lock
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_name.clear();
+    m_isOwner = false;
+    m_descriptor = -1;
+    m_inode = 0;
+}
+
+#endif // _WIN32
+
+CvBus::CvBus()
+: m_header(nullptr)
+, m_current(nullptr)
+, m_framesPublished(0)
+{
+}
+
+bool CvBus::create(const std::string& name, std::uint32_t voiceCount, std::uint32_t frameCount)
+{
+    close();
+
+    if (voiceCount == 0 || voiceCount > CvSnapshot::MAX_VOICES || frameCount < 2)
+    {
+        std::cerr << "A CV bus takes 1 to " << CvSnapshot::MAX_VOICES << " voices and at least 2 frames" << std::endl;
+        return false;
+    }
+
+    // frames padded to 8 bytes so every frame header stays aligned
+    std::uint32_t frameSize = static_cast<std::uint32_t>(sizeof(CvFrameHeader) + voiceCount * sizeof(CvVoiceState) + 7) & ~7u;
+
+    if (!m_memory.create(name, sizeof(CvBusHeader) + static_cast<std::size_t>(frameCount) * frameSize))
+    {
+        return false;
+    }
+
+    // a new block reads as zeros, every frame's sequence starts out even
+    m_header = new (m_memory.getData()) CvBusHeader();
+    std::memcpy(m_header->magic, CV_BUS_MAGIC, sizeof(CV_BUS_MAGIC));
+    m_header->formatVersion = CV_BUS_FORMAT_VERSION;
+    m_header->voiceCount = voiceCount;
+    m_header->frameCount = frameCount;
+    m_header->frameSize = frameSize;
+    m_header->framesPublished.store(0, std::memory_order_release);
+
+    m_framesPublished = 0;
+    return true;
+}
+
+void CvBus::close()
+{
+    m_memory.close();
+    m_header = nullptr;
+    m_current = nullptr;
+}
+
+bool CvBus::isOpen() const
+{
+    return m_header != nullptr;
+}
+
+std::uint32_t CvBus::getVoiceCount() const
+{
+    return m_header ? m_header->voiceCount : 0;
+}
+
+CvFrameHeader* CvBus::getFrame(std::uint64_t frameNumber) const
+{
+    std::size_t offset = sizeof(CvBusHeader) + static_cast<std::size_t>(frameNumber % m_header->frameCount) * m_header->frameSize;
+    return reinterpret_cast<CvFrameHeader*>(m_memory.getData() + offset);
+}
+
+CvVoiceState* CvBus::beginFrame()
+{
+    if (m_header == nullptr)
+    {
+        return nullptr;
+    }
+
+    // odd: readers that copy this frame from here on throw their copy away
+    m_current = getFrame(m_framesPublished);
+    std::uint32_t sequence = m_current->sequence.load(std::memory_order_relaxed);
+    m_current->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    return reinterpret_cast<CvVoiceState*>(m_current + 1);
+}
+
+void CvBus::endFrame()
+{
+    if (m_current == nullptr)
+    {
+        return;
+    }
+
+    m_current->frameNumber = m_framesPublished;
+    m_current->publishTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    // even again, then announce it
+    m_current->sequence.store(m_current->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    m_header->framesPublished.store(++m_framesPublished, std::memory_order_release);
+    m_current = nullptr;
+}
+
+CvBusReader::CvBusReader()
+: m_header(nullptr)
+{
+}
+
+bool CvBusReader::open(const std::string& name)
+{
+    close();
+
+    if (!m_memory.open(name))
+    {
+        return false;
+    }
+
+    const CvBusHeader* header = reinterpret_cast<const CvBusHeader*>(m_memory.getData());
+    // the sizes decide every offset copyFrame() reads from, none of them can be trusted
+    bool isValid = m_memory.getSize() >= sizeof(CvBusHeader) &&
+                   std::memcmp(header->magic, CV_BUS_MAGIC, sizeof(CV_BUS_MAGIC)) == 0 &&
+                   header->formatVersion == CV_BUS_FORMAT_VERSION &&
+                   header->voiceCount <= CvSnapshot::MAX_VOICES &&
+                   header->frameCount > 0 &&
+                   header->frameSize >= sizeof(CvFrameHeader) + header->voiceCount * sizeof(CvVoiceState) &&
+                   header->frameSize % alignof(CvFrameHeader) == 0 &&
+                   m_memory.getSize() >= sizeof(CvBusHeader) + static_cast<std::uint64_t>(header->frameCount) * header->frameSize;
+    if (!isValid)
+    {
+        std::cerr << name << " is not a CV bus" << std::endl;
+        m_memory.close();
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+void CvBusReader::close()
+{
+    m_memory.close();
+    m_header = nullptr;
+}
+
+bool CvBusReader::isOpen() const
+{
+    return m_header != nullptr;
+}
+
+std::uint32_t CvBusReader::getVoiceCount() const
+{
+    return m_header ? m_header->voiceCount : 0;
+}
+std::uint64_t CvBusReader::getFramesPublished() const
+{
+    return m_header ? m_header->framesPublished.load(std::memory_order_acquire) : 0;
+}
+
+bool CvBusReader::readLatest(CvSnapshot& snapshot) const
+{
+    // the publisher can lap the frame while it's copied, then there's a newer one to take
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        std::uint64_t published = getFramesPublished();
+        if (published == 0)
+        {
+            return false;
+        }
+        if (copyFrame(published - 1, snapshot))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CvBusReader::readFrame(std::uint64_t frameNumber, CvSnapshot& snapshot) const
+{
+    std::uint64_t published = getFramesPublished();
+    if (frameNumber >= published || published - frameNumber > m_header->frameCount)
+    {
+        return false;
+    }
+    return copyFrame(frameNumber, snapshot);
+}
+
+bool CvBusReader::copyFrame(std::uint64_t frameNumber, CvSnapshot& snapshot) const
+{
+    if (m_header == nullptr)
+    {
+        return false;
+    }
+
+    std::size_t offset = sizeof(CvBusHeader) + static_cast<std::size_t>(frameNumber % m_header->frameCount) * m_header->frameSize;
+    const CvFrameHeader* frame = reinterpret_cast<const CvFrameHeader*>(m_memory.getData() + offset);
+
+    std::uint32_t before = frame->sequence.load(std::memory_order_acquire);
+    if (before % 2 != 0)
+    {
+        return false;   // being written
+    }
+
+    snapshot.frameNumber = frame->frameNumber;
+    snapshot.publishTime = frame->publishTime;
+    snapshot.voiceCount = m_header->voiceCount;
+    std::memcpy(snapshot.voices, frame + 1, m_header->voiceCount * sizeof(CvVoiceState));
+
+    // the copy has to be done before the sequence is looked at again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::uint32_t after = frame->sequence.load(std::memory_order_relaxed);
+
+    return before == after && snapshot.frameNumber == frameNumber;
+}
@@ -0,0 +1,155 @@
+#ifndef CV_BUS_HPP
+#define CV_BUS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+    Envelope state shared with other processes on the same host through
+    a named shared memory block (POSIX shm_open(), a named file mapping
+    on Windows), so they can read it at their own rate without copies,
+    pipes or sockets in between.
+
+    One publisher owns a name at a time, a second create() of it fails.
+    On POSIX the owner holds a flock() on the block until it exits, so a
+    block left behind by a publisher that crashed is recognized and
+    replaced. Windows removes a mapping with its last handle anyway.
+
+    The block is a header followed by a ring of frames. A frame is one
+    snapshot of every voice: amplitude, phase and progress. The publisher
+    fills the next frame in place, beginFrame() ... endFrame(), and never
+    waits for anyone. Every frame carries a seqlock style sequence number,
+    odd while it's being written, so a reader copies a frame, checks the
+    number didn't move, and retries if it did. Readers never write to the
+    block, any number of them can come and go.
+
+    Layout (native endianness, the processes share a host):
+
+        CvBusHeader     64 bytes
+        frames          frameCount x frameSize bytes
+                        CvFrameHeader, then voiceCount x CvVoiceState
+*/
+
+constexpr std::uint32_t CV_BUS_FORMAT_VERSION = 1;
+
+struct CvVoiceState
+{
+    float amplitude;
+    float progress;         // Envelope::getProgress()
+    std::uint32_t phase;    // Envelope::Phase
+};
+
+struct CvBusHeader
+{
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t voiceCount;
+    std::uint32_t frameCount;           // ring slots
+    std::uint32_t frameSize;            // bytes, header included
+    std::atomic<std::uint64_t> framesPublished;     // the newest frame is framesPublished - 1
+    char reserved[32];
+};
+
+struct CvFrameHeader
+{
+    std::atomic<std::uint32_t> sequence;    // odd while the publisher is writing the frame
+    std::uint32_t reserved;
+    std::uint64_t frameNumber;
+    std::int64_t publishTime;   // steady_clock nanoseconds, the same clock for every process on the host
+};
+
+static_assert(sizeof(CvBusHeader) == 64, "CvBusHeader layout is shared with other processes");
+static_assert(sizeof(CvFrameHeader) == 24, "CvFrameHeader layout is shared with other processes");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared memory needs lock-free atomics");
+
+// a frame copied out of the bus
+struct CvSnapshot
+{
+    static constexpr std::uint32_t MAX_VOICES = 256;
+
+    std::uint64_t frameNumber = 0;
+    std::int64_t publishTime = 0;
+    std::uint32_t voiceCount = 0;
+    CvVoiceState voices[MAX_VOICES];
+};
+
+// the mapping itself, shared by the publisher and readers
+class SharedMemory
+{
+    public:
+        SharedMemory();
+        ~SharedMemory();
+
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+
+        bool create(const std::string& name, std::size_t size);    // fails while another process owns the name
+        bool open(const std::string& name);                        // an existing block, read-only
+        void close();
+
+        unsigned char* getData() const;
+        std::size_t getSize() const;
+
+    private:
+        void* m_data;
+        std::size_t m_size;
+        std::string m_name;     // set for a block this process created and removes again
+        bool m_isOwner;
+
+#ifdef _WIN32
+        void* m_mappingHandle;
+#else
+        int m_descriptor;           // the owner keeps it open and locked, see create()
+        std::uint64_t m_inode;      // which block m_name referred to when it was created
+#endif
+};
+
+class CvBus
+{
+    public:
+        CvBus();
+
+        bool create(const std::string& name, std::uint32_t voiceCount, std::uint32_t frameCount = 64);
+        void close();
+        bool isOpen() const;
+
+        std::uint32_t getVoiceCount() const;
+
+        // the next frame to fill, voiceCount states, published by endFrame()
+        CvVoiceState* beginFrame();
+        void endFrame();
+
+    private:
+        CvFrameHeader* getFrame(std::uint64_t frameNumber) const;
+
+        SharedMemory m_memory;
+        CvBusHeader* m_header;
+        CvFrameHeader* m_current;
+        std::uint64_t m_framesPublished;
+};
+
+class CvBusReader
+{
+    public:
+        CvBusReader();
+
+        bool open(const std::string& name);
+        void close();
+        bool isOpen() const;
+
+        std::uint32_t getVoiceCount() const;
+        std::uint64_t getFramesPublished() const;
+
+        bool readLatest(CvSnapshot& snapshot) const;    // false before the first frame
+        bool readFrame(std::uint64_t frameNumber, CvSnapshot& snapshot) const;     // false once the ring has moved past it
+
+    private:
+        bool copyFrame(std::uint64_t frameNumber, CvSnapshot& snapshot) const;
+
+        SharedMemory m_memory;
+        const CvBusHeader* m_header;
+};
+
+#endif // CV_BUS_HPP
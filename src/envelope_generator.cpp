@@ -1,8 +1,74 @@
 
 
+#include <algorithm>
 #include <cmath>
-#include <iostream>
 #include "envelope_generator.hpp"
+#include "simd.hpp"
+
+#ifdef ENVELOPE_CURVE_TABLES
+#include "curve_table.hpp"
+#endif
+
+namespace
+{
+    // first index after start where values differs from values[start], end if none
+    int findChange(const float* values, int start, int end)
+    {
+        float value = values[start];
+        int i = start + 1;
+
+#ifdef ENVELOPE_SSE2
+        __m128 reference = _mm_set1_ps(value);
+        for (; i + 4 <= end; i += 4)
+        {
+            if (_mm_movemask_ps(_mm_cmpneq_ps(_mm_loadu_ps(values + i), reference)) != 0)
+            {
+                break;
+            }
+        }
+#endif
+        for (; i < end; i++)
+        {
+            if (values[i] != value)
+            {
+                return i;
+            }
+        }
+        return end;
+    }
+
+    // the run starting at index is a single sample, some buffer has a new value right after it
+    bool changesAfter(const float* const* buffers, int bufferCount, int index, int end)
+    {
+        if (index + 1 >= end)
+        {
+            return true;
+        }
+        for (int buffer = 0; buffer < bufferCount; buffer++)
+        {
+            if (buffers[buffer] && buffers[buffer][index + 1] != buffers[buffer][index])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Envelope::Taps offsetTaps(const Envelope::Taps& taps, int offset)
+    {
+        Envelope::Taps shifted = taps;
+
+        for (float** tap : {&shifted.amplitude, &shifted.inverted, &shifted.endOfCycle, &shifted.attackGate,
+                            &shifted.decayGate, &shifted.sustainGate, &shifted.releaseGate, &shifted.progress})
+        {
+            if (*tap)
+            {
+                *tap += offset;
+            }
+        }
+        return shifted;
+    }
+}
 
 Envelope::Envelope()
 : m_currentPhase(INACTIVE)
@@ -14,8 +80,13 @@ Envelope::Envelope()
 , m_releaseTime(1.0f)
 , m_releaseCurve(1.0f)
 , m_currentAmplitude(0.0f)
+, m_releaseLevel(0.0f)
 , m_elapsedTime(0.0f)
+, m_elapsedSamples(0)
+, m_timingMode(TimingMode::CONTINUOUS)
 , m_isLooping(false)
+, m_silenceThreshold(0.0f)
+, m_skippedSamples(0)
 , m_envelopeType(Envelope::EnvelopeType::ADSR)
 {
 }
@@ -59,6 +130,14 @@ void Envelope::setLooping(bool is_looping)
 {
     m_isLooping = is_looping;
 }
+void Envelope::setSilenceThreshold(float decibels)
+{
+    m_silenceThreshold = std::pow(10.0f, decibels / 20.0f);   // -INFINITY comes out as 0
+}
+void Envelope::setTimingMode(TimingMode mode)
+{
+    m_timingMode = mode;
+}
 
 // getters
 float Envelope::getAmplitude() const
@@ -98,6 +177,18 @@ Envelope::EnvelopeType Envelope::getEnvelopeType() const
 {
     return m_envelopeType;
 }
+float Envelope::getSilenceThreshold() const
+{
+    return 20.0f * std::log10(m_silenceThreshold);
+}
+Envelope::TimingMode Envelope::getTimingMode() const
+{
+    return m_timingMode;
+}
+std::uint64_t Envelope::getSkippedSampleCount() const
+{
+    return m_skippedSamples;
+}
 Envelope::Phase Envelope::getPhase() const
 {
     return m_currentPhase;
@@ -147,6 +238,7 @@ void Envelope::trigger()
 {
     m_currentPhase = ATTACK;
     m_elapsedTime = 0.0f;
+    m_elapsedSamples = 0;
 }
 void Envelope::release()
 {
@@ -157,25 +249,26 @@ void Envelope::release()
         - If it's AD, it plays out the entire envelope regardless of the release call.
     */
 
-    if (m_currentPhase == RELEASE)
+    if (m_currentPhase == RELEASE || m_envelopeType == EnvelopeType::AD)
     {
         return;
     }
 
     m_currentPhase = RELEASE;
 
-    if (m_envelopeType == EnvelopeType::ADSR || m_envelopeType == EnvelopeType::ASR)
-    {
-        m_sustainLevel = m_currentAmplitude;
-    }
+    // release from wherever the envelope is now, without touching the
+    // sustain setting so the next trigger still reaches m_sustainLevel
+    m_releaseLevel = m_currentAmplitude;
 
     m_elapsedTime = 0.0f;
+    m_elapsedSamples = 0;
 
 }
 void Envelope::reset()
 {
     m_currentPhase = INACTIVE;
     m_elapsedTime = 0.0f;
+    m_elapsedSamples = 0;
     m_currentAmplitude = 0.0f;
 }
 
@@ -201,7 +294,7 @@ void Envelope::update(float deltaTime)
                     m_currentAmplitude = calculateAttackPhase(normalizedTime);
 
                     if (m_elapsedTime >= m_attackTime || 
-                       (fabs(m_elapsedTime - m_attackTime) < 0.0001f))
+                       (fabs(m_elapsedTime - m_attackTime) < PHASE_END_TOLERANCE))
                     {
                         m_currentPhase = DECAY;
                         m_elapsedTime = 0.0f;
@@ -217,7 +310,7 @@ void Envelope::update(float deltaTime)
                     m_currentAmplitude = calculateDecayPhase(normalizedTime);
 
                     if (m_elapsedTime >= m_decayTime || 
-                       (fabs(m_elapsedTime - m_decayTime) < 0.0001f))
+                       (fabs(m_elapsedTime - m_decayTime) < PHASE_END_TOLERANCE))
                     {
                         m_currentPhase = SUSTAIN;
                         m_elapsedTime = 0.0f;
@@ -235,10 +328,10 @@ void Envelope::update(float deltaTime)
 
                     float normalizedTime = std::min((m_elapsedTime / m_releaseTime), 1.0f);
 
-                    m_currentAmplitude = calculateReleasePhase(normalizedTime);
+                    m_currentAmplitude = m_releaseLevel * pow(1.0f - normalizedTime, m_releaseCurve);
 
                     if (m_elapsedTime >= m_releaseTime || 
-                       (fabs(m_elapsedTime - m_releaseTime) < 0.0001f))
+                       (fabs(m_elapsedTime - m_releaseTime) < PHASE_END_TOLERANCE))
                     {
                         if(m_isLooping)
                         {
@@ -270,7 +363,7 @@ void Envelope::update(float deltaTime)
                     m_currentAmplitude = calculateAttackPhase(normalizedTime);
 
                     if (m_elapsedTime >= m_attackTime || 
-                       (fabs(m_elapsedTime - m_attackTime) < 0.0001f))
+                       (fabs(m_elapsedTime - m_attackTime) < PHASE_END_TOLERANCE))
                     {
                         m_currentPhase = SUSTAIN;
                         m_elapsedTime = 0.0f;
@@ -288,10 +381,10 @@ void Envelope::update(float deltaTime)
 
                     float normalizedTime = std::min((m_elapsedTime / m_releaseTime), 1.0f);
 
-                    m_currentAmplitude = calculateReleasePhase(normalizedTime);
+                    m_currentAmplitude = m_releaseLevel * pow(1.0f - normalizedTime, m_releaseCurve);
 
                     if (m_elapsedTime >= m_releaseTime || 
-                       (fabs(m_elapsedTime - m_releaseTime) < 0.0001f))
+                       (fabs(m_elapsedTime - m_releaseTime) < PHASE_END_TOLERANCE))
                     {
                         if(m_isLooping)
                         {
@@ -323,7 +416,7 @@ void Envelope::update(float deltaTime)
                     m_currentAmplitude = calculateAttackPhase(normalizedTime);
 
                     if (m_elapsedTime >= m_attackTime || 
-                       (fabs(m_elapsedTime - m_attackTime) < 0.0001f))
+                       (fabs(m_elapsedTime - m_attackTime) < PHASE_END_TOLERANCE))
                     {
                         m_currentPhase = DECAY;
                         m_elapsedTime = 0.0f;
@@ -339,7 +432,7 @@ void Envelope::update(float deltaTime)
                     m_currentAmplitude = calculateDecayPhase(normalizedTime);
 
                     if (m_elapsedTime >= m_decayTime || 
-                       (fabs(m_elapsedTime - m_decayTime) < 0.0001f))
+                       (fabs(m_elapsedTime - m_decayTime) < PHASE_END_TOLERANCE))
                     {
                         if(m_isLooping)
                         {
@@ -366,6 +459,515 @@ void Envelope::update(float deltaTime)
 
 }
 
+Envelope::BlockInfo Envelope::renderBlock(float* output, int numSamples, float sampleRate)
+{
+    Taps taps;
+    taps.amplitude = output;
+
+    return renderBlock(taps, numSamples, sampleRate);
+}
+
+Envelope::BlockInfo Envelope::renderBlock(const Taps& taps, int numSamples, float sampleRate)
+{
+    /*
+        Sample accurate version of update().
+
+        Segment lengths are known up front, so instead of checking for the
+        end of the phase every sample, work out how many samples are left
+        in the current segment, render that many in a tight loop and then
+        handle the phase change.
+    */
+    float* output = taps.amplitude;
+    float deltaTime = 1.0f / sampleRate;
+    int i = 0;
+
+    while (i < numSamples)
+    {
+        // sustain and inactive hold their value until trigger() or release(),
+        // which can't happen inside a block, so fill the rest in one go
+        if (m_currentPhase == SUSTAIN || m_currentPhase == INACTIVE)
+        {
+            m_currentAmplitude = (m_currentPhase == SUSTAIN) ? m_sustainLevel : 0.0f;
+            std::fill(output + i, output + numSamples, m_currentAmplitude);
+            renderTaps(taps, i, numSamples, m_elapsedTime, deltaTime, 0.0f);
+
+            return BlockInfo{i == 0, m_currentAmplitude};
+        }
+
+        Segment segment = getSegment();
+
+        double samplesLeft = getSamplesLeft(segment, deltaTime);
+        int runLength = static_cast<int>(std::min(samplesLeft, static_cast<double>(numSamples - i)));
+
+        float startTime = m_elapsedTime;
+        renderSegment(output + i, runLength, deltaTime, segment);
+        renderTaps(taps, i, i + runLength, startTime, deltaTime, segment.duration);
+        i += runLength;
+
+        if (runLength == samplesLeft)
+        {
+            if (segment.endTime < segment.duration)
+            {
+                // cut short below the silence threshold, count what the full tail would have taken
+                m_skippedSamples += getSamplesAfterEnd(segment, deltaTime);
+            }
+
+            bool endsCycle = isEndOfCycle();
+            finishSegment();
+            output[i - 1] = m_currentAmplitude;
+            renderTapsSample(taps, i - 1, endsCycle);
+        }
+    }
+
+    return BlockInfo{false, 0.0f};
+}
+
+Envelope::BlockInfo Envelope::renderBlock(const Taps& taps, const Modulation& modulation, int numSamples, float sampleRate)
+{
+    /*
+        Modulation is applied in runs: find how long every buffer holds its
+        value, set the parameters once and render the run as usual. The
+        segment setup (reciprocals, the silence threshold pow) only happens
+        when something actually changed, so held or stepped modulation costs
+        next to nothing. Buffers that change every sample go sample by sample,
+        checking only whether the next sample changes again; the first value
+        held longer starts a run search again, so a constant stretch after
+        audio-rate changes is still rendered as a run.
+
+        Sustain and inactive last to the end of the block. A modulated sustain
+        is copied straight to the output, nothing else matters there and the
+        settings are set from the last sample at the end.
+    */
+    const float* buffers[] = {modulation.attackTime, modulation.attackCurve, modulation.decayTime, modulation.decayCurve,
+                              modulation.sustainLevel, modulation.releaseTime, modulation.releaseCurve};
+    const int BUFFER_COUNT = 7;
+
+    float deltaTime = 1.0f / sampleRate;
+    BlockInfo info{false, 0.0f};
+    int i = 0;
+    int runs = 0;
+
+    while (i < numSamples)
+    {
+        // a modulated sustain level is the output, copy it for the rest of the block
+        if (m_currentPhase == SUSTAIN && modulation.sustainLevel)
+        {
+            std::copy(modulation.sustainLevel + i, modulation.sustainLevel + numSamples, taps.amplitude + i);
+            m_currentAmplitude = modulation.sustainLevel[numSamples - 1];
+            renderTaps(taps, i, numSamples, m_elapsedTime, 0.0f, 0.0f);
+
+            info = BlockInfo{false, 0.0f};
+            break;
+        }
+
+        int runEnd = numSamples;
+        bool isHeld = m_currentPhase == SUSTAIN || m_currentPhase == INACTIVE;
+
+        if (!isHeld)
+        {
+            applyModulation(modulation, i);
+
+            for (const float* buffer : buffers)
+            {
+                if (buffer)
+                {
+                    runEnd = findChange(buffer, i, runEnd);
+                }
+            }
+        }
+
+        // values held for one sample go sample by sample, until one is held longer
+        // and the search above finds the run it starts
+        if (runEnd - i == 1 && !isHeld)
+        {
+            renderSingleSample(taps, i++, deltaTime);
+
+            while (i < numSamples && m_currentPhase != SUSTAIN && m_currentPhase != INACTIVE &&
+                   changesAfter(buffers, BUFFER_COUNT, i, numSamples))
+            {
+                applyModulation(modulation, i);
+                renderSingleSample(taps, i++, deltaTime);
+            }
+        }
+        else
+        {
+            info = renderBlock(offsetTaps(taps, i), runEnd - i, sampleRate);
+            i = runEnd;
+        }
+        runs++;
+    }
+
+    if (numSamples > 0)
+    {
+        applyModulation(modulation, numSamples - 1);
+    }
+
+    // constant only if nothing changed and the one run was
+    return (runs == 1) ? info : BlockInfo{false, 0.0f};
+}
+
+void Envelope::advance(std::uint64_t numSamples, float sampleRate)
+{
+    /*
+        Moves the envelope on by numSamples the way renderBlock() would,
+        without the output. Only the last sample of every run is rendered,
+        that's what m_currentAmplitude, and so a later release(), starts from.
+
+        With TimingMode::SAMPLE_COUNT a sample only depends on its position
+        in the segment, so this ends up in exactly the state of a render, and
+        a looping AD is the same cycle over and over: all but the last whole
+        cycle are jumped in one go. In CONTINUOUS mode it matches a render
+        done in one block, other block splits round differently.
+    */
+    float deltaTime = 1.0f / sampleRate;
+
+    while (numSamples > 0)
+    {
+        if (m_currentPhase == SUSTAIN || m_currentPhase == INACTIVE)
+        {
+            m_currentAmplitude = (m_currentPhase == SUSTAIN) ? m_sustainLevel : 0.0f;
+            return;
+        }
+
+        bool isCycleStart = m_currentPhase == ATTACK && m_elapsedSamples == 0;
+        if (isCycleStart && m_isLooping && m_envelopeType == EnvelopeType::AD && m_timingMode == TimingMode::SAMPLE_COUNT)
+        {
+            // looping keeps the full decay, the threshold doesn't shorten it
+            std::uint64_t period = getSegmentLength(m_attackTime, deltaTime) + getSegmentLength(m_decayTime, deltaTime);
+            std::uint64_t cycles = numSamples / period;
+
+            if (cycles > 1)
+            {
+                numSamples -= (cycles - 1) * period;
+            }
+        }
+
+        Segment segment = getSegment();
+
+        double samplesLeft = getSamplesLeft(segment, deltaTime);
+        std::uint64_t runLength = static_cast<std::uint64_t>(std::min(samplesLeft, static_cast<double>(numSamples)));
+
+        // step to the run's last sample and render that one
+        if (m_timingMode == TimingMode::SAMPLE_COUNT)
+        {
+            m_elapsedSamples += runLength - 1;
+        }
+        else
+        {
+            m_elapsedTime += static_cast<float>(runLength - 1) * deltaTime;
+        }
+
+        float lastSample;
+        renderSegment(&lastSample, 1, deltaTime, segment);
+        numSamples -= runLength;
+
+        if (runLength == samplesLeft)
+        {
+            if (segment.endTime < segment.duration)
+            {
+                m_skippedSamples += getSamplesAfterEnd(segment, deltaTime);
+            }
+            finishSegment();
+        }
+    }
+}
+
+void Envelope::applyModulation(const Modulation& modulation, int index)
+{
+    // the setters, without going through them for every sample
+    if (modulation.attackTime)
+    {
+        m_attackTime = modulation.attackTime[index];
+    }
+    if (modulation.attackCurve)
+    {
+        m_attackCurve = scaleCurveNumber(modulation.attackCurve[index]);
+    }
+    if (modulation.decayTime)
+    {
+        m_decayTime = modulation.decayTime[index];
+    }
+    if (modulation.decayCurve)
+    {
+        m_decayCurve = scaleCurveNumber(modulation.decayCurve[index]);
+    }
+    if (modulation.sustainLevel)
+    {
+        m_sustainLevel = modulation.sustainLevel[index];
+    }
+    if (modulation.releaseTime)
+    {
+        m_releaseTime = modulation.releaseTime[index];
+    }
+    if (modulation.releaseCurve)
+    {
+        m_releaseCurve = scaleCurveNumber(modulation.releaseCurve[index]);
+    }
+}
+
+void Envelope::renderSingleSample(const Taps& taps, int index, float deltaTime)
+{
+    // the same steps as a one sample run through renderBlock()
+    Segment segment = getSegment();
+    float startTime = m_elapsedTime;
+    double samplesLeft = getSamplesLeft(segment, deltaTime);
+
+    renderSegment(taps.amplitude + index, 1, deltaTime, segment);
+    renderTaps(taps, index, index + 1, startTime, deltaTime, segment.duration);
+
+    if (samplesLeft > 1.0)
+    {
+        return;
+    }
+
+    if (segment.endTime < segment.duration)
+    {
+        m_skippedSamples += getSamplesAfterEnd(segment, deltaTime);
+    }
+
+    bool endsCycle = isEndOfCycle();
+    finishSegment();
+    taps.amplitude[index] = m_currentAmplitude;
+    renderTapsSample(taps, index, endsCycle);
+}
+
+Envelope::Segment Envelope::getSegment() const
+{
+    // same shapes as calculateAttackPhase() and friends, as offset + scale * pow()
+    switch (m_currentPhase)
+    {
+        case ATTACK:
+        {
+            float peak = (m_envelopeType == EnvelopeType::ASR) ? m_sustainLevel : 1.0f;
+            return Segment{m_attackTime, m_attackTime, m_attackCurve, 0.0f, peak, false};
+        }
+        case DECAY:
+        {
+            float depth = (m_envelopeType == EnvelopeType::ADSR) ? (1.0f - m_sustainLevel) : 1.0f;
+            Segment segment{m_decayTime, m_decayTime, m_decayCurve, 1.0f, -depth, false};
+
+            // the AD decay is a tail too: 1 - t^curve drops below the threshold at t = (1 - threshold)^(1 / curve)
+            if (m_envelopeType == EnvelopeType::AD && !m_isLooping && m_silenceThreshold > 0.0f)
+            {
+                float silentTime = std::pow(std::max(1.0f - m_silenceThreshold, 0.0f), 1.0f / m_decayCurve);
+                segment.endTime = m_decayTime * silentTime;
+            }
+            return segment;
+        }
+        case RELEASE:
+        {
+            Segment segment{m_releaseTime, m_releaseTime, m_releaseCurve, 0.0f, m_releaseLevel, true};
+
+            // level * (1 - t)^curve drops below the threshold at t = 1 - (threshold / level)^(1 / curve),
+            // a looping envelope keeps the full tail so its period doesn't change
+            if (!m_isLooping && m_silenceThreshold > 0.0f)
+            {
+                float ratio = std::min(m_silenceThreshold / m_releaseLevel, 1.0f);
+                segment.endTime = m_releaseTime * (1.0f - std::pow(ratio, 1.0f / m_releaseCurve));
+            }
+            return segment;
+        }
+        default:
+        {
+            // sustain and inactive are constant, renderBlock() never asks for them
+            return Segment{0.0f, 0.0f, 1.0f, m_currentAmplitude, 0.0f, false};
+        }
+    }
+}
+
+void Envelope::renderSegment(float* output, int numSamples, float deltaTime, const Segment& segment)
+{
+    // no phase checks in here, renderBlock() already knows the segment lasts
+    // at least numSamples more, which keeps the loop branch free
+    float base = segment.isFalling ? 1.0f : 0.0f;
+    float direction = segment.isFalling ? -1.0f : 1.0f;
+
+#ifdef ENVELOPE_CURVE_TABLES
+    int curve = findCurveTable(segment.curve);
+    auto shape = [&](float normalizedTime) { return lookupCurve(curve, base + direction * normalizedTime); };
+#else
+    auto shape = [&](float normalizedTime) { return std::pow(base + direction * normalizedTime, segment.curve); };
+#endif
+
+    if (m_timingMode == TimingMode::SAMPLE_COUNT)
+    {
+        // straight from the sample count, however the segment was split into runs
+        std::uint64_t startSample = m_elapsedSamples;
+        double inverseLength = (segment.duration > 0.0f) ? deltaTime / static_cast<double>(segment.duration) : INFINITY;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            float normalizedTime = static_cast<float>(std::min(static_cast<double>(startSample + i + 1) * inverseLength, 1.0));
+            output[i] = segment.offset + segment.scale * shape(normalizedTime);
+        }
+
+        m_elapsedSamples = startSample + numSamples;
+        m_elapsedTime = static_cast<float>(static_cast<double>(m_elapsedSamples) * deltaTime);
+    }
+    else
+    {
+        float startTime = m_elapsedTime;
+        float inverseDuration = (segment.duration > 0.0f) ? 1.0f / segment.duration : INFINITY;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            float normalizedTime = std::min((startTime + (i + 1) * deltaTime) * inverseDuration, 1.0f);
+            output[i] = segment.offset + segment.scale * shape(normalizedTime);
+        }
+
+        m_elapsedTime = startTime + numSamples * deltaTime;
+    }
+
+    m_currentAmplitude = output[numSamples - 1];
+}
+
+void Envelope::finishSegment()
+{
+    bool endsCycle = isEndOfCycle();
+    m_elapsedTime = 0.0f;
+    m_elapsedSamples = 0;
+
+    if (endsCycle)
+    {
+        if (m_isLooping)
+        {
+            m_currentPhase = ATTACK;
+        }
+        else
+        {
+            m_currentPhase = INACTIVE;
+            m_currentAmplitude = 0.0f;
+        }
+    }
+    else if (m_currentPhase == ATTACK && m_envelopeType != EnvelopeType::ASR)
+    {
+        m_currentPhase = DECAY;
+    }
+    else
+    {
+        m_currentPhase = SUSTAIN;
+    }
+}
+
+double Envelope::getSamplesLeft(const Segment& segment, float deltaTime) const
+{
+    // samples until the segment ends, the one that reaches the end included
+    if (m_timingMode == TimingMode::SAMPLE_COUNT)
+    {
+        double length = static_cast<double>(getSegmentLength(segment.endTime, deltaTime));
+        return std::max(length - static_cast<double>(m_elapsedSamples), 1.0);
+    }
+
+    double remaining = std::ceil((segment.endTime - PHASE_END_TOLERANCE - m_elapsedTime) / deltaTime);
+    return std::max(remaining, 1.0);
+}
+
+std::uint64_t Envelope::getSamplesAfterEnd(const Segment& segment, float deltaTime) const
+{
+    // what the rest of the full segment would have taken from where it stopped
+    if (m_timingMode == TimingMode::SAMPLE_COUNT)
+    {
+        std::uint64_t length = getSegmentLength(segment.duration, deltaTime);
+        return (length > m_elapsedSamples) ? length - m_elapsedSamples : 0;
+    }
+
+    double skipped = std::ceil((segment.duration - PHASE_END_TOLERANCE - m_elapsedTime) / deltaTime);
+    return static_cast<std::uint64_t>(std::max(skipped, 0.0));
+}
+
+std::uint64_t Envelope::getSegmentLength(float time, float deltaTime)
+{
+    // whole samples, at least one so a zero length segment still moves on
+    return static_cast<std::uint64_t>(std::max(std::llround(static_cast<double>(time) / deltaTime), 1LL));
+}
+
+bool Envelope::isEndOfCycle() const
+{
+    return m_currentPhase == RELEASE ||
+           (m_currentPhase == DECAY && m_envelopeType == EnvelopeType::AD);
+}
+
+void Envelope::renderTaps(const Taps& taps, int begin, int end, float startTime, float deltaTime, float duration) const
+{
+    if (taps.inverted)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            taps.inverted[i] = 1.0f - taps.amplitude[i];
+        }
+    }
+    if (taps.endOfCycle)
+    {
+        std::fill(taps.endOfCycle + begin, taps.endOfCycle + end, 0.0f);
+    }
+
+    // the phase can't change inside a run, so each gate is one fill
+    float* gates[] = {taps.attackGate, taps.decayGate, taps.sustainGate, taps.releaseGate};
+    Phase gatePhases[] = {ATTACK, DECAY, SUSTAIN, RELEASE};
+
+    for (int gate = 0; gate < 4; gate++)
+    {
+        if (gates[gate])
+        {
+            std::fill(gates[gate] + begin, gates[gate] + end, (m_currentPhase == gatePhases[gate]) ? 1.0f : 0.0f);
+        }
+    }
+
+    if (taps.progress)
+    {
+        if (m_currentPhase == SUSTAIN || m_currentPhase == INACTIVE)
+        {
+            std::fill(taps.progress + begin, taps.progress + end, getProgress());
+            return;
+        }
+
+        // getProgress() is linear within a phase: (time before this phase + elapsed) / cycle time
+        float phaseStart = 0.0f;
+        float cycleTime = m_attackTime + m_releaseTime;
+
+        switch (m_envelopeType)
+        {
+            case EnvelopeType::ADSR:
+                phaseStart = (m_currentPhase == DECAY) ? m_attackTime :
+                             (m_currentPhase == RELEASE) ? m_attackTime + m_decayTime : 0.0f;
+                cycleTime = m_attackTime + m_decayTime + m_releaseTime;
+                break;
+            case EnvelopeType::ASR:
+                phaseStart = (m_currentPhase == RELEASE) ? m_attackTime : 0.0f;
+                break;
+            case EnvelopeType::AD:
+                phaseStart = (m_currentPhase == DECAY) ? m_attackTime : 0.0f;
+                cycleTime = m_attackTime + m_decayTime;
+                break;
+        }
+
+        float inverseCycleTime = 1.0f / cycleTime;
+
+        // counted runs have already moved m_elapsedSamples past the run
+        bool isCounted = m_timingMode == TimingMode::SAMPLE_COUNT && deltaTime > 0.0f;
+        std::uint64_t runStart = m_elapsedSamples - static_cast<std::uint64_t>(end - begin);
+
+        for (int i = begin; i < end; i++)
+        {
+            float runTime = isCounted ? static_cast<float>(static_cast<double>(runStart + (i - begin + 1)) * deltaTime)
+                                      : startTime + (i - begin + 1) * deltaTime;
+            float elapsedTime = std::min(runTime, duration);
+            taps.progress[i] = std::min((phaseStart + elapsedTime) * inverseCycleTime, 1.0f);
+        }
+    }
+}
+
+void Envelope::renderTapsSample(const Taps& taps, int index, bool isEndOfCycle) const
+{
+    // the sample a segment ends on already shows the phase it moved to
+    renderTaps(taps, index, index + 1, m_elapsedTime, 0.0f, 0.0f);
+
+    if (taps.endOfCycle)
+    {
+        taps.endOfCycle[index] = isEndOfCycle ? 1.0f : 0.0f;
+    }
+}
+
 float Envelope::getDuration(float sustain_time) const  // total duration of the envelope
 {
     // needs to take the sustained note as an argument for ADSR and ASR
@@ -515,7 +1117,7 @@ float Envelope::getAmplitudeAtTime(Envelope::Phase phase, float normalizedTime)
         }
         default:
         {
-            std::cerr << "Can not calculate amplitude, invalid envelope phase" << std::endl;
+            // invalid phase, called from the render paths so don't log here
             break;
         }
     }
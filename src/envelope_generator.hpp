@@ -3,6 +3,8 @@
 #ifndef ENVELOPE_GENERATOR_HPP
 #define ENVELOPE_GENERATOR_HPP
 
+#include <cstdint>
+
 /*
     Functionality for an envelope generator
 
@@ -10,6 +12,9 @@
     anything that has to do with a musical envelope.
 */
 
+// bump when a change alters rendered output, cached renders are keyed on it
+constexpr unsigned int ENVELOPE_ENGINE_VERSION = 4;
+
 class Envelope
 {
     public:
@@ -33,6 +38,46 @@ class Envelope
             RELEASE, 
         };
 
+        // how renderBlock() keeps time within a phase, update() always uses seconds
+        enum class TimingMode
+        {
+            CONTINUOUS,     // elapsed seconds, as update() does it
+            SAMPLE_COUNT    // whole samples against each segment's length, the same for any block size
+        };
+
+        // what renderBlock() found out about the block it rendered
+        struct BlockInfo
+        {
+            bool isConstant;        // every sample holds constantValue (sustain or inactive)
+            float constantValue;
+        };
+
+        // signals renderBlock() can write alongside the amplitude, null ones are skipped
+        struct Taps
+        {
+            float* amplitude = nullptr;     // required
+            float* inverted = nullptr;      // 1 - amplitude
+            float* endOfCycle = nullptr;    // 1 on the sample a release (or AD decay) ends, 0 elsewhere
+            float* attackGate = nullptr;    // 1 while in the phase, 0 elsewhere
+            float* decayGate = nullptr;
+            float* sustainGate = nullptr;
+            float* releaseGate = nullptr;
+            float* progress = nullptr;      // getProgress() for every sample
+        };
+
+        // per-sample parameter buffers for renderBlock(), each one non-null replaces the
+        // setting sample by sample, in the units the setters take (curves are -10..10)
+        struct Modulation
+        {
+            const float* attackTime = nullptr;
+            const float* attackCurve = nullptr;
+            const float* decayTime = nullptr;
+            const float* decayCurve = nullptr;
+            const float* sustainLevel = nullptr;
+            const float* releaseTime = nullptr;
+            const float* releaseCurve = nullptr;
+        };
+
         // setters
         void setAttackTime(float attackTime);
         void setAttackCurve(float curve);
@@ -43,6 +88,8 @@ class Envelope
         void setReleaseCurve(float curve);
         void setLooping(bool isLooping);
         void setEnvelopeType(EnvelopeType type);
+        void setSilenceThreshold(float decibels);  // end non-looping tails early below this, -INFINITY = never
+        void setTimingMode(TimingMode mode);
 
         // getters
         float getAttackTime() const;
@@ -54,6 +101,9 @@ class Envelope
         float getReleaseCurve() const;
 
         EnvelopeType getEnvelopeType() const;
+        float getSilenceThreshold() const;          // in dBFS
+        TimingMode getTimingMode() const;
+        std::uint64_t getSkippedSampleCount() const; // samples renderBlock() didn't render thanks to the threshold
         Phase getPhase() const;
 
         float getAmplitude() const;
@@ -74,11 +124,45 @@ class Envelope
         void release();             // finish an envelope (note = OFF)
         void reset();               // reset envelope back to init state
         void update(float deltaTime);
+        BlockInfo renderBlock(float* output, int numSamples, float sampleRate);  // one amplitude per sample, no allocations
+        BlockInfo renderBlock(const Taps& taps, int numSamples, float sampleRate);  // every requested tap in the same pass
+        BlockInfo renderBlock(const Taps& taps, const Modulation& modulation, int numSamples, float sampleRate);  // settings keep the last modulated values
+        void advance(std::uint64_t numSamples, float sampleRate);  // renderBlock() without the output, a segment at a time (exact with SAMPLE_COUNT)
 
     private:
+        friend class SegmentEncoder;    // writes down the segments advance() goes through
 
         float scaleCurveNumber(float input);
 
+        // an attack, decay or release run: offset + scale * pow(t, curve),
+        // falling segments use 1 - t in place of t
+        struct Segment
+        {
+            float duration;
+            float endTime;          // duration, or earlier when the tail drops below the silence threshold
+            float curve;
+            float offset;
+            float scale;
+            bool isFalling;
+        };
+
+        Segment getSegment() const;
+        void renderSegment(float* output, int numSamples, float deltaTime, const Segment& segment);
+        void finishSegment();       // move on to the next phase once a segment has run out
+        double getSamplesLeft(const Segment& segment, float deltaTime) const;   // at least 1
+        std::uint64_t getSamplesAfterEnd(const Segment& segment, float deltaTime) const;   // of the full duration
+        static std::uint64_t getSegmentLength(float time, float deltaTime);     // in samples
+        bool isEndOfCycle() const;  // finishing the current segment ends the cycle
+
+        // the taps other than amplitude for samples [begin, end) of the current phase,
+        // startTime is the elapsed time before sample begin
+        void renderTaps(const Taps& taps, int begin, int end, float startTime, float deltaTime, float duration) const;
+        void renderTapsSample(const Taps& taps, int index, bool isEndOfCycle) const;
+        void renderSingleSample(const Taps& taps, int index, float deltaTime);  // renderBlock() for one sample, minus the run setup
+        void applyModulation(const Modulation& modulation, int index);
+
+        static constexpr float PHASE_END_TOLERANCE = 0.0001f;
+
         EnvelopeType m_envelopeType;
         Phase m_currentPhase;
 
@@ -94,9 +178,15 @@ class Envelope
         float m_releaseCurve;
 
         float m_currentAmplitude;
+        float m_releaseLevel;       // amplitude when release() was called
         float m_elapsedTime;
+        std::uint64_t m_elapsedSamples;     // renderBlock() with TimingMode::SAMPLE_COUNT
+        TimingMode m_timingMode;
         
         bool m_isLooping;
+
+        float m_silenceThreshold;   // linear, 0 = off
+        std::uint64_t m_skippedSamples;
 };
 
 #endif // ENVELOPE_GENERATOR_HPP
\ No newline at end of file
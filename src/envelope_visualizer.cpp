@@ -6,6 +6,8 @@
 #include "theme.hpp"
 #include "envelope_visualizer.hpp"
 #include "envelope_generator.hpp"
+#include "render_stats.hpp"
+#include "trace.hpp"
 
 // constructor for the envelope generator app
 EnvelopeVisualizer::EnvelopeVisualizer(const Envelope& envelope)
@@ -69,6 +71,8 @@ EnvelopeVisualizer::~EnvelopeVisualizer() {}
 
 void EnvelopeVisualizer::update(const Envelope& envelope)
 {
+    TRACE_SCOPE("EnvelopeVisualizer::update");
+
     // Recalculate envelope shape based on updated parameters
     calculateEnvelopeShape(envelope);
 
@@ -80,6 +84,11 @@ void EnvelopeVisualizer::update(const Envelope& envelope)
     positionPhaseRectangles(envelope);
     positionPhaseDividers(envelope);
 
+    // every curve and divider is regenerated each frame, plus the two gauge points
+    RenderStats::countRebuiltVertices(m_attackCurve.getVertexCount() + m_decayCurve.getVertexCount() +
+                                      m_sustainLine.getVertexCount() + m_releaseCurve.getVertexCount() +
+                                      m_phaseDividers.getVertexCount() + 2);
+
     // Color animation to show the current envelope phase
     sf::Color color = sf::Color::Magenta;
 
@@ -133,29 +142,31 @@ void EnvelopeVisualizer::update(const Envelope& envelope)
     }
 }
 
-void EnvelopeVisualizer::draw(sf::RenderWindow& window)
+void EnvelopeVisualizer::draw(sf::RenderTarget& target)
 {
-    window.draw(m_background);
+    TRACE_SCOPE("EnvelopeVisualizer::draw");
+
+    drawCounted(target, m_background);
     
-    window.draw(m_xGauge);
-    window.draw(m_xIndicator);
+    drawCounted(target, m_xGauge);
+    drawCounted(target, m_xIndicator);
 
-    window.draw(m_yGauge);
-    window.draw(m_yIndicator);
+    drawCounted(target, m_yGauge);
+    drawCounted(target, m_yIndicator);
 
-    window.draw(m_attackRect);
-    window.draw(m_decayRect);
-    window.draw(m_sustainRect);
-    window.draw(m_releaseRect);
+    drawCounted(target, m_attackRect);
+    drawCounted(target, m_decayRect);
+    drawCounted(target, m_sustainRect);
+    drawCounted(target, m_releaseRect);
 
-    window.draw(m_phaseDividers);
+    drawCounted(target, m_phaseDividers);
     
-    window.draw(m_attackCurve);
-    window.draw(m_decayCurve);
-    window.draw(m_sustainLine);
-    window.draw(m_releaseCurve);
+    drawCounted(target, m_attackCurve);
+    drawCounted(target, m_decayCurve);
+    drawCounted(target, m_sustainLine);
+    drawCounted(target, m_releaseCurve);
 
-    window.draw(m_envelopeIndicator);
+    drawCounted(target, m_envelopeIndicator);
 }
 
 void EnvelopeVisualizer::setPosition(sf::Vector2f position, sf::Vector2f size, const Envelope& envelope)
@@ -203,6 +214,10 @@ void EnvelopeVisualizer::setPosition(sf::Vector2f position, sf::Vector2f size, c
 }
 void EnvelopeVisualizer::calculateEnvelopeShape(const Envelope& envelope)
 {
+    TRACE_SCOPE("calculateEnvelopeShape");
+
+    // clear() keeps the capacity, unused curves are emptied
+    // and the generators below refill the rest in place
     m_attackCurve.clear();
     m_decayCurve.clear();
     m_sustainLine.clear();
@@ -286,18 +301,19 @@ void EnvelopeVisualizer::generateAttackCurve(const Envelope& envelope)
 
     float sustainLevel = envelope.getSustainLevel();
 
-    int numSegments = 100;  // higher number = smoother curve
+    // sized in place, the vertex storage is reused between frames
+    m_attackCurve.resize(CURVE_SEGMENTS);
 
-    for (int i = 0; i < numSegments; i++)
+    for (int i = 0; i < CURVE_SEGMENTS; i++)
     {
         // t goes from 0 to 1 as i progresses
-        float t = static_cast<float>(i) / numSegments;
+        float t = static_cast<float>(i) / CURVE_SEGMENTS;
 
         float y = envelope.getAmplitudeAtTime(Envelope::Phase::ATTACK, t);
 
         // plot points
         sf::Vector2f point(rightX + t * width, topY + (1 - y) * height);    
-        m_attackCurve.append(sf::Vertex(point, m_lineColor));
+        m_attackCurve[i] = sf::Vertex(point, m_lineColor);
     }
 }
 void EnvelopeVisualizer::generateDecayCurve(const Envelope& envelope)
@@ -313,17 +329,18 @@ void EnvelopeVisualizer::generateDecayCurve(const Envelope& envelope)
 
     float sustainLevel = envelope.getSustainLevel();
 
-    int numSegments = 100;  // higher number = smoother curve
+    // sized in place, the vertex storage is reused between frames
+    m_decayCurve.resize(CURVE_SEGMENTS);
 
-    for (int i = 0; i < numSegments; i++)
+    for (int i = 0; i < CURVE_SEGMENTS; i++)
     {
         // t goes from 0 to 1 as i progresses
-        float t = static_cast<float>(i) / numSegments;
+        float t = static_cast<float>(i) / CURVE_SEGMENTS;
 
         float y = envelope.getAmplitudeAtTime(Envelope::Phase::DECAY, t);
 
         sf::Vector2f point(rightX + t * width, topY + (1 - y) * height);
-        m_decayCurve.append(sf::Vertex(point, m_lineColor));
+        m_decayCurve[i] = sf::Vertex(point, m_lineColor);
     }
 }
 void EnvelopeVisualizer::generateSustainLine(const Envelope& envelope)
@@ -342,8 +359,9 @@ void EnvelopeVisualizer::generateSustainLine(const Envelope& envelope)
     sf::Vector2f startPoint(xStart, yLevel);
     sf::Vector2f endPoint(xEnd, yLevel);
 
-    m_sustainLine.append(sf::Vertex(startPoint, m_lineColor));
-    m_sustainLine.append(sf::Vertex(endPoint, m_lineColor));
+    m_sustainLine.resize(2);
+    m_sustainLine[0] = sf::Vertex(startPoint, m_lineColor);
+    m_sustainLine[1] = sf::Vertex(endPoint, m_lineColor);
 }
 void EnvelopeVisualizer::generateReleaseCurve(const Envelope& envelope)
 {
@@ -357,22 +375,25 @@ void EnvelopeVisualizer::generateReleaseCurve(const Envelope& envelope)
 
     float sustainLevel = envelope.getSustainLevel();
 
-    int numSegments = 100;  // higher number = smoother curve
+    // sized in place, the vertex storage is reused between frames
+    m_releaseCurve.resize(CURVE_SEGMENTS);
 
-    for (int i = 0; i < numSegments; i++)
+    for (int i = 0; i < CURVE_SEGMENTS; i++)
     {
         // t goes from 0 to 1 as i progresses
-        float t = static_cast<float>(i) / numSegments;
+        float t = static_cast<float>(i) / CURVE_SEGMENTS;
 
         float y = envelope.getAmplitudeAtTime(Envelope::Phase::RELEASE, t);
 
         sf::Vector2f point(rightX + t * width, topY + (1 - y) * height);
-        m_releaseCurve.append(sf::Vertex(point, m_lineColor));
+        m_releaseCurve[i] = sf::Vertex(point, m_lineColor);
     }
 }
 
 void EnvelopeVisualizer::positionPhaseRectangles(const Envelope& envelope)
 {
+    TRACE_SCOPE("positionPhaseRectangles");
+
     float rightX = m_envelopeContainer.getPosition().x;
     float topY = m_envelopeContainer.getPosition().y;
     float width = m_envelopeContainer.getSize().x;
@@ -480,6 +501,8 @@ void EnvelopeVisualizer::positionPhaseRectangles(const Envelope& envelope)
 }
 void EnvelopeVisualizer::positionPhaseDividers(const Envelope& envelope)
 {
+    TRACE_SCOPE("positionPhaseDividers");
+
     float topY = m_envelopeContainer.getPosition().y;
     float bottomY = m_envelopeContainer.getPosition().y + m_envelopeContainer.getSize().y;
 
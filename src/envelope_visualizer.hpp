@@ -16,7 +16,7 @@ class EnvelopeVisualizer
         ~EnvelopeVisualizer();
 
         void update(const Envelope& envelope);  // update envelope visualizer based on envelope
-        void draw(sf::RenderWindow& window);    // draw visualizer and progress animation
+        void draw(sf::RenderTarget& target);    // draw visualizer and progress animation
 
         void setPosition(sf::Vector2f position, sf::Vector2f size, const Envelope& envelope);
 
@@ -61,6 +61,8 @@ class EnvelopeVisualizer
         void generateSustainLine(const Envelope& envelope);
         void generateReleaseCurve(const Envelope& envelope);
 
+        static constexpr int CURVE_SEGMENTS = 100;  // higher number = smoother curve
+
         // color parameters
         sf::Color m_backgroundColor;
         sf::Color m_borderColor;
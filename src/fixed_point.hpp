@@ -0,0 +1,67 @@
+#ifndef FIXED_POINT_HPP
+#define FIXED_POINT_HPP
+
+#include <cmath>
+#include <cstdint>
+
+/*
+    Signed Q-format fixed point in 32 bits, FRACTION_BITS of them after
+    the binary point. Products and quotients go through 64 bits and
+    truncate, nothing saturates, so values have to stay in range:
+
+        FixedPoint<20>  Q11.20  range +-2048, resolution ~9.5e-7
+
+    Q11.20 is what the fixed point envelope uses for levels and
+    normalized time, which sit in [0, 1] with room to spare.
+*/
+
+template <int FRACTION_BITS>
+class FixedPoint
+{
+    public:
+        static constexpr std::int32_t ONE = std::int32_t(1) << FRACTION_BITS;
+
+        constexpr FixedPoint() : m_raw(0) {}
+
+        static constexpr FixedPoint fromRaw(std::int32_t raw)
+        {
+            FixedPoint value;
+            value.m_raw = raw;
+            return value;
+        }
+        static FixedPoint fromDouble(double value)
+        {
+            return fromRaw(static_cast<std::int32_t>(std::llround(value * ONE)));
+        }
+
+        constexpr std::int32_t raw() const { return m_raw; }
+        constexpr double toDouble() const { return static_cast<double>(m_raw) / ONE; }
+        constexpr float toFloat() const { return static_cast<float>(m_raw) / ONE; }
+
+        constexpr FixedPoint operator+(FixedPoint other) const { return fromRaw(m_raw + other.m_raw); }
+        constexpr FixedPoint operator-(FixedPoint other) const { return fromRaw(m_raw - other.m_raw); }
+        constexpr FixedPoint operator-() const { return fromRaw(-m_raw); }
+
+        constexpr FixedPoint operator*(FixedPoint other) const
+        {
+            return fromRaw(static_cast<std::int32_t>((static_cast<std::int64_t>(m_raw) * other.m_raw) >> FRACTION_BITS));
+        }
+        constexpr FixedPoint operator/(FixedPoint other) const
+        {
+            return fromRaw(static_cast<std::int32_t>((static_cast<std::int64_t>(m_raw) << FRACTION_BITS) / other.m_raw));
+        }
+
+        constexpr bool operator==(FixedPoint other) const { return m_raw == other.m_raw; }
+        constexpr bool operator!=(FixedPoint other) const { return m_raw != other.m_raw; }
+        constexpr bool operator<(FixedPoint other) const { return m_raw < other.m_raw; }
+        constexpr bool operator>(FixedPoint other) const { return m_raw > other.m_raw; }
+        constexpr bool operator<=(FixedPoint other) const { return m_raw <= other.m_raw; }
+        constexpr bool operator>=(FixedPoint other) const { return m_raw >= other.m_raw; }
+
+    private:
+        std::int32_t m_raw;
+};
+
+using EnvelopeFixed = FixedPoint<20>;
+
+#endif // FIXED_POINT_HPP
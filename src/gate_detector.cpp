@@ -0,0 +1,123 @@
+#include "gate_detector.hpp"
+#include "gate_timeline.hpp"
+#include "simd.hpp"
+
+namespace
+{
+    // first index in [start, end) with gate[i] >= level when isRising, gate[i] < level otherwise
+    int scanForLevel(const float* gate, int start, int end, float level, bool isRising)
+    {
+        int i = start;
+
+#ifdef ENVELOPE_SSE2
+        // gates sit still most of the time, so check 16 samples per branch
+        // and only work out the exact position once something turned up
+        __m128 levels = _mm_set1_ps(level);
+
+        for (; i + 16 <= end; i += 16)
+        {
+            __m128 a = _mm_loadu_ps(gate + i);
+            __m128 b = _mm_loadu_ps(gate + i + 4);
+            __m128 c = _mm_loadu_ps(gate + i + 8);
+            __m128 d = _mm_loadu_ps(gate + i + 12);
+
+            __m128 found = isRising
+                ? _mm_or_ps(_mm_or_ps(_mm_cmpge_ps(a, levels), _mm_cmpge_ps(b, levels)),
+                            _mm_or_ps(_mm_cmpge_ps(c, levels), _mm_cmpge_ps(d, levels)))
+                : _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(a, levels), _mm_cmplt_ps(b, levels)),
+                            _mm_or_ps(_mm_cmplt_ps(c, levels), _mm_cmplt_ps(d, levels)));
+
+            if (_mm_movemask_ps(found) != 0)
+            {
+                break;
+            }
+        }
+#endif
+
+        for (; i < end; i++)
+        {
+            if (isRising ? gate[i] >= level : gate[i] < level)
+            {
+                return i;
+            }
+        }
+        return end;
+    }
+}
+
+GateDetector::GateDetector(float threshold, float hysteresis)
+: m_threshold(threshold)
+, m_hysteresis(hysteresis)
+, m_isHigh(false)
+{
+    updateLevels();
+}
+
+void GateDetector::setThreshold(float threshold)
+{
+    m_threshold = threshold;
+    updateLevels();
+}
+void GateDetector::setHysteresis(float hysteresis)
+{
+    m_hysteresis = hysteresis;
+    updateLevels();
+}
+void GateDetector::reset()
+{
+    m_isHigh = false;
+}
+
+bool GateDetector::isHigh() const
+{
+    return m_isHigh;
+}
+
+int GateDetector::findNextEdge(const float* gate, int start, int numSamples)
+{
+    int edge = m_isHigh ? scanForLevel(gate, start, numSamples, m_offLevel, false)
+                        : scanForLevel(gate, start, numSamples, m_onLevel, true);
+
+    if (edge < numSamples)
+    {
+        m_isHigh = !m_isHigh;
+    }
+    return edge;
+}
+
+void GateDetector::updateLevels()
+{
+    float halfWidth = (m_hysteresis > 0.0f) ? m_hysteresis * 0.5f : 0.0f;
+
+    m_onLevel = m_threshold + halfWidth;
+    m_offLevel = m_threshold - halfWidth;
+}
+
+Envelope::BlockInfo renderGatedBlock(Envelope& envelope, GateDetector& detector, const float* gate,
+                                     float* output, int numSamples, float sampleRate)
+{
+    int position = 0;
+    int scanStart = 0;
+
+    while (true)
+    {
+        int edge = detector.findNextEdge(gate, scanStart, numSamples);
+
+        // render up to the edge, then apply it so the edge sample already follows it
+        Envelope::BlockInfo info{false, 0.0f};
+        if (edge > position)
+        {
+            info = envelope.renderBlock(output + position, edge - position, sampleRate);
+        }
+
+        if (edge == numSamples)
+        {
+            // only a block without edges can be constant throughout
+            return (scanStart == 0) ? info : Envelope::BlockInfo{false, 0.0f};
+        }
+
+        applyGateEdge(envelope, detector.isHigh());
+        position = edge;
+        scanStart = edge + 1;   // the sample that caused an edge can't cause the next one
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef GATE_DETECTOR_HPP
+#define GATE_DETECTOR_HPP
+
+#include "envelope_generator.hpp"
+
+/*
+    Turns an audio-rate gate signal into gate on/off edges.
+
+    The gate goes high when the signal reaches threshold + hysteresis / 2
+    and low again when it drops below threshold - hysteresis / 2, so a noisy
+    signal sitting near the threshold doesn't chatter.
+
+    Edges are found by scanning for the first sample past the level the
+    current state is waiting for. With SSE2 (ENVELOPE_USE_SIMD) the scan
+    compares 16 samples, four vectors, per branch and finds the exact
+    sample one at a time once a group has one past the level.
+*/
+
+class GateDetector
+{
+    public:
+        GateDetector(float threshold = 0.5f, float hysteresis = 0.1f);
+
+        void setThreshold(float threshold);
+        void setHysteresis(float hysteresis);
+        void reset();       // back to gate low
+
+        bool isHigh() const;
+
+        // index of the first sample in [start, numSamples) that flips the gate,
+        // numSamples if there isn't one, the state is flipped when an edge is found
+        int findNextEdge(const float* gate, int start, int numSamples);
+
+    private:
+        void updateLevels();
+
+        float m_threshold;
+        float m_hysteresis;
+        float m_onLevel;
+        float m_offLevel;
+        bool m_isHigh;
+};
+
+// renderBlock() driven by a gate signal, edges trigger and release the envelope on the sample they happen
+Envelope::BlockInfo renderGatedBlock(Envelope& envelope, GateDetector& detector, const float* gate,
+                                     float* output, int numSamples, float sampleRate);
+
+#endif // GATE_DETECTOR_HPP
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "gate_timeline.hpp"
+
+namespace
+{
+    std::uint64_t secondsToSamples(double seconds, float sampleRate)
+    {
+        return static_cast<std::uint64_t>(std::llround(std::max(seconds, 0.0) * sampleRate));
+    }
+
+    // renderBlock() takes an int count, long spans go in pieces,
+    // automated ones in blocks the player can fill
+    void renderSpan(Envelope& envelope, float* output, std::uint64_t numSamples, float sampleRate, AutomationPlayer* player)
+    {
+        const std::uint64_t maxBlock = player ? AutomationPlayer::MAX_BLOCK_SIZE : 1 << 20;
+        Envelope::Taps taps;
+
+        while (numSamples > 0)
+        {
+            std::uint64_t count = std::min(numSamples, maxBlock);
+
+            if (player)
+            {
+                taps.amplitude = output;
+                envelope.renderBlock(taps, player->renderBlock(static_cast<int>(count)), static_cast<int>(count), sampleRate);
+            }
+            else
+            {
+                envelope.renderBlock(output, static_cast<int>(count), sampleRate);
+            }
+            output += count;
+            numSamples -= count;
+        }
+    }
+}
+
+bool loadGateTimelines(const std::string& path, float sampleRate, std::vector<GateTimeline>& timelines)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open gate timelines " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+
+        std::istringstream fields(line);
+        GateTimeline timeline;
+        double length = 0.0;
+
+        if (!(fields >> timeline.name) || timeline.name[0] == '#')
+        {
+            continue;   // blank line or comment
+        }
+        if (!(fields >> length))
+        {
+            std::cerr << path << ":" << lineNumber << ": missing timeline length" << std::endl;
+            return false;
+        }
+        timeline.lengthSamples = secondsToSamples(length, sampleRate);
+
+        double on = 0.0;
+        while (fields >> on)
+        {
+            double off = 0.0;
+            if (!(fields >> off) || off < on)
+            {
+                std::cerr << path << ":" << lineNumber << ": gate on at " << on << " needs a later gate off" << std::endl;
+                return false;
+            }
+            timeline.events.push_back({secondsToSamples(on, sampleRate), true});
+            timeline.events.push_back({secondsToSamples(off, sampleRate), false});
+        }
+
+        std::stable_sort(timeline.events.begin(), timeline.events.end(),
+            [](const GateEvent& a, const GateEvent& b) { return a.sample < b.sample; });
+
+        timelines.push_back(timeline);
+    }
+
+    return true;
+}
+
+void applyGateEdge(Envelope& envelope, bool isOn)
+{
+    // same rules as the trigger button in AppManager::update()
+    if (isOn)
+    {
+        if (!envelope.isActive())
+        {
+            envelope.trigger();
+        }
+    }
+    else if (envelope.getPhase() == Envelope::ATTACK ||
+             envelope.getPhase() == Envelope::DECAY ||
+             envelope.getPhase() == Envelope::SUSTAIN)
+    {
+        envelope.release();
+    }
+}
+
+void renderGateTimeline(Envelope& envelope, const GateTimeline& timeline, float sampleRate, float* output,
+                        const std::vector<AutomationLane>& automation)
+{
+    envelope.reset();
+
+    std::unique_ptr<AutomationPlayer> player;
+    if (!automation.empty())
+    {
+        player = std::make_unique<AutomationPlayer>(automation);
+    }
+
+    std::uint64_t position = 0;
+
+    for (const GateEvent& event : timeline.events)
+    {
+        std::uint64_t eventSample = std::min(event.sample, timeline.lengthSamples);
+
+        // render up to the edge, then apply it so it's sample accurate
+        renderSpan(envelope, output + position, eventSample - position, sampleRate, player.get());
+        position = eventSample;
+
+        applyGateEdge(envelope, event.isOn);
+    }
+
+    renderSpan(envelope, output + position, timeline.lengthSamples - position, sampleRate, player.get());
+}
+
+std::uint64_t renderGateTimelineRange(Envelope& envelope, const GateTimeline& timeline, float sampleRate,
+                                      std::uint64_t begin, std::uint64_t end, float* output)
+{
+    envelope.reset();
+
+    end = std::min(end, timeline.lengthSamples);
+    begin = std::min(begin, end);
+
+    std::uint64_t position = 0;
+    std::uint64_t skippedBefore = envelope.getSkippedSampleCount();
+
+    // edges before begin only move the state along, from begin on it's rendered
+    auto moveTo = [&](std::uint64_t target)
+    {
+        if (position < begin)
+        {
+            std::uint64_t stop = std::min(target, begin);
+            envelope.advance(stop - position, sampleRate);
+            position = stop;
+            skippedBefore = envelope.getSkippedSampleCount();
+        }
+        if (position < target)
+        {
+            renderSpan(envelope, output + (position - begin), target - position, sampleRate, nullptr);
+            position = target;
+        }
+    };
+
+    for (const GateEvent& event : timeline.events)
+    {
+        std::uint64_t eventSample = std::min(event.sample, end);
+        moveTo(eventSample);
+
+        if (eventSample == end)
+        {
+            break;  // edges from here on only matter to later ranges
+        }
+        applyGateEdge(envelope, event.isOn);
+    }
+
+    moveTo(end);
+
+    return envelope.getSkippedSampleCount() - skippedBefore;
+}
@@ -0,0 +1,52 @@
+#ifndef GATE_TIMELINE_HPP
+#define GATE_TIMELINE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "automation.hpp"
+#include "envelope_generator.hpp"
+
+/*
+    A gate timeline is a list of gate on/off edges at sample positions,
+    the offline version of holding down the trigger button.
+
+    Timeline files are text, one timeline per line:
+
+        <name> <length in seconds> [<gate on> <gate off>]...
+
+    Times are in seconds. Blank lines and lines starting with # are ignored.
+*/
+
+struct GateEvent
+{
+    std::uint64_t sample;   // position of the edge
+    bool isOn;              // true = gate on (trigger), false = gate off (release)
+};
+
+struct GateTimeline
+{
+    std::string name;
+    std::uint64_t lengthSamples;
+    std::vector<GateEvent> events;  // sorted by sample
+};
+
+bool loadGateTimelines(const std::string& path, float sampleRate, std::vector<GateTimeline>& timelines);
+
+// trigger() or release() for a gate edge, ignoring edges that don't apply in the current phase
+void applyGateEdge(Envelope& envelope, bool isOn);
+
+// resets the envelope, then renders timeline.lengthSamples samples into output,
+// parameters with an automation lane follow it instead of their setting
+void renderGateTimeline(Envelope& envelope, const GateTimeline& timeline, float sampleRate, float* output,
+                        const std::vector<AutomationLane>& automation = {});
+
+// renderGateTimeline() for samples [begin, end) only, written to output[0, end - begin),
+// returns the samples the silence threshold skipped in the range. The envelope is brought
+// up to begin with Envelope::advance(), so with TimingMode::SAMPLE_COUNT the ranges of a
+// timeline can be rendered in any order, on any thread, and still match a full render
+std::uint64_t renderGateTimelineRange(Envelope& envelope, const GateTimeline& timeline, float sampleRate,
+                                      std::uint64_t begin, std::uint64_t end, float* output);
+
+#endif // GATE_TIMELINE_HPP
@@ -0,0 +1,33 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+    64-bit FNV-1a. Stable across runs and platforms,
+    used for preset name lookups and on-disk keys.
+*/
+
+constexpr std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+inline std::uint64_t fnv1a64(const void* data, std::size_t size, std::uint64_t hash = FNV_OFFSET_BASIS)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+inline std::uint64_t fnv1a64(const std::string& text, std::uint64_t hash = FNV_OFFSET_BASIS)
+{
+    return fnv1a64(text.data(), text.size(), hash);
+}
+
+#endif // HASH_HPP
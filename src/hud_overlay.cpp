@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "hud_overlay.hpp"
+#include "render_stats.hpp"
+#include "trace.hpp"
+
+namespace
+{
+    const float PADDING = 6.0f;
+    const float GRAPH_HEIGHT = 64.0f;
+    const float GRAPH_RANGE = 0.050f;       // seconds at the top of the graph
+    const float PIXEL = 2.0f;               // font pixel size
+    const float LINE_HEIGHT = 7.0f * PIXEL;
+    const int LINE_COUNT = 4;
+
+    const sf::Color PANEL_COLOR(0, 0, 0, 170);
+    const sf::Color GUIDE_COLOR(255, 255, 255, 60);
+    const sf::Color TEXT_COLOR(230, 230, 230);
+
+    // 3x5 glyphs, rows top to bottom
+    struct Glyph
+    {
+        char character;
+        const char* pixels;
+    };
+
+    const Glyph GLYPHS[] =
+    {
+        {'0', "111101101101111"}, {'1', "010110010010111"}, {'2', "111001111100111"},
+        {'3', "111001111001111"}, {'4', "101101111001001"}, {'5', "111100111001111"},
+        {'6', "111100111101111"}, {'7', "111001001010010"}, {'8', "111101111101111"},
+        {'9', "111101111001111"}, {'A', "010101111101101"}, {'B', "110101110101110"},
+        {'C', "011100100100011"}, {'D', "110101101101110"}, {'E', "111100110100111"},
+        {'F', "111100110100100"}, {'G', "011100101101011"}, {'H', "101101111101101"},
+        {'I', "111010010010111"}, {'J', "001001001101010"}, {'K', "101101110101101"},
+        {'L', "100100100100111"}, {'M', "101111111101101"}, {'N', "110101101101101"},
+        {'O', "010101101101010"}, {'P', "110101110100100"}, {'Q', "010101101110011"},
+        {'R', "110101110101101"}, {'S', "011100010001110"}, {'T', "111010010010010"},
+        {'U', "101101101101111"}, {'V', "101101101101010"}, {'W', "101101111111101"},
+        {'X', "101101010101101"}, {'Y', "101101010010010"}, {'Z', "111001010100111"},
+        {'.', "000000000000010"}, {':', "000010000010000"}, {'/', "001001010100100"},
+        {'-', "000000111000000"}, {'%', "101001010100101"},
+    };
+
+    const char* findGlyph(char character)
+    {
+        for (const Glyph& glyph : GLYPHS)
+        {
+            if (glyph.character == character)
+            {
+                return glyph.pixels;
+            }
+        }
+        return nullptr;     // space and anything unknown
+    }
+
+    sf::Color getFrameColor(float frameTime)
+    {
+        if (frameTime <= 1.0f / 55.0f)
+        {
+            return sf::Color(80, 200, 100);
+        }
+        if (frameTime <= 1.0f / 28.0f)
+        {
+            return sf::Color(230, 200, 60);
+        }
+        return sf::Color(230, 70, 60);
+    }
+
+    sf::Color darken(sf::Color color)
+    {
+        return sf::Color(color.r / 2, color.g / 2, color.b / 2);
+    }
+}
+
+HudOverlay::HudOverlay()
+: m_frameTimes{}
+, m_cpuTimes{}
+, m_envelopeTimes{}
+, m_visualizerTimes{}
+, m_sorted{}
+, m_next(0)
+, m_count(0)
+, m_drawCalls(0)
+, m_rebuiltVertices(0)
+, m_position(0.0f, 0.0f)
+, m_vertices(sf::Triangles)
+, m_isVisible(false)
+{
+}
+
+void HudOverlay::setPosition(sf::Vector2f position)
+{
+    m_position = position;
+}
+
+sf::Vector2f HudOverlay::getSize() const
+{
+    return sf::Vector2f(HISTORY + 2.0f * PADDING, GRAPH_HEIGHT + 3.0f * PADDING + LINE_COUNT * LINE_HEIGHT);
+}
+
+void HudOverlay::toggle()
+{
+    m_isVisible = !m_isVisible;
+}
+
+bool HudOverlay::isVisible() const
+{
+    return m_isVisible;
+}
+
+void HudOverlay::addFrame(float frameTime, float cpuTime, float envelopeTime, float visualizerTime,
+                          std::size_t drawCalls, std::size_t rebuiltVertices)
+{
+    m_frameTimes[m_next] = frameTime;
+    m_cpuTimes[m_next] = cpuTime;
+    m_envelopeTimes[m_next] = envelopeTime;
+    m_visualizerTimes[m_next] = visualizerTime;
+    m_next = (m_next + 1) % HISTORY;
+    m_count = std::min(m_count + 1, HISTORY);
+
+    m_drawCalls = drawCalls;
+    m_rebuiltVertices = rebuiltVertices;
+}
+
+void HudOverlay::draw(sf::RenderTarget& target)
+{
+    if (!m_isVisible)
+    {
+        return;
+    }
+
+    TRACE_SCOPE("HudOverlay::draw");
+    rebuild();
+    drawCounted(target, m_vertices);
+}
+
+void HudOverlay::rebuild()
+{
+    m_vertices.clear();     // keeps the storage
+
+    sf::Vector2f size = getSize();
+    addRect(m_position.x, m_position.y, size.x, size.y, PANEL_COLOR);
+
+    // graph, oldest frame on the left
+    float left = m_position.x + PADDING;
+    float bottom = m_position.y + PADDING + GRAPH_HEIGHT;
+    float scale = GRAPH_HEIGHT / GRAPH_RANGE;
+    for (int i = 0; i < m_count; i++)
+    {
+        int index = (m_next - m_count + i + HISTORY) % HISTORY;
+        float frameHeight = std::min(m_frameTimes[index] * scale, GRAPH_HEIGHT);
+        float cpuHeight = std::min(m_cpuTimes[index] * scale, frameHeight);
+        float x = left + HISTORY - m_count + i;
+        sf::Color color = getFrameColor(m_frameTimes[index]);
+
+        addRect(x, bottom - frameHeight, 1.0f, frameHeight - cpuHeight, color);
+        addRect(x, bottom - cpuHeight, 1.0f, cpuHeight, darken(color));
+    }
+    addRect(left, bottom - scale / 60.0f, HISTORY, 1.0f, GUIDE_COLOR);
+    addRect(left, bottom - scale / 30.0f, HISTORY, 1.0f, GUIDE_COLOR);
+
+    // percentiles over the history, nearest rank
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    if (m_count > 0)
+    {
+        std::copy(m_frameTimes.begin(), m_frameTimes.begin() + m_count, m_sorted.begin());
+        std::sort(m_sorted.begin(), m_sorted.begin() + m_count);
+        p50 = m_sorted[(m_count - 1) * 50 / 100];
+        p95 = m_sorted[(m_count - 1) * 95 / 100];
+        p99 = m_sorted[(m_count - 1) * 99 / 100];
+    }
+
+    int last = (m_next - 1 + HISTORY) % HISTORY;
+    char line[64];
+    float y = bottom + PADDING;
+
+    std::snprintf(line, sizeof(line), "FRAME %.1f MS  CPU %.1f MS",
+                  m_frameTimes[last] * 1000.0f, m_cpuTimes[last] * 1000.0f);
+    addText(left, y, line, TEXT_COLOR);
+    y += LINE_HEIGHT;
+
+    std::snprintf(line, sizeof(line), "P50 %.1f  P95 %.1f  P99 %.1f", p50 * 1000.0f, p95 * 1000.0f, p99 * 1000.0f);
+    addText(left, y, line, TEXT_COLOR);
+    y += LINE_HEIGHT;
+
+    std::snprintf(line, sizeof(line), "DRAW %zu  VERTS %zu", m_drawCalls, m_rebuiltVertices);
+    addText(left, y, line, TEXT_COLOR);
+    y += LINE_HEIGHT;
+
+    std::snprintf(line, sizeof(line), "ENV %.1f US  VIS %.1f US",
+                  getMean(m_envelopeTimes) * 1e6f, getMean(m_visualizerTimes) * 1e6f);
+    addText(left, y, line, TEXT_COLOR);
+}
+
+void HudOverlay::addRect(float x, float y, float width, float height, sf::Color color)
+{
+    if (width <= 0.0f || height <= 0.0f)
+    {
+        return;
+    }
+
+    sf::Vector2f topLeft(x, y);
+    sf::Vector2f topRight(x + width, y);
+    sf::Vector2f bottomLeft(x, y + height);
+    sf::Vector2f bottomRight(x + width, y + height);
+
+    m_vertices.append(sf::Vertex(topLeft, color));
+    m_vertices.append(sf::Vertex(topRight, color));
+    m_vertices.append(sf::Vertex(bottomRight, color));
+    m_vertices.append(sf::Vertex(topLeft, color));
+    m_vertices.append(sf::Vertex(bottomRight, color));
+    m_vertices.append(sf::Vertex(bottomLeft, color));
+}
+
+void HudOverlay::addText(float x, float y, const char* text, sf::Color color)
+{
+    for (const char* c = text; *c != '\0'; c++, x += 4.0f * PIXEL)
+    {
+        const char* pixels = findGlyph(*c);
+        if (pixels == nullptr)
+        {
+            continue;
+        }
+
+        // one quad per horizontal run of set pixels
+        for (int row = 0; row < 5; row++)
+        {
+            int column = 0;
+            while (column < 3)
+            {
+                if (pixels[row * 3 + column] != '1')
+                {
+                    column++;
+                    continue;
+                }
+
+                int start = column;
+                while (column < 3 && pixels[row * 3 + column] == '1')
+                {
+                    column++;
+                }
+                addRect(x + start * PIXEL, y + row * PIXEL, (column - start) * PIXEL, PIXEL, color);
+            }
+        }
+    }
+}
+
+float HudOverlay::getMean(const std::array<float, HISTORY>& times) const
+{
+    if (m_count == 0)
+    {
+        return 0.0f;
+    }
+
+    float total = 0.0f;
+    for (int i = 0; i < m_count; i++)
+    {
+        total += times[i];
+    }
+    return total / m_count;
+}
@@ -0,0 +1,67 @@
+#ifndef HUD_OVERLAY_HPP
+#define HUD_OVERLAY_HPP
+
+#include <array>
+#include <cstddef>
+
+#include <SFML/Graphics.hpp>
+
+/*
+    Frame statistics drawn over the window: a graph of the last HISTORY
+    frame times (CPU part darker, lines at 60 and 30 fps), the 50th, 95th
+    and 99th percentile frame time over them, last frame's draw calls and
+    rebuilt vertices (render_stats.hpp), and the mean cost of the envelope
+    and visualizer updates.
+
+    Everything, text included, goes into one untextured vertex array
+    and costs a single draw call. Text uses a built in 3x5 pixel font, so
+    the overlay doesn't add a text draw per line. The array keeps its
+    storage between frames and rebuilding it doesn't allocate.
+
+    Measurements are recorded while the overlay is hidden too, so it
+    shows a full history as soon as it's toggled on.
+*/
+
+class HudOverlay
+{
+    public:
+        static constexpr int HISTORY = 240;     // frames, one pixel column each
+
+        HudOverlay();
+
+        void setPosition(sf::Vector2f position);    // top left corner
+        sf::Vector2f getSize() const;
+
+        void toggle();
+        bool isVisible() const;
+
+        // one frame's measurements, times in seconds
+        void addFrame(float frameTime, float cpuTime, float envelopeTime, float visualizerTime,
+                      std::size_t drawCalls, std::size_t rebuiltVertices);
+
+        void draw(sf::RenderTarget& target);
+
+    private:
+        void rebuild();
+        void addRect(float x, float y, float width, float height, sf::Color color);
+        void addText(float x, float y, const char* text, sf::Color color);
+
+        float getMean(const std::array<float, HISTORY>& times) const;
+
+        std::array<float, HISTORY> m_frameTimes;
+        std::array<float, HISTORY> m_cpuTimes;
+        std::array<float, HISTORY> m_envelopeTimes;
+        std::array<float, HISTORY> m_visualizerTimes;
+        std::array<float, HISTORY> m_sorted;    // percentile scratch
+        int m_next;
+        int m_count;
+
+        std::size_t m_drawCalls;
+        std::size_t m_rebuiltVertices;
+
+        sf::Vector2f m_position;
+        sf::VertexArray m_vertices;
+        bool m_isVisible;
+};
+
+#endif // HUD_OVERLAY_HPP
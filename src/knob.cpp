@@ -1,11 +1,14 @@
 
 
 #include <iostream>
-#include <sstream>
+#include <cstdio>
 #include <cmath>
+#include <limits>
 
 #include "theme.hpp"
 #include "knob.hpp"
+#include "render_stats.hpp"
+#include "trace.hpp"
 
 
 Knob::Knob(KnobType type, float min, float max, float init_value, float radius, const std::string& label)
@@ -15,6 +18,7 @@ Knob::Knob(KnobType type, float min, float max, float init_value, float radius,
 , m_minValue(min)
 , m_maxValue(max)
 , m_value(init_value)
+, m_displayedValue(std::numeric_limits<float>::quiet_NaN())
 , m_isTurning(false)
 , m_increment(0.01f)
 , m_sensitivity(0.15f)
@@ -63,6 +67,7 @@ Knob::Knob(float x, float y, float radius, float min, float max, float init_posi
 , m_minValue(min)
 , m_maxValue(max)
 , m_value(init_position)
+, m_displayedValue(std::numeric_limits<float>::quiet_NaN())
 , m_isTurning(false)
 , m_increment(0.01f)
 , m_sensitivity(0.15f)
@@ -115,6 +120,8 @@ Knob::Knob(float x, float y, float radius, float min, float max, float init_posi
 
 void Knob::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
 {
+    TRACE_SCOPE("Knob::handleEvent");
+
 
 /*
     if (m_isDisabled)
@@ -175,11 +182,8 @@ void Knob::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
         new_value = std::round(new_value / m_increment) * m_increment;
         m_value = std::clamp(new_value, m_minValue, m_maxValue);
 
+        // also updates the indicator and text position
         setValue(m_value);
-
-        // Update the indicator and text position
-        positionIndicator(m_value);
-        positionValueText(m_value);
     }
 }
 
@@ -210,10 +214,15 @@ void Knob::positionValueText(float value)
         m_position.y - std::sin(value_radian) * text_distance // Invert Y-axis
     );
 
-    // Set the value text to display the current knob value
-    std::stringstream ss;
-    ss << value;
-    m_valueText.setString(ss.str());
+    // Set the value text to display the current knob value,
+    // the string is only rebuilt when the value changed
+    if (value != m_displayedValue)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%g", value);
+        m_valueText.setString(buffer);
+        m_displayedValue = value;
+    }
 
     // Get text bounds for positioning adjustment
     sf::FloatRect text_bounds = m_valueText.getLocalBounds();
@@ -233,18 +242,23 @@ void Knob::positionValueText(float value)
     m_valueText.setPosition(text_position);
 }
 
-void Knob::draw(sf::RenderWindow& window)
+void Knob::draw(sf::RenderTarget& target)
 {
-    window.draw(m_knob);
-    window.draw(m_indicator);
+    TRACE_SCOPE("Knob::draw");
 
-    window.draw(m_titleText);
-    window.draw(m_valueText);
+    drawCounted(target, m_knob);
+    drawCounted(target, m_indicator);
+
+    drawCounted(target, m_titleText);
+    drawCounted(target, m_valueText);
 }
 void Knob::setValue(float value)
 {
     if(value >= m_minValue && value <= m_maxValue)
         m_value = value;
+
+    positionIndicator(m_value);
+    positionValueText(m_value);
 }
 void Knob::setIncrement(float increment)
 {
@@ -20,7 +20,7 @@ class Knob
         Knob(float x, float y, float radius, float min, float max, float init_value, const std::string& label);
 
         void handleEvent(const sf::Event& event, const sf::RenderWindow& window);
-        void draw(sf::RenderWindow& window);
+        void draw(sf::RenderTarget& target);
 
         // getters
         float getValue() const;
@@ -49,6 +49,7 @@ class Knob
         float m_minValue;
         float m_maxValue;
         float m_value;
+        float m_displayedValue;     // value currently shown by m_valueText
         float m_sensitivity;
         float m_increment;
         float m_padding;
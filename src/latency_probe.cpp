@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+#include "latency_probe.hpp"
+
+std::int64_t getLatencyClock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// series
+
+LatencySeries::LatencySeries(const std::string& name, std::size_t capacity)
+: m_name(name)
+, m_dropped(0)
+{
+    m_values.reserve(capacity);
+}
+
+void LatencySeries::add(std::int64_t nanoseconds)
+{
+    if (m_values.size() == m_values.capacity())
+    {
+        m_dropped++;
+        return;
+    }
+    m_values.push_back(nanoseconds);
+}
+
+void LatencySeries::clear()
+{
+    m_values.clear();
+    m_dropped = 0;
+}
+
+const std::string& LatencySeries::getName() const
+{
+    return m_name;
+}
+std::size_t LatencySeries::getCount() const
+{
+    return m_values.size();
+}
+
+void LatencySeries::printSummary(std::ostream& out) const
+{
+    if (m_values.empty())
+    {
+        return;
+    }
+
+    std::vector<std::int64_t> sorted(m_values);
+    std::sort(sorted.begin(), sorted.end());
+
+    // nearest rank
+    auto percentile = [&sorted](double fraction)
+    {
+        std::size_t rank = static_cast<std::size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[rank] / 1000.0;
+    };
+
+    out << std::fixed << std::setprecision(1);
+    out << std::left << std::setw(28) << m_name << std::right
+        << std::setw(7) << sorted.size()
+        << std::setw(10) << percentile(0.5)
+        << std::setw(10) << percentile(0.9)
+        << std::setw(10) << percentile(0.99)
+        << std::setw(10) << percentile(0.999)
+        << std::setw(10) << sorted.back() / 1000.0 << " us";
+    if (m_dropped > 0)
+    {
+        out << " (" << m_dropped << " dropped)";
+    }
+    out << "\n";
+}
+
+void LatencySeries::printHeader(std::ostream& out)
+{
+    out << std::left << std::setw(28) << "input" << std::right << std::setw(7) << "count" << std::setw(10) << "p50"
+        << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n";
+}
+
+// probe
+
+LatencyProbe::LatencyProbe()
+: m_series(nullptr)
+, m_inputTime(0)
+{
+}
+
+void LatencyProbe::markInput(LatencySeries& series, std::int64_t inputTime)
+{
+    if (m_series == nullptr)
+    {
+        m_series = &series;
+        m_inputTime = inputTime;
+    }
+}
+
+void LatencyProbe::cancel()
+{
+    m_series = nullptr;
+}
+
+bool LatencyProbe::isPending() const
+{
+    return m_series != nullptr;
+}
+
+void LatencyProbe::markOutput(float sample, std::int64_t outputTime)
+{
+    if (m_series != nullptr && sample != 0.0f)
+    {
+        m_series->add(outputTime - m_inputTime);
+        m_series = nullptr;
+    }
+}
+
+void LatencyProbe::markBlock(const float* samples, int numSamples, std::int64_t blockTime, float sampleRate)
+{
+    if (m_series == nullptr)
+    {
+        return;
+    }
+
+    const float* found = std::find_if(samples, samples + numSamples, [](float sample) { return sample != 0.0f; });
+    if (found != samples + numSamples)
+    {
+        double offset = static_cast<double>(found - samples) / sampleRate * 1e9;
+        markOutput(*found, blockTime + static_cast<std::int64_t>(offset));
+    }
+}
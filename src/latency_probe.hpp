@@ -0,0 +1,68 @@
+#ifndef LATENCY_PROBE_HPP
+#define LATENCY_PROBE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+    Trigger-to-output latency measurement.
+
+    A LatencyProbe sits on one trigger path. markInput() stamps the input
+    that starts a note (a click, a key, an OSC packet, a gate edge) and
+    markOutput() / markBlock() watch the envelope output after it; the
+    first nonzero sample closes the measurement and adds it to the input's
+    LatencySeries. Times are steady_clock nanoseconds throughout.
+
+    Within a block, sample i counts as output at blockTime + i / sampleRate,
+    blockTime being when the block was ready to hand to the device.
+
+    A series keeps every measurement in storage reserved up front, so
+    recording never allocates; past its capacity measurements are counted
+    as dropped. Percentiles are worked out when the summary is printed.
+*/
+
+std::int64_t getLatencyClock();     // steady_clock now, in nanoseconds
+
+class LatencySeries
+{
+    public:
+        explicit LatencySeries(const std::string& name, std::size_t capacity = 100000);
+
+        void add(std::int64_t nanoseconds);
+        void clear();
+
+        const std::string& getName() const;
+        std::size_t getCount() const;
+
+        // count, p50, p90, p99, p99.9 and max in microseconds, nothing for an empty series
+        void printSummary(std::ostream& out) const;
+        static void printHeader(std::ostream& out);
+
+    private:
+        std::string m_name;
+        std::vector<std::int64_t> m_values;
+        std::size_t m_dropped;
+};
+
+class LatencyProbe
+{
+    public:
+        LatencyProbe();
+
+        // ignored while an earlier input is still waiting for its output
+        void markInput(LatencySeries& series, std::int64_t inputTime);
+        void cancel();
+        bool isPending() const;
+
+        void markOutput(float sample, std::int64_t outputTime);
+        void markBlock(const float* samples, int numSamples, std::int64_t blockTime, float sampleRate);
+
+    private:
+        LatencySeries* m_series;
+        std::int64_t m_inputTime;
+};
+
+#endif // LATENCY_PROBE_HPP
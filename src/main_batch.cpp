@@ -0,0 +1,122 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "automation.hpp"
+#include "batch_renderer.hpp"
+#include "gate_timeline.hpp"
+#include "preset.hpp"
+
+/*
+    Offline batch renderer, no window.
+
+    Renders every preset in a library against every gate timeline
+    in a timeline file, one WAV file per combination.
+*/
+
+void printUsage()
+{
+    std::cout << "usage: envelope_batch <presets.envp> <timelines.txt> <output dir>"
+              << " [--threads N] [--rate HZ] [--silence DB] [--chunk SECONDS] [--automation FILE] [--cache DIR] [--cache-size MB] [--sync] [--segments] [--quiet]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        printUsage();
+        return 1;
+    }
+
+    BatchSettings settings;
+    settings.outputDirectory = argv[3];
+    std::string automationPath;
+
+    for (int i = 4; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            settings.threadCount = static_cast<unsigned int>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+        {
+            settings.sampleRate = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--silence") == 0 && i + 1 < argc)
+        {
+            settings.silenceThreshold = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--chunk") == 0 && i + 1 < argc)
+        {
+            settings.chunkSeconds = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--automation") == 0 && i + 1 < argc)
+        {
+            automationPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+        {
+            settings.cacheDirectory = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc)
+        {
+            settings.cacheMaxBytes = std::strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+        }
+        else if (std::strcmp(argv[i], "--sync") == 0)
+        {
+            settings.waitForDisk = true;
+        }
+        else if (std::strcmp(argv[i], "--segments") == 0)
+        {
+            settings.writeSegments = true;
+        }
+        else if (std::strcmp(argv[i], "--quiet") == 0)
+        {
+            settings.showProgress = false;
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (settings.sampleRate <= 0.f)
+    {
+        std::cerr << "Sample rate must be positive" << std::endl;
+        return 1;
+    }
+    if (settings.writeSegments && !automationPath.empty())
+    {
+        std::cerr << "Automated envelopes can't be written as segments" << std::endl;
+        return 1;
+    }
+
+    PresetLibrary presets;
+    if (!presets.open(argv[1]))
+    {
+        return 1;
+    }
+
+    std::vector<GateTimeline> timelines;
+    if (!loadGateTimelines(argv[2], settings.sampleRate, timelines))
+    {
+        return 1;
+    }
+
+    std::vector<AutomationLane> automation;
+    if (!automationPath.empty() && !loadAutomation(automationPath, settings.sampleRate, automation))
+    {
+        return 1;
+    }
+
+    std::cout << "Rendering " << presets.getPresetCount() << " presets x "
+              << timelines.size() << " timelines" << std::endl;
+
+    BatchRenderer renderer(presets, timelines, automation, settings);
+    bool succeeded = renderer.run();
+    renderer.printSummary(std::cout);
+
+    return succeeded ? 0 : 1;
+}
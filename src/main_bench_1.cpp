@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "envelope_generator.hpp"
+
+/*
+    Benchmarks the segment-run block renderer against the
+    per-sample update() loop it replaced.
+
+    The outputs aren't identical: update() accumulates the elapsed time
+    sample by sample, so its phase ends can land a sample or so away from
+    the segment-run ones. On steep curves that shows up as a large max
+    difference over a handful of samples, the mean stays tiny.
+*/
+
+const float SAMPLE_RATE = 48000.f;
+const int BLOCK_SIZE = 256;
+const int NUM_VOICES = 64;
+const int NUM_BLOCKS = 2000;    // ~10.7 seconds per voice
+
+void setupVoice(Envelope& envelope, Envelope::EnvelopeType type, int voice)
+{
+    envelope.setEnvelopeType(type);
+    envelope.setAttackTime(0.005f + 0.001f * voice);
+    envelope.setAttackCurve(static_cast<float>(voice % 21) - 10.f);
+    envelope.setDecayTime(0.05f + 0.002f * voice);
+    envelope.setDecayCurve(static_cast<float>(voice % 7) - 3.f);
+    envelope.setSustainLevel(0.6f);
+    envelope.setReleaseTime(0.3f + 0.01f * voice);
+    envelope.setReleaseCurve(static_cast<float>(voice % 5));
+    envelope.setLooping(voice % 4 == 0);
+}
+
+// gate on for 100 blocks every 300 blocks, edges on block boundaries
+void applyGate(Envelope& envelope, int block, int voice)
+{
+    int position = (block + voice * 7) % 300;
+
+    if (position == 0)
+    {
+        envelope.trigger();
+    }
+    else if (position == 100)
+    {
+        envelope.release();
+    }
+}
+
+double renderPerSample(Envelope::EnvelopeType type, std::vector<float>& output)
+{
+    float deltaTime = 1.f / SAMPLE_RATE;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int voice = 0; voice < NUM_VOICES; voice++)
+    {
+        Envelope envelope;
+        setupVoice(envelope, type, voice);
+        float* voiceOutput = output.data() + static_cast<std::size_t>(voice) * NUM_BLOCKS * BLOCK_SIZE;
+
+        for (int block = 0; block < NUM_BLOCKS; block++)
+        {
+            applyGate(envelope, block, voice);
+
+            for (int i = 0; i < BLOCK_SIZE; i++)
+            {
+                envelope.update(deltaTime);
+                voiceOutput[block * BLOCK_SIZE + i] = envelope.getAmplitude();
+            }
+        }
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double renderSegments(Envelope::EnvelopeType type, std::vector<float>& output)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int voice = 0; voice < NUM_VOICES; voice++)
+    {
+        Envelope envelope;
+        setupVoice(envelope, type, voice);
+        float* voiceOutput = output.data() + static_cast<std::size_t>(voice) * NUM_BLOCKS * BLOCK_SIZE;
+
+        for (int block = 0; block < NUM_BLOCKS; block++)
+        {
+            applyGate(envelope, block, voice);
+            envelope.renderBlock(voiceOutput + block * BLOCK_SIZE, BLOCK_SIZE, SAMPLE_RATE);
+        }
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    std::size_t totalSamples = static_cast<std::size_t>(NUM_VOICES) * NUM_BLOCKS * BLOCK_SIZE;
+    std::vector<float> reference(totalSamples);
+    std::vector<float> output(totalSamples);
+
+    const char* names[] = {"ADSR", "ASR", "AD"};
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "type   per-sample   segment-run   speedup   max / mean difference\n";
+
+    for (int type = 0; type < 3; type++)
+    {
+        auto envelopeType = static_cast<Envelope::EnvelopeType>(type);
+
+        double perSampleSeconds = renderPerSample(envelopeType, reference);
+        double segmentSeconds = renderSegments(envelopeType, output);
+
+        float maxDifference = 0.f;
+        double sumDifference = 0.0;
+        for (std::size_t i = 0; i < totalSamples; i++)
+        {
+            float difference = std::fabs(reference[i] - output[i]);
+            maxDifference = std::max(maxDifference, difference);
+            sumDifference += difference;
+        }
+
+        std::cout << std::setw(4) << names[type]
+                  << std::setw(10) << totalSamples / perSampleSeconds / 1e6 << " Ms/s"
+                  << std::setw(10) << totalSamples / segmentSeconds / 1e6 << " Ms/s"
+                  << std::setw(9) << perSampleSeconds / segmentSeconds << "x"
+                  << std::setprecision(6) << std::setw(12) << maxDifference << " / "
+                  << sumDifference / totalSamples << std::setprecision(2) << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "envelope_generator.hpp"
+#include "voice_pool.hpp"
+
+/*
+    Dense polyphony through a VoicePool, with and without a silence
+    threshold.
+
+    A short note starts every few milliseconds and releases over a couple
+    of seconds on a steep curve, so most of each release is far below
+    anything audible. The difference column is the largest gap between
+    the two mixes, bounded by the threshold times the number of voices
+    whose tails got cut at that moment.
+*/
+
+const float SAMPLE_RATE = 48000.f;
+const int BLOCK_SIZE = 256;
+const int NUM_VOICES = 1024;
+const int NUM_BLOCKS = 4000;        // ~21 seconds
+const int NOTE_INTERVAL = 2;        // blocks between notes
+const int NOTE_LENGTH = 20;         // blocks a note is held
+
+struct BenchResult
+{
+    double seconds;
+    std::uint64_t voiceSamples;     // samples of active voices actually rendered
+    std::uint64_t skippedSamples;
+    int peakVoices;
+};
+
+BenchResult renderPool(float thresholdDecibels, std::vector<float>& output)
+{
+    VoicePool pool(NUM_VOICES, BLOCK_SIZE);
+    pool.setSilenceThreshold(thresholdDecibels);
+
+    Envelope settings;
+    settings.setEnvelopeType(Envelope::EnvelopeType::ADSR);
+    settings.setAttackTime(0.002f);
+    settings.setDecayTime(0.1f);
+    settings.setDecayCurve(3.f);
+    settings.setSustainLevel(0.5f);
+    settings.setReleaseTime(3.f);
+    settings.setReleaseCurve(10.f);
+
+    std::vector<int> heldVoices(NUM_BLOCKS, -1);
+    BenchResult result{0.0, 0, 0, 0};
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int block = 0; block < NUM_BLOCKS; block++)
+    {
+        if (block % NOTE_INTERVAL == 0)
+        {
+            heldVoices[block] = pool.noteOn(settings);
+        }
+        if (block >= NOTE_LENGTH)
+        {
+            pool.noteOff(heldVoices[block - NOTE_LENGTH]);
+        }
+
+        result.voiceSamples += static_cast<std::uint64_t>(pool.getActiveVoiceCount()) * BLOCK_SIZE;
+        result.peakVoices = std::max(result.peakVoices, pool.getActiveVoiceCount());
+
+        pool.render(output.data() + static_cast<std::size_t>(block) * BLOCK_SIZE, BLOCK_SIZE, SAMPLE_RATE);
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.skippedSamples = pool.getSkippedSampleCount();
+    return result;
+}
+
+int main()
+{
+    std::size_t totalSamples = static_cast<std::size_t>(NUM_BLOCKS) * BLOCK_SIZE;
+    std::vector<float> reference(totalSamples);
+    std::vector<float> output(totalSamples);
+
+    BenchResult full = renderPool(-INFINITY, reference);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "threshold    time     voice samples   skipped         peak voices   max difference\n";
+
+    for (float threshold : {-INFINITY, -120.f, -96.f, -72.f})
+    {
+        BenchResult result = renderPool(threshold, output);
+
+        float maxDifference = 0.f;
+        for (std::size_t i = 0; i < totalSamples; i++)
+        {
+            maxDifference = std::max(maxDifference, std::fabs(reference[i] - output[i]));
+        }
+
+        std::cout << std::setw(6) << threshold << " dB"
+                  << std::setw(8) << result.seconds * 1000.0 << " ms"
+                  << std::setw(14) << result.voiceSamples
+                  << std::setw(16) << result.skippedSamples
+                  << std::setw(10) << result.peakVoices
+                  << std::setprecision(8) << std::setw(18) << maxDifference << std::setprecision(2)
+                  << "   (" << full.seconds / result.seconds << "x)\n";
+    }
+
+    return 0;
+}
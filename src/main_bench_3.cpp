@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "envelope_generator.hpp"
+#include "gate_detector.hpp"
+#include "gate_timeline.hpp"
+
+/*
+    Thousands of envelopes driven by audio-rate gate signals.
+
+    Every voice reads one of a bank of noisy pulse waves, so edges come
+    with some chatter around the threshold for the hysteresis to deal with.
+    The edges GateDetector finds must match a plain per-sample loop
+    exactly. The first few voices are also compared with renderGateTimeline()
+    fed with those edges; that one renders in long spans rather than blocks,
+    and the float elapsed time rounds differently across block boundaries,
+    so a phase end can move by a sample there.
+
+    Build with and without ENVELOPE_USE_SIMD to compare the edge scan.
+*/
+
+const float SAMPLE_RATE = 48000.f;
+const int BLOCK_SIZE = 256;
+const int NUM_VOICES = 2048;
+const int NUM_BLOCKS = 1000;        // ~5.3 seconds
+const int NUM_GATES = 16;
+const int NUM_CHECKED = 16;
+const float THRESHOLD = 0.5f;
+const float HYSTERESIS = 0.2f;
+
+std::vector<float> makeGate(int index, std::size_t length)
+{
+    std::mt19937 random(index);
+    std::uniform_real_distribution<float> noise(-0.15f, 0.15f);
+
+    std::size_t period = 2000 + 1500 * index;
+    std::size_t width = period / (2 + index % 3);
+
+    std::vector<float> gate(length);
+    for (std::size_t i = 0; i < length; i++)
+    {
+        gate[i] = ((i % period) < width ? 1.f : 0.f) + noise(random);
+    }
+    return gate;
+}
+
+void setupVoice(Envelope& envelope, int voice)
+{
+    envelope.setEnvelopeType(static_cast<Envelope::EnvelopeType>(voice % 3));
+    envelope.setAttackTime(0.002f + 0.0001f * (voice % 50));
+    envelope.setAttackCurve(static_cast<float>(voice % 21) - 10.f);
+    envelope.setDecayTime(0.02f);
+    envelope.setDecayCurve(2.f);
+    envelope.setSustainLevel(0.7f);
+    envelope.setReleaseTime(0.01f + 0.0002f * (voice % 100));
+    envelope.setReleaseCurve(3.f);
+}
+
+// the same Schmitt trigger as GateDetector, one sample at a time
+GateTimeline findEdges(const std::vector<float>& gate)
+{
+    GateTimeline timeline{"reference", gate.size(), {}};
+    bool isHigh = false;
+
+    for (std::size_t i = 0; i < gate.size(); i++)
+    {
+        if (!isHigh && gate[i] >= THRESHOLD + HYSTERESIS * 0.5f)
+        {
+            isHigh = true;
+            timeline.events.push_back({i, true});
+        }
+        else if (isHigh && gate[i] < THRESHOLD - HYSTERESIS * 0.5f)
+        {
+            isHigh = false;
+            timeline.events.push_back({i, false});
+        }
+    }
+    return timeline;
+}
+
+int main()
+{
+    std::size_t length = static_cast<std::size_t>(NUM_BLOCKS) * BLOCK_SIZE;
+
+    std::vector<std::vector<float>> gates;
+    for (int i = 0; i < NUM_GATES; i++)
+    {
+        gates.push_back(makeGate(i, length));
+    }
+
+    std::vector<Envelope> voices(NUM_VOICES);
+    std::vector<GateDetector> detectors(NUM_VOICES, GateDetector(THRESHOLD, HYSTERESIS));
+    for (int voice = 0; voice < NUM_VOICES; voice++)
+    {
+        setupVoice(voices[voice], voice);
+    }
+
+    // the checked voices keep their whole output, the rest share one block
+    std::vector<float> checked(static_cast<std::size_t>(NUM_CHECKED) * length);
+    std::vector<float> block(BLOCK_SIZE);
+    std::size_t constantBlocks = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int b = 0; b < NUM_BLOCKS; b++)
+    {
+        std::size_t offset = static_cast<std::size_t>(b) * BLOCK_SIZE;
+
+        for (int voice = 0; voice < NUM_VOICES; voice++)
+        {
+            float* output = (voice < NUM_CHECKED) ? checked.data() + voice * length + offset : block.data();
+            const float* gate = gates[voice % NUM_GATES].data() + offset;
+
+            Envelope::BlockInfo info = renderGatedBlock(voices[voice], detectors[voice], gate, output, BLOCK_SIZE, SAMPLE_RATE);
+            constantBlocks += info.isConstant ? 1 : 0;
+        }
+    }
+
+    double renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // edge scan on its own, every gate signal end to end
+    GateDetector detector(THRESHOLD, HYSTERESIS);
+    std::vector<GateEvent> found;
+    found.reserve(length);
+    std::size_t edges = 0;
+    int mismatches = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < 20; repeat++)
+    {
+        for (const std::vector<float>& gate : gates)
+        {
+            int end = static_cast<int>(length);
+            detector.reset();
+            found.clear();
+
+            for (int i = detector.findNextEdge(gate.data(), 0, end); i < end; i = detector.findNextEdge(gate.data(), i + 1, end))
+            {
+                found.push_back({static_cast<std::uint64_t>(i), detector.isHigh()});
+            }
+            edges += found.size();
+
+            if (repeat == 0)
+            {
+                std::vector<GateEvent> expected = findEdges(gate).events;
+                bool isSame = std::equal(found.begin(), found.end(), expected.begin(), expected.end(),
+                                         [](const GateEvent& a, const GateEvent& b) { return a.sample == b.sample && a.isOn == b.isOn; });
+                mismatches += isSame ? 0 : 1;
+            }
+        }
+    }
+    double scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // the checked voices against the timeline renderer
+    std::vector<float> reference(length);
+    float maxDifference = 0.f;
+    double sumDifference = 0.0;
+
+    for (int voice = 0; voice < NUM_CHECKED; voice++)
+    {
+        Envelope envelope;
+        setupVoice(envelope, voice);
+        renderGateTimeline(envelope, findEdges(gates[voice % NUM_GATES]), SAMPLE_RATE, reference.data());
+
+        for (std::size_t i = 0; i < length; i++)
+        {
+            float difference = std::fabs(reference[i] - checked[voice * length + i]);
+            maxDifference = std::max(maxDifference, difference);
+            sumDifference += difference;
+        }
+    }
+
+    double totalSamples = static_cast<double>(NUM_VOICES) * length;
+    double gateBytes = 20.0 * NUM_GATES * length * sizeof(float);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Voices:          " << NUM_VOICES << " x " << length << " samples\n";
+    std::cout << "Gated render:    " << totalSamples / renderSeconds / 1e6 << " Msamples/s ("
+              << 100.0 * constantBlocks / (static_cast<double>(NUM_VOICES) * NUM_BLOCKS) << "% constant blocks)\n";
+    std::cout << "Edge scan:       " << gateBytes / scanSeconds / (1024.0 * 1024.0 * 1024.0) << " GB/s, "
+              << edges / 20 / NUM_GATES << " edges per gate\n";
+    std::cout << "Edges:           " << (NUM_GATES - mismatches) << " / " << NUM_GATES << " gates match the per-sample loop\n";
+    std::cout << std::setprecision(8) << "Vs timeline:     max " << maxDifference << ", mean "
+              << sumDifference / (static_cast<double>(NUM_CHECKED) * length) << "\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "envelope_generator.hpp"
+#include "vca.hpp"
+
+/*
+    Fused envelope VCA against the two pass version it replaces: render
+    the envelope for the whole buffer, then multiply it into the audio.
+
+    The buffers are far bigger than the caches, so the two pass version
+    streams the envelope out to memory and back in again. Gates open and
+    close on call boundaries, about one note per second.
+
+    The fused version renders the envelope in small chunks, and the float
+    elapsed time rounds a little differently across chunk boundaries, so
+    the outputs can differ slightly where a phase ends.
+*/
+
+const float SAMPLE_RATE = 48000.f;
+const int CALL_FRAMES = 4096;
+const int NUM_CALLS = 2000;         // ~170 seconds
+const int REPEATS = 3;
+
+void setupEnvelope(Envelope& envelope)
+{
+    envelope.setEnvelopeType(Envelope::EnvelopeType::ADSR);
+    envelope.setAttackTime(0.01f);
+    envelope.setAttackCurve(2.f);
+    envelope.setDecayTime(0.2f);
+    envelope.setDecayCurve(-3.f);
+    envelope.setSustainLevel(0.6f);
+    envelope.setReleaseTime(0.3f);
+    envelope.setReleaseCurve(4.f);
+}
+
+void applyGate(Envelope& envelope, int call)
+{
+    if (call % 12 == 0)
+    {
+        envelope.trigger();
+    }
+    else if (call % 12 == 6)
+    {
+        envelope.release();
+    }
+}
+
+void fillAudio(std::vector<float>& audio)
+{
+    for (std::size_t i = 0; i < audio.size(); i++)
+    {
+        audio[i] = std::sin(0.01f * static_cast<float>(i % 62832));
+    }
+}
+
+double runTwoPass(std::vector<float>& audio, std::vector<float>& gains, int numChannels)
+{
+    Envelope envelope;
+    setupEnvelope(envelope);
+    std::size_t numFrames = static_cast<std::size_t>(NUM_CALLS) * CALL_FRAMES;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int call = 0; call < NUM_CALLS; call++)
+    {
+        applyGate(envelope, call);
+        envelope.renderBlock(gains.data() + static_cast<std::size_t>(call) * CALL_FRAMES, CALL_FRAMES, SAMPLE_RATE);
+    }
+    for (std::size_t frame = 0; frame < numFrames; frame++)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            audio[frame * numChannels + channel] *= gains[frame];
+        }
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double runFused(std::vector<float>& audio, int numChannels)
+{
+    Envelope envelope;
+    setupEnvelope(envelope);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int call = 0; call < NUM_CALLS; call++)
+    {
+        applyGate(envelope, call);
+        applyEnvelope(envelope, audio.data() + static_cast<std::size_t>(call) * CALL_FRAMES * numChannels,
+                      CALL_FRAMES, numChannels, SAMPLE_RATE);
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    std::size_t numFrames = static_cast<std::size_t>(NUM_CALLS) * CALL_FRAMES;
+    std::vector<float> gains(numFrames);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "channels   two pass      fused         speedup   max difference\n";
+
+    for (int numChannels : {1, 2, 4})
+    {
+        std::vector<float> reference(numFrames * numChannels);
+        std::vector<float> output(numFrames * numChannels);
+        double twoPassSeconds = 1e30;
+        double fusedSeconds = 1e30;
+
+        for (int repeat = 0; repeat < REPEATS; repeat++)
+        {
+            fillAudio(reference);
+            fillAudio(output);
+            twoPassSeconds = std::min(twoPassSeconds, runTwoPass(reference, gains, numChannels));
+            fusedSeconds = std::min(fusedSeconds, runFused(output, numChannels));
+        }
+
+        float maxDifference = 0.f;
+        for (std::size_t i = 0; i < output.size(); i++)
+        {
+            maxDifference = std::max(maxDifference, std::fabs(reference[i] - output[i]));
+        }
+
+        std::cout << std::setw(8) << numChannels
+                  << std::setw(10) << numFrames / twoPassSeconds / 1e6 << " Mf/s"
+                  << std::setw(10) << numFrames / fusedSeconds / 1e6 << " Mf/s"
+                  << std::setw(9) << twoPassSeconds / fusedSeconds << "x"
+                  << std::setprecision(8) << std::setw(15) << maxDifference << std::setprecision(2) << "\n";
+    }
+
+    return 0;
+}
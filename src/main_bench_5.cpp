@@ -0,0 +1,155 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "envelope_generator.hpp"
+#include "automation.hpp"
+
+/*
+    Audio-rate modulation cost across many voices.
+
+    Each case modulates the same parameters in a different way: not at
+    all, with values held for 64 samples at a time (a control-rate
+    source), with a value that jumps for a single sample per block and
+    holds otherwise, with an LFO that changes every sample, and with
+    breakpoint automation ramping the times and curves all the time.
+    Parameters are only set up again when their buffers change value, so
+    all but audio rate should cost about the same: automation ramps hold
+    each step for AutomationPlayer::CONTROL_INTERVAL samples.
+*/
+
+const float SAMPLE_RATE = 48000.f;
+const int BLOCK_SIZE = 256;
+const int NUM_VOICES = 1024;
+const int NUM_BLOCKS = 400;         // ~2.1 seconds
+
+enum class ModulationCase
+{
+    NONE,
+    STEPPED,
+    SINGLE_SAMPLE,
+    AUDIO_RATE,
+    AUTOMATION
+};
+
+// times and curves ramping between two values every 0.1 seconds, no sustain lane
+std::vector<AutomationLane> makeAutomation()
+{
+    const AutomationParameter PARAMETERS[] = {AutomationParameter::DECAY_TIME, AutomationParameter::ATTACK_CURVE,
+                                              AutomationParameter::RELEASE_CURVE};
+    const float LOW[] = {0.05f, -5.f, -5.f};
+    const float HIGH[] = {0.15f, 5.f, 5.f};
+
+    std::vector<AutomationLane> lanes;
+    for (int lane = 0; lane < 3; lane++)
+    {
+        lanes.push_back({PARAMETERS[lane], {}});
+        for (std::uint64_t point = 0; point * 4800 < NUM_BLOCKS * BLOCK_SIZE; point++)
+        {
+            lanes.back().points.push_back({point * 4800, (point % 2) ? HIGH[lane] : LOW[lane]});
+        }
+    }
+    return lanes;
+}
+
+// one block of an LFO, optionally held for 64 samples at a time
+void fillModulation(std::vector<float>& buffer, int block, float centre, float depth, int stepSize)
+{
+    for (int i = 0; i < BLOCK_SIZE; i++)
+    {
+        int sample = block * BLOCK_SIZE + (i / stepSize) * stepSize;
+        buffer[i] = centre + depth * std::sin(sample * 0.0005f);
+    }
+}
+
+double run(ModulationCase modulationCase)
+{
+    std::vector<Envelope> voices(NUM_VOICES);
+    for (int voice = 0; voice < NUM_VOICES; voice++)
+    {
+        voices[voice].setAttackTime(0.01f);
+        voices[voice].setDecayTime(0.1f);
+        voices[voice].setReleaseTime(0.2f);
+        voices[voice].setLooping(true);
+        voices[voice].trigger();
+    }
+
+    std::vector<float> output(BLOCK_SIZE);
+    std::vector<float> decayTimes(BLOCK_SIZE);
+    std::vector<float> curves(BLOCK_SIZE);
+    std::vector<float> sustainLevels(BLOCK_SIZE);
+
+    Envelope::Taps taps;
+    taps.amplitude = output.data();
+
+    std::vector<AutomationLane> lanes = makeAutomation();
+    AutomationPlayer player(lanes);
+
+    Envelope::Modulation modulation;
+    if (modulationCase != ModulationCase::NONE && modulationCase != ModulationCase::AUTOMATION)
+    {
+        modulation.decayTime = decayTimes.data();
+        modulation.attackCurve = curves.data();
+        modulation.releaseCurve = curves.data();
+        modulation.sustainLevel = sustainLevels.data();
+    }
+
+    int stepSize = (modulationCase == ModulationCase::AUDIO_RATE) ? 1 :
+                   (modulationCase == ModulationCase::SINGLE_SAMPLE) ? BLOCK_SIZE : 64;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int block = 0; block < NUM_BLOCKS; block++)
+    {
+        // shared by every voice, as if they all listened to one modulation source
+        fillModulation(decayTimes, block, 0.1f, 0.05f, stepSize);
+        fillModulation(curves, block, 0.f, 5.f, stepSize);
+        fillModulation(sustainLevels, block, 0.5f, 0.3f, stepSize);
+
+        // one sample off the held value, early in the block
+        if (modulationCase == ModulationCase::SINGLE_SAMPLE)
+        {
+            decayTimes[16] += 0.01f;
+            curves[16] += 1.f;
+        }
+        if (modulationCase == ModulationCase::AUTOMATION)
+        {
+            modulation = player.renderBlock(BLOCK_SIZE);
+        }
+
+        for (int voice = 0; voice < NUM_VOICES; voice++)
+        {
+            if ((block + voice) % 100 == 50)
+            {
+                voices[voice].release();
+            }
+            else if ((block + voice) % 100 == 0)
+            {
+                voices[voice].trigger();
+            }
+
+            voices[voice].renderBlock(taps, modulation, BLOCK_SIZE, SAMPLE_RATE);
+        }
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    const char* names[] = {"none", "stepped (64)", "single sample", "audio rate", "automation ramps"};
+    double totalSamples = static_cast<double>(NUM_VOICES) * NUM_BLOCKS * BLOCK_SIZE;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "modulation        throughput\n";
+
+    for (int modulationCase = 0; modulationCase < 5; modulationCase++)
+    {
+        double seconds = run(static_cast<ModulationCase>(modulationCase));
+        std::cout << std::left << std::setw(16) << names[modulationCase] << std::right
+                  << std::setw(10) << totalSamples / seconds / 1e6 << " Msamples/s\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "stage_envelope.hpp"
+
+/*
+    Benchmarks the float, double and Q11.20 fixed point stage envelopes
+    and reports how far each one is from exact.
+
+    Speed: the same voices and gates as envelope_bench_segments, per type.
+
+    Shape error: float and fixed against double over the same render,
+    at audio rate and at a 1 kHz control rate.
+
+    Timing error: a single linear attack of up to half an hour, where
+    the stage ends against where it should, ceil((time - tolerance) *
+    rate). Elapsed time restarts every stage, so this is the worst case
+    for a stage of that length, looping doesn't add to it.
+*/
+
+const int BLOCK_SIZE = 256;
+const int NUM_VOICES = 64;
+const int NUM_BLOCKS = 2000;
+
+double toDouble(float value)
+{
+    return value;
+}
+double toDouble(double value)
+{
+    return value;
+}
+double toDouble(EnvelopeFixed value)
+{
+    return value.toDouble();
+}
+
+template <typename Sample>
+void setupVoice(BasicStageEnvelope<Sample>& envelope, int voice)
+{
+    // curves as exponents, the same spread of knob values as envelope_bench_segments
+    auto exponent = [](float knob) { return (knob >= 0.f) ? 1.f + knob : 1.f / (1.f - knob); };
+
+    envelope.setADSR(0.005f + 0.001f * voice, exponent(static_cast<float>(voice % 21) - 10.f),
+                     0.05f + 0.002f * voice, exponent(static_cast<float>(voice % 7) - 3.f),
+                     0.6f, 0.3f + 0.01f * voice, exponent(static_cast<float>(voice % 5)));
+    envelope.setLooping(voice % 4 == 0);
+}
+
+// renders every voice into output as doubles, returns the seconds spent rendering
+template <typename Sample>
+double renderVoices(float sampleRate, std::vector<double>& output)
+{
+    std::vector<Sample> block(BLOCK_SIZE);
+    double seconds = 0.0;
+
+    for (int voice = 0; voice < NUM_VOICES; voice++)
+    {
+        BasicStageEnvelope<Sample> envelope;
+        setupVoice(envelope, voice);
+        double* voiceOutput = output.data() + static_cast<std::size_t>(voice) * NUM_BLOCKS * BLOCK_SIZE;
+
+        for (int index = 0; index < NUM_BLOCKS; index++)
+        {
+            // gate on for 100 blocks every 300 blocks
+            int position = (index + voice * 7) % 300;
+            if (position == 0)
+            {
+                envelope.trigger();
+            }
+            else if (position == 100)
+            {
+                envelope.release();
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            envelope.renderBlock(block.data(), BLOCK_SIZE, sampleRate);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::transform(block.begin(), block.end(), voiceOutput + index * BLOCK_SIZE,
+                           [](Sample value) { return toDouble(value); });
+        }
+    }
+    return seconds;
+}
+
+// samples the attack took minus the samples it should have taken
+template <typename Sample>
+long long measureStageEnd(float stageTime, float sampleRate)
+{
+    BasicStageEnvelope<Sample> envelope;
+    envelope.setASR(stageTime, 1.f, 0.5f, 1.f, 1.f);
+    envelope.trigger();
+
+    std::vector<Sample> block(BLOCK_SIZE);
+    long long position = 0;
+
+    while (true)
+    {
+        envelope.renderBlock(block.data(), BLOCK_SIZE, sampleRate);
+
+        // the attack's last sample stops short of 0.5, the sustain starts on it
+        for (int i = 0; i < BLOCK_SIZE; i++)
+        {
+            if (toDouble(block[i]) == 0.5)
+            {
+                long long expected = static_cast<long long>(std::ceil((static_cast<double>(stageTime) - 0.0001) * sampleRate));
+                return position + i - expected;
+            }
+        }
+        position += BLOCK_SIZE;
+    }
+}
+
+int main()
+{
+    std::size_t totalSamples = static_cast<std::size_t>(NUM_VOICES) * NUM_BLOCKS * BLOCK_SIZE;
+    std::vector<double> reference(totalSamples);
+    std::vector<double> output(totalSamples);
+
+    const char* names[] = {"float", "double", "fixed"};
+
+    std::cout << std::fixed;
+    std::cout << "rate       type     speed       max / mean error vs double\n";
+
+    for (float sampleRate : {48000.f, 1000.f})
+    {
+        double seconds[3];
+        double maxError[3] = {};
+        double meanError[3] = {};
+
+        seconds[1] = renderVoices<double>(sampleRate, reference);
+
+        for (int type : {0, 2})
+        {
+            seconds[type] = (type == 0) ? renderVoices<float>(sampleRate, output)
+                                        : renderVoices<EnvelopeFixed>(sampleRate, output);
+
+            double sum = 0.0;
+            for (std::size_t i = 0; i < totalSamples; i++)
+            {
+                double error = std::fabs(output[i] - reference[i]);
+                maxError[type] = std::max(maxError[type], error);
+                sum += error;
+            }
+            meanError[type] = sum / totalSamples;
+        }
+
+        for (int type = 0; type < 3; type++)
+        {
+            std::cout << std::setw(6) << static_cast<int>(sampleRate) << " Hz" << std::setw(9) << names[type]
+                      << std::setprecision(2) << std::setw(9) << totalSamples / seconds[type] / 1e6 << " Ms/s";
+
+            if (type != 1)
+            {
+                std::cout << std::setprecision(6) << std::setw(12) << maxError[type] << " / " << meanError[type];
+            }
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "\nstage end error in samples (+ late, - early)\n";
+    std::cout << "rate       stage       float    double     fixed\n";
+
+    for (float sampleRate : {48000.f, 1000.f})
+    {
+        for (float stageTime : {1.f, 60.f, 600.f, 1800.f})
+        {
+            std::cout << std::setw(6) << static_cast<int>(sampleRate) << " Hz"
+                      << std::setprecision(0) << std::setw(8) << stageTime << " s"
+                      << std::setw(10) << measureStageEnd<float>(stageTime, sampleRate)
+                      << std::setw(10) << measureStageEnd<double>(stageTime, sampleRate)
+                      << std::setw(10) << measureStageEnd<EnvelopeFixed>(stageTime, sampleRate) << "\n";
+        }
+    }
+
+    return 0;
+}
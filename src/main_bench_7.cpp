@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "segment_codec.hpp"
+
+/*
+    Benchmarks the segment codec against rendering: ten minutes of gates
+    for a spread of envelopes, rendered, encoded and decoded, with the
+    encoded size against 32-bit float samples.
+
+    Build with and without ENVELOPE_USE_SIMD to compare the decoder.
+*/
+
+const float SAMPLE_RATE = 48000.f;
+const int NUM_VOICES = 16;
+const int BLOCK_SIZE = 4096;
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void setupVoice(Envelope& envelope, int voice)
+{
+    envelope.setTimingMode(Envelope::TimingMode::SAMPLE_COUNT);
+    envelope.setEnvelopeType(static_cast<Envelope::EnvelopeType>(voice % 3));
+    envelope.setAttackTime(0.005f + 0.01f * voice);
+    envelope.setAttackCurve(static_cast<float>(voice % 21) - 10.f);
+    envelope.setDecayTime(0.05f + 0.02f * voice);
+    envelope.setDecayCurve(static_cast<float>(voice % 7) - 3.f);
+    envelope.setSustainLevel(0.6f);
+    envelope.setReleaseTime(0.3f + 0.1f * voice);
+    envelope.setReleaseCurve(static_cast<float>(voice % 5));
+    envelope.setLooping(voice % 4 == 0);
+}
+
+int main()
+{
+    // a note every 2.5 seconds, held for 1
+    GateTimeline timeline{"bench", static_cast<std::uint64_t>(600 * SAMPLE_RATE), {}};
+    for (std::uint64_t on = 0; on + 48000 < timeline.lengthSamples; on += 120000)
+    {
+        timeline.events.push_back({on, true});
+        timeline.events.push_back({on + 48000, false});
+    }
+
+    std::vector<float> rendered(timeline.lengthSamples);
+    std::vector<float> decoded(timeline.lengthSamples);
+
+    double renderSeconds = 0.0;
+    double encodeSeconds = 0.0;
+    double decodeSeconds = 0.0;
+    double maxError = 0.0;
+    std::uint64_t segmentCount = 0;
+    std::uint64_t encodedBytes = 0;
+
+    for (int voice = 0; voice < NUM_VOICES; voice++)
+    {
+        Envelope envelope;
+        setupVoice(envelope, voice);
+
+        auto start = std::chrono::steady_clock::now();
+        renderGateTimeline(envelope, timeline, SAMPLE_RATE, rendered.data());
+        renderSeconds += secondsSince(start);
+
+        EncodedEnvelope encoded;
+        start = std::chrono::steady_clock::now();
+        encodeGateTimeline(envelope, timeline, SAMPLE_RATE, encoded);
+        encodeSeconds += secondsSince(start);
+
+        // in blocks, the way a player would pull it
+        start = std::chrono::steady_clock::now();
+        for (std::uint64_t position = 0; position < timeline.lengthSamples; position += BLOCK_SIZE)
+        {
+            std::uint64_t count = std::min<std::uint64_t>(BLOCK_SIZE, timeline.lengthSamples - position);
+            decodeSegments(encoded, position, count, decoded.data() + position);
+        }
+        decodeSeconds += secondsSince(start);
+
+        for (std::size_t i = 0; i < decoded.size(); i++)
+        {
+            maxError = std::max(maxError, static_cast<double>(std::fabs(decoded[i] - rendered[i])));
+        }
+        segmentCount += encoded.segments.size();
+        encodedBytes += getEncodedSize(encoded);
+    }
+
+    double totalSamples = static_cast<double>(timeline.lengthSamples) * NUM_VOICES;
+    double sampleBytes = totalSamples * sizeof(float);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "voices:   " << NUM_VOICES << " x " << timeline.lengthSamples / SAMPLE_RATE << " s\n";
+    std::cout << "render:   " << totalSamples / renderSeconds / 1e6 << " Msamples/s\n";
+    std::cout << "encode:   " << totalSamples / encodeSeconds / 1e6 << " Msamples/s\n";
+    std::cout << "decode:   " << totalSamples / decodeSeconds / 1e6 << " Msamples/s\n";
+    std::cout << "size:     " << segmentCount << " segments, " << encodedBytes / 1024.0 << " KB against "
+              << sampleBytes / (1024.0 * 1024.0) << " MB of samples (" << sampleBytes / encodedBytes << "x smaller)\n";
+    std::cout << std::setprecision(9) << "max error " << maxError << "\n";
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
+
+#include "control_panel.hpp"
+#include "envelope_generator.hpp"
+#include "render_stats.hpp"
+
+/*
+    Renders the app's widgets and envelope visualizer into an offscreen
+    sf::RenderTexture for a scripted run of frames, through the app's own
+    ControlPanel (control_panel.hpp): parameter sweeps on every slider and
+    knob, a gate every 1.5 seconds, type and loop changes
+    and the odd reset, all at a fixed 60 fps time step. Prints the CPU time
+    per frame (update, draw and display) and the draw calls and rebuilt
+    vertices per frame.
+
+    Without a window nothing waits for vsync, and draws only queue GL work.
+    --sync adds a glFinish() per frame so the time covers the rasterizing
+    too, which is where software GL spends most of it.
+
+    Needs a GL context but no GPU: on Linux run it with Mesa's llvmpipe,
+    under a virtual X server on machines without a display,
+
+        LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./envelope_bench_ui
+
+    and from the build directory, the font is loaded from ../assets.
+*/
+
+const float FRAME_TIME = 1.f / 60.f;
+
+// what the user does on frame n
+void playScript(ControlPanel& controlPanel, int frame, bool& isGateOn, bool& isResetPending)
+{
+    // one control at a time, each swept for half a second
+    float sweep = 0.5f + 0.5f * std::sin(frame * 0.2f);
+    switch ((frame / 30) % 7)
+    {
+        case 0: controlPanel.setParameter(AutomationParameter::ATTACK_TIME, 0.01f + 0.5f * sweep); break;
+        case 1: controlPanel.setParameter(AutomationParameter::DECAY_TIME, 0.01f + 0.8f * sweep); break;
+        case 2: controlPanel.setParameter(AutomationParameter::SUSTAIN_LEVEL, 0.1f + 0.8f * sweep); break;
+        case 3: controlPanel.setParameter(AutomationParameter::RELEASE_TIME, 0.01f + sweep); break;
+        case 4: controlPanel.setParameter(AutomationParameter::ATTACK_CURVE, 20.f * sweep - 10.f); break;
+        case 5: controlPanel.setParameter(AutomationParameter::DECAY_CURVE, 20.f * sweep - 10.f); break;
+        case 6: controlPanel.setParameter(AutomationParameter::RELEASE_CURVE, 20.f * sweep - 10.f); break;
+    }
+
+    isGateOn = frame % 90 < 40;
+
+    if (frame % 300 == 299)
+    {
+        controlPanel.setEnvelopeType((frame / 300) % 3);
+    }
+    if (frame % 450 == 449)
+    {
+        controlPanel.setLooping(!controlPanel.isLooping());
+    }
+    isResetPending = frame % 1000 == 999;
+}
+
+// AppManager::update() without the app's inputs and outputs
+void update(ControlPanel& controlPanel, Envelope& envelope, bool isGateOn, bool isResetPending)
+{
+    controlPanel.updateEnvelope(isGateOn, isResetPending);
+    envelope.update(FRAME_TIME);
+    controlPanel.updateVisualizer();
+}
+
+void render(ControlPanel& controlPanel, sf::RenderTexture& texture)
+{
+    texture.clear();
+    controlPanel.draw(texture);
+    texture.display();
+}
+
+double getPercentile(const std::vector<double>& sorted, double percentile)
+{
+    std::size_t index = static_cast<std::size_t>(percentile / 100.0 * (sorted.size() - 1));
+    return sorted[index];
+}
+
+double getMean(const std::vector<double>& values)
+{
+    double total = 0.0;
+    for (double value : values)
+    {
+        total += value;
+    }
+    return values.empty() ? 0.0 : total / values.size();
+}
+
+int main(int argc, char* argv[])
+{
+    int frames = 3000;
+    int warmup = 60;
+    unsigned size = 750;
+    bool isSynced = false;
+    std::string imagePath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frames = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            warmup = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            size = static_cast<unsigned>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--sync") == 0)
+        {
+            isSynced = true;
+        }
+        else if (std::strcmp(argv[i], "--png") == 0 && i + 1 < argc)
+        {
+            imagePath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "usage: envelope_bench_ui [--frames N] [--warmup N] [--size PX] [--sync] [--png PATH]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (frames <= 0 || warmup < 0 || size == 0)
+    {
+        std::cerr << "--frames and --size need to be positive" << std::endl;
+        return 1;
+    }
+
+    sf::RenderTexture texture;
+    if (!texture.create(size, size))
+    {
+        std::cerr << "Failed to create a " << size << "x" << size << " render texture, is there a GL context?" << std::endl;
+        return 1;
+    }
+
+    texture.setActive(true);
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    std::cout << "GL renderer: " << (renderer != nullptr ? reinterpret_cast<const char*>(renderer) : "unknown") << "\n";
+
+    Envelope envelope;
+    ControlPanel controlPanel(envelope);
+    controlPanel.layOut(sf::Vector2f(static_cast<float>(size), static_cast<float>(size)));
+
+    std::vector<double> frameTimes;
+    std::vector<double> updateTimes;
+    std::vector<double> drawTimes;
+    std::vector<double> drawCalls;
+    std::vector<double> rebuiltVertices;
+    frameTimes.reserve(frames);
+    updateTimes.reserve(frames);
+    drawTimes.reserve(frames);
+    drawCalls.reserve(frames);
+    rebuiltVertices.reserve(frames);
+
+    bool isGateOn = false;
+    bool isResetPending = false;
+
+    for (int frame = 0; frame < warmup + frames; frame++)
+    {
+        RenderStats::reset();
+        playScript(controlPanel, frame, isGateOn, isResetPending);
+
+        auto start = std::chrono::steady_clock::now();
+        update(controlPanel, envelope, isGateOn, isResetPending);
+        auto updated = std::chrono::steady_clock::now();
+        render(controlPanel, texture);
+        if (isSynced)
+        {
+            glFinish();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        // the first frames rasterize glyphs and upload textures
+        if (frame < warmup)
+        {
+            continue;
+        }
+
+        frameTimes.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        updateTimes.push_back(std::chrono::duration<double, std::micro>(updated - start).count());
+        drawTimes.push_back(std::chrono::duration<double, std::micro>(end - updated).count());
+        drawCalls.push_back(static_cast<double>(RenderStats::getDrawCalls()));
+        rebuiltVertices.push_back(static_cast<double>(RenderStats::getRebuiltVertices()));
+    }
+
+    if (!imagePath.empty() && !texture.getTexture().copyToImage().saveToFile(imagePath))
+    {
+        std::cerr << "Failed to write " << imagePath << std::endl;
+    }
+
+    double totalTime = getMean(frameTimes) * frames;
+
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << frames << " frames at " << size << "x" << size << (isSynced ? ", glFinish() per frame" : "") << "\n";
+    std::cout << "frame CPU time (us): p50 " << getPercentile(sorted, 50.0)
+              << "  p95 " << getPercentile(sorted, 95.0)
+              << "  p99 " << getPercentile(sorted, 99.0)
+              << "  max " << sorted.back() << "\n";
+    std::cout << "  update " << getMean(updateTimes) << " us, draw " << getMean(drawTimes) << " us on average, "
+              << frames / (totalTime / 1e6) << " frames/s\n";
+    std::cout << "draw calls per frame: " << *std::min_element(drawCalls.begin(), drawCalls.end())
+              << " to " << *std::max_element(drawCalls.begin(), drawCalls.end())
+              << ", " << getMean(drawCalls) << " on average\n";
+    std::cout << "rebuilt vertices per frame: " << getMean(rebuiltVertices) << " on average, "
+              << *std::max_element(rebuiltVertices.begin(), rebuiltVertices.end()) << " at most" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "cv_bus.hpp"
+
+/*
+    Reads envelope state from a CV bus (cv_bus.hpp) published by another
+    process and prints the active voices at a fixed rate, with how old the
+    newest frame is and how many frames went by since the last read.
+*/
+
+void printUsage()
+{
+    std::cout << "usage: envelope_cv_reader [bus name] [--rate HZ] [--count N]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string name = "envelope_cv";
+    double rate = 10.0;
+    long long count = -1;   // -1 = until interrupted
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+        {
+            rate = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+        {
+            count = std::atoll(argv[++i]);
+        }
+        else if (argv[i][0] != '-')
+        {
+            name = argv[i];
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (rate <= 0.0)
+    {
+        std::cerr << "Rate must be positive" << std::endl;
+        return 1;
+    }
+
+    CvBusReader reader;
+    if (!reader.open(name))
+    {
+        return 1;
+    }
+
+    const char* phaseNames[] = {"inactive", "attack", "decay", "sustain", "release"};
+    const auto interval = std::chrono::duration<double>(1.0 / rate);
+
+    CvSnapshot snapshot;
+    std::uint64_t lastFrame = 0;
+    auto next = std::chrono::steady_clock::now();
+
+    std::cout << std::fixed;
+
+    for (long long read = 0; count < 0 || read < count; read++)
+    {
+        std::this_thread::sleep_until(next);
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+
+        if (!reader.readLatest(snapshot))
+        {
+            std::cout << "waiting for the first frame" << std::endl;
+            continue;
+        }
+
+        // publishTime is on the same steady clock
+        std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        std::cout << "frame " << snapshot.frameNumber << " (+" << snapshot.frameNumber - lastFrame << "), "
+                  << std::setprecision(1) << (now - snapshot.publishTime) / 1000.0 << " us old:";
+        lastFrame = snapshot.frameNumber;
+
+        int active = 0;
+        for (std::uint32_t voice = 0; voice < snapshot.voiceCount; voice++)
+        {
+            const CvVoiceState& state = snapshot.voices[voice];
+            if (state.phase == 0 || state.phase > 4)
+            {
+                continue;
+            }
+            std::cout << "  " << voice << " " << phaseNames[state.phase] << " " << std::setprecision(3)
+                      << state.amplitude << " (" << state.progress << ")";
+            active++;
+        }
+        std::cout << (active == 0 ? "  no active voices" : "") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,340 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gate_detector.hpp"
+#include "latency_probe.hpp"
+#include "osc_endpoint.hpp"
+#include "spsc_queue.hpp"
+#include "voice_pool.hpp"
+
+/*
+    Trigger-to-output latency harness. Gates go down each trigger path
+    that works without a window, at jittered times so they land anywhere
+    in a frame or block, and the time from input to the first nonzero
+    output sample is printed as percentiles:
+
+        frame loop, OSC         the app's path: a loop at the frame rate polls
+                                OSC and calls Envelope::update(), like AppManager
+        audio blocks, OSC       a block thread polls OSC before each VoicePool block
+        audio blocks, queue     the same thread, gates from another thread through
+                                an SpscQueue, the way a UI thread would hand them over
+        audio blocks, gate      edges in a gate signal into renderGatedBlock()
+
+    The block thread wakes at each block deadline like a device callback.
+    Input samples of a block count as captured over the block period before
+    it, output samples as leaving once the block is rendered (latency_probe.hpp),
+    so the gate path includes one block of input buffering. Device and
+    driver buffers come on top of everything here.
+
+    Clicks and keys in the app itself are measured by the app when it's
+    built with ENVELOPE_MEASURE_LATENCY.
+*/
+
+struct Options
+{
+    int triggers = 240;
+    int blockSize = 256;
+    float sampleRate = 48000.f;
+    double frameRate = 60.0;
+};
+
+struct QueuedGate
+{
+    bool isOn;
+    std::int64_t time;
+};
+
+using GateQueue = SpscQueue<QueuedGate, 64>;
+using Clock = std::chrono::steady_clock;
+
+void printUsage()
+{
+    std::cout << "usage: envelope_latency [--triggers N] [--block SAMPLES] [--rate HZ] [--fps HZ]" << std::endl;
+}
+
+Envelope makeSettings()
+{
+    Envelope settings;
+    settings.setAttackTime(0.005f);
+    settings.setDecayTime(0.01f);
+    settings.setSustainLevel(0.5f);
+    settings.setReleaseTime(0.005f);
+    return settings;
+}
+
+Clock::duration toDuration(double seconds)
+{
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+// the gate handling of AppManager::update()
+void runFrameLoop(OscEndpoint& endpoint, LatencySeries& series, double frameRate, const std::atomic<bool>& isRunning)
+{
+    Envelope envelope = makeSettings();
+    LatencyProbe probe;
+    bool isGateOn = false;
+    bool isTriggerPending = false;
+    std::int64_t gateTime = 0;   // waits for the envelope to be free, like the app's trigger does
+
+    const Clock::duration frame = toDuration(1.0 / frameRate);
+    Clock::time_point next = Clock::now();
+    Clock::time_point last = next;
+
+    while (isRunning)
+    {
+        std::this_thread::sleep_until(next);
+        next += frame;
+
+        ControlMessage message;
+        while (endpoint.pop(message))
+        {
+            if (message.type == ControlMessage::GATE_ON)
+            {
+                isGateOn = true;
+                isTriggerPending = true;
+                gateTime = message.arrivalTime;
+            }
+            else if (message.type == ControlMessage::GATE_OFF)
+            {
+                isGateOn = false;
+            }
+        }
+
+        bool isTrigger = isGateOn || isTriggerPending;
+        isTriggerPending = false;
+
+        if (isTrigger && !envelope.isActive())
+        {
+            envelope.trigger();
+            if (gateTime != 0)
+            {
+                probe.markInput(series, gateTime);
+                gateTime = 0;
+            }
+        }
+        else if (!isGateOn && envelope.isActive() && envelope.getPhase() != Envelope::Phase::RELEASE)
+        {
+            envelope.release();
+        }
+
+        Clock::time_point now = Clock::now();
+        envelope.update(std::chrono::duration<float>(now - last).count());
+        last = now;
+
+        probe.markOutput(envelope.getAmplitude(), getLatencyClock());
+    }
+}
+
+// one voice per path, so a nonzero mix is always the note just started
+struct BlockPath
+{
+    BlockPath(int blockSize) : pool(1, blockSize), mix(blockSize), voice(-1) {}
+
+    void gate(bool isOn, const Envelope& settings, LatencySeries& series, std::int64_t inputTime)
+    {
+        if (isOn && voice < 0)
+        {
+            voice = pool.noteOn(settings);
+            if (voice >= 0)
+            {
+                probe.markInput(series, inputTime);
+            }
+        }
+        else if (!isOn && voice >= 0)
+        {
+            pool.noteOff(voice);
+            voice = -1;
+        }
+    }
+
+    VoicePool pool;
+    std::vector<float> mix;
+    LatencyProbe probe;
+    int voice;
+};
+
+void runAudioBlocks(OscEndpoint& endpoint, GateQueue& queue, LatencySeries& oscSeries, LatencySeries& queueSeries,
+                    LatencySeries& gateSeries, const Options& options, const std::atomic<bool>& isRunning)
+{
+    const int blockSize = options.blockSize;
+    const float sampleRate = options.sampleRate;
+    const Envelope settings = makeSettings();
+    const std::int64_t period = static_cast<std::int64_t>(blockSize / static_cast<double>(sampleRate) * 1e9);
+
+    BlockPath oscPath(blockSize);
+    BlockPath queuePath(blockSize);
+
+    // a gate signal with its own jittered edges
+    Envelope gateEnvelope = makeSettings();
+    GateDetector detector;
+    LatencyProbe gateProbe;
+    std::vector<float> gateSignal(blockSize);
+    std::vector<float> gateOutput(blockSize);
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> gateLength(static_cast<int>(0.03f * sampleRate), static_cast<int>(0.08f * sampleRate));
+    int samplesToEdge = gateLength(random);
+    float gateLevel = 0.0f;
+
+    Clock::time_point next = Clock::now();
+
+    while (isRunning)
+    {
+        std::this_thread::sleep_until(next);
+        next += std::chrono::nanoseconds(period);
+        std::int64_t wakeTime = getLatencyClock();
+
+        ControlMessage message;
+        while (endpoint.pop(message))
+        {
+            if (message.type == ControlMessage::GATE_ON || message.type == ControlMessage::GATE_OFF)
+            {
+                oscPath.gate(message.type == ControlMessage::GATE_ON, settings, oscSeries, message.arrivalTime);
+            }
+        }
+        QueuedGate queued;
+        while (queue.pop(queued))
+        {
+            queuePath.gate(queued.isOn, settings, queueSeries, queued.time);
+        }
+
+        // this block's input was captured over the period before the wakeup
+        for (int i = 0; i < blockSize; i++)
+        {
+            if (--samplesToEdge == 0)
+            {
+                gateLevel = 1.0f - gateLevel;
+                samplesToEdge = gateLength(random);
+                if (gateLevel > 0.0f)
+                {
+                    gateProbe.markInput(gateSeries, wakeTime - period + static_cast<std::int64_t>(i / static_cast<double>(sampleRate) * 1e9));
+                }
+            }
+            gateSignal[i] = gateLevel;
+        }
+
+        oscPath.pool.render(oscPath.mix.data(), blockSize, sampleRate);
+        queuePath.pool.render(queuePath.mix.data(), blockSize, sampleRate);
+        renderGatedBlock(gateEnvelope, detector, gateSignal.data(), gateOutput.data(), blockSize, sampleRate);
+
+        std::int64_t readyTime = getLatencyClock();
+        oscPath.probe.markBlock(oscPath.mix.data(), blockSize, readyTime, sampleRate);
+        queuePath.probe.markBlock(queuePath.mix.data(), blockSize, readyTime, sampleRate);
+        gateProbe.markBlock(gateOutput.data(), blockSize, readyTime, sampleRate);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--triggers") == 0 && hasValue)
+        {
+            options.triggers = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--block") == 0 && hasValue)
+        {
+            options.blockSize = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--rate") == 0 && hasValue)
+        {
+            options.sampleRate = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--fps") == 0 && hasValue)
+        {
+            options.frameRate = std::atof(argv[++i]);
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (options.triggers <= 0 || options.blockSize <= 0 || options.sampleRate <= 0.f || options.frameRate <= 0.0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    LatencySeries frameOsc("frame loop, OSC");
+    LatencySeries blockOsc("audio blocks, OSC");
+    LatencySeries blockQueue("audio blocks, queue");
+    LatencySeries blockGate("audio blocks, gate edge");
+
+    OscEndpoint frameEndpoint;
+    OscEndpoint blockEndpoint;
+    OscSender frameSender;
+    OscSender blockSender;
+    GateQueue queue;
+
+    if (!frameEndpoint.open(0) || !blockEndpoint.open(0) ||
+        !frameSender.open(frameEndpoint.getPort()) || !blockSender.open(blockEndpoint.getPort()))
+    {
+        return 1;
+    }
+
+    std::atomic<bool> isRunning(true);
+    std::thread frameThread(runFrameLoop, std::ref(frameEndpoint), std::ref(frameOsc), options.frameRate, std::cref(isRunning));
+    std::thread blockThread(runAudioBlocks, std::ref(blockEndpoint), std::ref(queue), std::ref(blockOsc), std::ref(blockQueue),
+                            std::ref(blockGate), std::cref(options), std::cref(isRunning));
+
+    std::cout << options.triggers << " triggers, " << options.blockSize << " sample blocks at " << options.sampleRate
+              << " Hz, " << options.frameRate << " fps" << std::endl;
+
+    // one path at a time, a gate held long enough for the slowest path to see it
+    OscWriter gateOn;
+    OscWriter gateOff;
+    gateOn.addMessage("/envelope/trigger");
+    gateOff.addMessage("/envelope/release");
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> pause(40, 80);
+    const auto hold = toDuration(2.0 / options.frameRate);
+
+    for (int i = 0; i < options.triggers; i++)
+    {
+        switch (i % 3)
+        {
+            case 0:
+                frameSender.send(gateOn);
+                std::this_thread::sleep_for(hold);
+                frameSender.send(gateOff);
+                break;
+            case 1:
+                blockSender.send(gateOn);
+                std::this_thread::sleep_for(hold);
+                blockSender.send(gateOff);
+                break;
+            default:
+                queue.push({true, getLatencyClock()});
+                std::this_thread::sleep_for(hold);
+                queue.push({false, getLatencyClock()});
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(pause(random)));
+    }
+
+    isRunning = false;
+    frameThread.join();
+    blockThread.join();
+
+    std::cout << "\ntrigger to first nonzero output:\n";
+    LatencySeries::printHeader(std::cout);
+    for (const LatencySeries* series : {&frameOsc, &blockOsc, &blockQueue, &blockGate})
+    {
+        series->printSummary(std::cout);
+    }
+    std::cout << "\none block is " << options.blockSize / options.sampleRate * 1e6 << " us, one frame "
+              << 1e6 / options.frameRate << " us" << std::endl;
+
+    return 0;
+}
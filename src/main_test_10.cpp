@@ -0,0 +1,159 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "osc_endpoint.hpp"
+
+/*
+    Checks OSC control: packets built by OscWriter parse back into the
+    right control messages, bundles (nested ones too) arrive in one piece,
+    malformed packets are dropped whole, and messages sent over loopback
+    come out of the endpoint queue in order with sane arrival times.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+std::int64_t nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main()
+{
+    // parsing
+    {
+        OscWriter writer;
+        std::vector<ControlMessage> messages;
+        std::size_t ignored = 0;
+
+        writer.addMessage("/envelope/trigger");
+        bool isOk = parseOscPacket(writer.getData(), writer.getSize(), 5, messages, ignored) &&
+                    messages.size() == 1 && messages[0].type == ControlMessage::GATE_ON && messages[0].arrivalTime == 5;
+        expect("single message", isOk);
+
+        writer.clear();
+        messages.clear();
+        writer.beginBundle();
+        writer.addMessage("/envelope/sustainLevel", 0.25f);
+        writer.addMessage("/envelope/attackTime", 2);
+        writer.beginBundle();
+        writer.addMessage("/envelope/loop", 1);
+        writer.addMessage("/envelope/gate", 0);
+        writer.endBundle();
+        writer.addMessage("/other/thing", 1.0f);
+        writer.addMessage("/envelope/decayCurve");     // a parameter without a value
+        writer.endBundle();
+
+        isOk = parseOscPacket(writer.getData(), writer.getSize(), 0, messages, ignored) && messages.size() == 4 &&
+               messages[0].type == ControlMessage::PARAMETER && messages[0].parameter == AutomationParameter::SUSTAIN_LEVEL &&
+               messages[0].value == 0.25f &&
+               messages[1].parameter == AutomationParameter::ATTACK_TIME && messages[1].value == 2.0f &&
+               messages[2].type == ControlMessage::LOOPING && messages[2].value == 1.0f &&
+               messages[3].type == ControlMessage::GATE_OFF && ignored == 2;
+        expect("nested bundle", isOk);
+
+        // cut short anywhere, a packet is either rejected with nothing of it kept or still well formed
+        std::size_t rejected = 0;
+        bool isNothingKept = true;
+        for (std::size_t size = 1; size < writer.getSize(); size++)
+        {
+            std::vector<ControlMessage> partial;
+            std::size_t partialIgnored = 0;
+            if (!parseOscPacket(writer.getData(), size, 0, partial, partialIgnored))
+            {
+                isNothingKept = isNothingKept && partial.empty() && partialIgnored == 0;
+                rejected++;
+            }
+        }
+        expect("truncated packets", isNothingKept && rejected > 0);
+
+        const unsigned char garbage[] = {'/', 'e', 'n', 'v', 'e', 'l', 'o', 'p'};
+        messages.clear();
+        expect("unterminated address", !parseOscPacket(garbage, sizeof(garbage), 0, messages, ignored) && messages.empty());
+    }
+
+    // over loopback
+    {
+        OscEndpoint endpoint;
+        OscSender sender;
+        bool isOpen = endpoint.open(0) && sender.open(endpoint.getPort());
+        expect("endpoint opens", isOpen);
+        if (!isOpen)
+        {
+            return 1;
+        }
+
+        const int packetCount = 200;
+        OscWriter writer;
+        for (int i = 0; i < packetCount; i++)
+        {
+            writer.clear();
+            writer.beginBundle();
+            writer.addMessage("/envelope/releaseTime", static_cast<float>(i));
+            writer.addMessage("/envelope/trigger");
+            writer.endBundle();
+            sender.send(writer);
+
+            // paced, so the socket buffer never overflows
+            if (i % 16 == 15)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        std::vector<ControlMessage> received;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+        while (received.size() < 2 * packetCount && std::chrono::steady_clock::now() < deadline)
+        {
+            ControlMessage message;
+            while (endpoint.pop(message))
+            {
+                received.push_back(message);
+            }
+        }
+
+        bool isInOrder = received.size() == 2 * packetCount;
+        for (std::size_t i = 0; isInOrder && i < received.size(); i += 2)
+        {
+            isInOrder = received[i].type == ControlMessage::PARAMETER && received[i].value == static_cast<float>(i / 2) &&
+                        received[i + 1].type == ControlMessage::GATE_ON &&
+                        received[i].arrivalTime == received[i + 1].arrivalTime;
+        }
+        expect("every bundle arrives, in order", isInOrder);
+
+        OscEndpoint::Stats stats = endpoint.getStats();
+        expect("stats count packets and messages", stats.packets == packetCount && stats.messages == 2 * packetCount &&
+                                                   stats.droppedPackets == 0 && stats.malformedPackets == 0);
+
+        // one packet on its own, waited for by spinning
+        writer.clear();
+        writer.addMessage("/envelope/release");
+        std::int64_t sendTime = nowNanoseconds();
+        sender.send(writer);
+
+        ControlMessage message = {};
+        while (!endpoint.pop(message) && nowNanoseconds() - sendTime < 1000000000)
+        {
+        }
+        std::int64_t popTime = nowNanoseconds();
+        expect("single packet", message.type == ControlMessage::GATE_OFF);
+        std::cout << "send to pop " << (popTime - sendTime) / 1000.0 << " us, arrival to pop "
+                  << (popTime - message.arrivalTime) / 1000.0 << " us\n";
+
+        endpoint.close();
+        expect("endpoint closes", !endpoint.isOpen());
+    }
+
+    std::cout << (failures == 0 ? "All checks passed." : "OSC checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
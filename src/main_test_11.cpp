@@ -0,0 +1,143 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace.hpp"
+
+/*
+    Checks the trace recorder (build with -DENVELOPE_TRACE): threads record
+    into their own buffers at the same time and all of it ends up in the
+    JSON, a full buffer drops events instead of growing, a new capture
+    starts over, and scopes outside a capture cost next to nothing.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+std::size_t countOccurrences(const std::string& text, const std::string& pattern)
+{
+    std::size_t count = 0;
+    for (std::size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1))
+    {
+        count++;
+    }
+    return count;
+}
+
+std::string readFile(const std::string& path)
+{
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+void recordNested(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        TRACE_SCOPE("outer");
+        TRACE_SCOPE("inner \"quoted\"");
+    }
+}
+
+int main()
+{
+#ifndef ENVELOPE_TRACE
+    std::cout << "Build with -DENVELOPE_TRACE, the macros are compiled out otherwise." << std::endl;
+    return 1;
+#endif
+
+    const std::string path = "trace_test.json";
+
+    // four threads at once
+    {
+        Trace::start();
+        TRACE_THREAD_NAME("main");
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([t]
+            {
+                TRACE_THREAD_NAME("worker");
+                recordNested(1000 * (t + 1));
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        recordNested(10);
+        Trace::stop();
+
+        const std::size_t expected = 2 * (1000 + 2000 + 3000 + 4000 + 10);
+        expect("every event counted", Trace::getEventCount() == expected && Trace::getDroppedCount() == 0);
+
+        bool isWritten = Trace::write(path);
+        std::string json = readFile(path);
+        expect("every event written", isWritten && countOccurrences(json, "\"ph\":\"X\"") == expected);
+        expect("names escaped", countOccurrences(json, "inner \\\"quoted\\\"") == expected / 2);
+        expect("threads named", countOccurrences(json, "\"thread_name\"") == 5);
+        expect("complete JSON", json.find("{\"traceEvents\":[") == 0 && json.rfind("}}\n") == json.size() - 3);
+    }
+
+    // full buffer, then a capture that starts over
+    {
+        Trace::start();
+        const std::size_t extra = 123;
+        for (std::size_t i = 0; i < Trace::EVENTS_PER_THREAD + extra; i++)
+        {
+            TRACE_SCOPE("fill");
+        }
+        Trace::stop();
+        expect("full buffer drops", Trace::getEventCount() == Trace::EVENTS_PER_THREAD && Trace::getDroppedCount() == extra);
+
+        Trace::start();
+        recordNested(5);
+        Trace::stop();
+        expect("new capture starts over", Trace::getEventCount() == 10 && Trace::getDroppedCount() == 0);
+
+        recordNested(5);
+        expect("nothing recorded between captures", Trace::getEventCount() == 10);
+    }
+
+    // cost per scope
+    {
+        const int count = 10000000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+        {
+            TRACE_SCOPE("idle");
+        }
+        double idle = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+
+        Trace::start();
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < Trace::EVENTS_PER_THREAD; i++)
+        {
+            TRACE_SCOPE("capturing");
+        }
+        double capturing = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                           Trace::EVENTS_PER_THREAD;
+        Trace::stop();
+
+        std::cout << "per scope: " << idle << " ns outside a capture, " << capturing << " ns in one\n";
+    }
+
+    std::remove(path.c_str());
+
+    std::cout << (failures == 0 ? "All checks passed." : "Trace checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
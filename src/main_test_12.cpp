@@ -0,0 +1,129 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "preset.hpp"
+
+/*
+    Checks that preset libraries from a damaged or hostile file are
+    refused instead of read past their end: record counts that overflow
+    the size checks, index entries pointing past the records, and records
+    with an unknown version or envelope type.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+const char* PATH = "preset_test.envp";
+
+std::vector<char> readFile(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const char* path, const std::vector<char>& bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+PresetRecord makePreset(const char* name)
+{
+    PresetRecord preset = {};
+    preset.version = PRESET_RECORD_VERSION;
+    preset.envelopeType = static_cast<std::uint8_t>(Envelope::EnvelopeType::ASR);
+    preset.attackTime = 0.1f;
+    preset.decayTime = 0.2f;
+    preset.sustainLevel = 0.5f;
+    preset.releaseTime = 0.3f;
+    preset.setName(name);
+    return preset;
+}
+
+int main()
+{
+    // header: magic, version, record size, record count at 16, index offset at 24
+    const std::size_t RECORD_COUNT_AT = 16;
+    const std::size_t INDEX_OFFSET_AT = 24;
+    const std::size_t HEADER_SIZE = 32;
+
+    PresetLibrary::write(PATH, {makePreset("one"), makePreset("two")});
+    const std::vector<char> good = readFile(PATH);
+
+    {
+        PresetLibrary library;
+        expect("a written library opens", library.open(PATH) && library.getPresetCount() == 2 &&
+                                          library.findPreset("two") != nullptr);
+    }
+
+    // counts whose byte sizes wrap around to the ones in the file
+    {
+        bool isEveryoneRefused = true;
+        for (std::uint64_t count : {(std::uint64_t(1) << 60) + 2, std::uint64_t(1) << 58, std::uint64_t(3)})
+        {
+            std::vector<char> bytes = good;
+            std::memcpy(bytes.data() + RECORD_COUNT_AT, &count, sizeof(count));
+            writeFile(PATH, bytes);
+
+            PresetLibrary library;
+            isEveryoneRefused = isEveryoneRefused && !library.open(PATH);
+        }
+        expect("record counts the file can't hold are refused", isEveryoneRefused);
+    }
+
+    // index entries after the records: hash, then record index
+    {
+        std::uint64_t indexOffset = 0;
+        std::memcpy(&indexOffset, good.data() + INDEX_OFFSET_AT, sizeof(indexOffset));
+
+        std::vector<char> bytes = good;
+        for (std::size_t entry = 0; entry < 2; entry++)
+        {
+            std::uint64_t recordIndex = 1000000 + entry;
+            std::memcpy(bytes.data() + indexOffset + entry * 16 + 8, &recordIndex, sizeof(recordIndex));
+        }
+        writeFile(PATH, bytes);
+
+        PresetLibrary library;
+        expect("index entries past the records are ignored", library.open(PATH) && library.findPreset("one") == nullptr);
+    }
+
+    // records a build doesn't know
+    {
+        PresetRecord badType = makePreset("type");
+        badType.envelopeType = 7;
+        PresetRecord badVersion = makePreset("version");
+        badVersion.version = PRESET_RECORD_VERSION + 1;
+
+        Envelope envelope;
+        envelope.setEnvelopeType(Envelope::EnvelopeType::AD);
+        bool isRefused = !badType.applyTo(envelope) && !badVersion.applyTo(envelope) &&
+                         envelope.getEnvelopeType() == Envelope::EnvelopeType::AD;
+        expect("unknown envelope types and versions aren't applied", isRefused);
+        expect("known records are", makePreset("good").applyTo(envelope) &&
+                                    envelope.getEnvelopeType() == Envelope::EnvelopeType::ASR);
+    }
+
+    // a header and nothing else
+    {
+        writeFile(PATH, std::vector<char>(good.begin(), good.begin() + HEADER_SIZE));
+        PresetLibrary library;
+        expect("a truncated library is refused", !library.open(PATH));
+    }
+
+    std::remove(PATH);
+
+    std::cout << (failures == 0 ? "All checks passed." : "Preset checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
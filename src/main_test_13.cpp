@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "wav_writer.hpp"
+#include "mapped_file.hpp"
+
+/*
+    Checks the WAV headers byte for byte: the 44 byte RIFF layout, the
+    80 byte RF64 layout with its 0xFFFFFFFF size markers and ds64 chunk,
+    where a file switches from one to the other, and that
+    createMappedWavFile() and writeWavFile() put the samples right after
+    either header.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+const char* PATH = "wav_test.wav";
+
+std::vector<unsigned char> readFile(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// little-endian fields
+std::uint64_t readField(const unsigned char* data, int bytes)
+{
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+    {
+        value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+bool hasTag(const unsigned char* data, const char* tag)
+{
+    return std::memcmp(data, tag, 4) == 0;
+}
+
+// the fmt chunk is the same in both layouts
+bool isFormatChunk(const unsigned char* data, unsigned int numChannels, unsigned int sampleRate)
+{
+    return hasTag(data, "fmt ") && readField(data + 4, 4) == 16 &&
+           readField(data + 8, 2) == 3 &&                       // IEEE float
+           readField(data + 10, 2) == numChannels &&
+           readField(data + 12, 4) == sampleRate &&
+           readField(data + 16, 4) == sampleRate * numChannels * 4 &&
+           readField(data + 20, 2) == numChannels * 4 &&
+           readField(data + 22, 2) == 32;
+}
+
+int main()
+{
+    unsigned char header[RF64_HEADER_SIZE];
+
+    // RIFF: sizes in the 32-bit fields, fmt at 12, data at 36
+    {
+        std::size_t size = makeWavHeader(header, 1000, 2, 48000);
+        std::uint64_t dataSize = 1000 * 2 * 4;
+
+        expect("a small file gets the 44 byte header", size == WAV_HEADER_SIZE);
+        expect("RIFF chunk size covers everything after it",
+               hasTag(header, "RIFF") && readField(header + 4, 4) == 36 + dataSize && hasTag(header + 8, "WAVE"));
+        expect("RIFF fmt chunk", isFormatChunk(header + 12, 2, 48000));
+        expect("RIFF data chunk size", hasTag(header + 36, "data") && readField(header + 40, 4) == dataSize);
+    }
+
+    // RF64: 0xFFFFFFFF markers, ds64 at 12, fmt at 48, data at 72
+    {
+        std::size_t numFrames = 600000000;     // 4.8 GB in stereo
+        std::uint64_t dataSize = static_cast<std::uint64_t>(numFrames) * 2 * 4;
+        std::size_t size = makeWavHeader(header, numFrames, 2, 48000);
+
+        expect("a file past 4 GB gets the 80 byte header", size == RF64_HEADER_SIZE);
+        expect("RF64 chunk size is the marker",
+               hasTag(header, "RF64") && readField(header + 4, 4) == 0xFFFFFFFFu && hasTag(header + 8, "WAVE"));
+        expect("ds64 chunk is 28 bytes", hasTag(header + 12, "ds64") && readField(header + 16, 4) == 28);
+        expect("ds64 RIFF size covers everything after the first 8 bytes", readField(header + 20, 8) == 72 + dataSize);
+        expect("ds64 data size", readField(header + 28, 8) == dataSize);
+        expect("ds64 sample count is in frames", readField(header + 36, 8) == numFrames);
+        expect("ds64 has no chunk table", readField(header + 44, 4) == 0);
+        expect("RF64 fmt chunk", isFormatChunk(header + 48, 2, 48000));
+        expect("RF64 data chunk size is the marker",
+               hasTag(header + 72, "data") && readField(header + 76, 4) == 0xFFFFFFFFu);
+    }
+
+    // the largest data that fits the 32-bit fields, in whole mono frames, and one frame more
+    {
+        std::size_t lastRiffFrames = static_cast<std::size_t>(MAX_RIFF_DATA_SIZE / 4);
+        std::size_t riffSize = makeWavHeader(header, lastRiffFrames, 1, 48000);
+        bool isRiff = riffSize == WAV_HEADER_SIZE && readField(header + 4, 4) == 36 + lastRiffFrames * 4ull;
+        expect("data up to the threshold stays RIFF", isRiff);
+        expect("one frame more is RF64", makeWavHeader(header, lastRiffFrames + 1, 1, 48000) == RF64_HEADER_SIZE);
+    }
+
+    // mapped files, samples right after either header
+    const float samples[] = {0.25f, -0.5f, 1.0f};
+    for (std::uint64_t threshold : {MAX_RIFF_DATA_SIZE, std::uint64_t(0)})
+    {
+        std::size_t expectedHeaderSize = threshold == 0 ? RF64_HEADER_SIZE : WAV_HEADER_SIZE;
+        std::size_t headerSize = makeWavHeader(header, 3, 1, 44100, threshold);
+
+        bool isPlaced = false;
+        {
+            MappedFile file;
+            float* data = createMappedWavFile(file, PATH, 3, 1, 44100, threshold);
+            if (data != nullptr)
+            {
+                isPlaced = reinterpret_cast<unsigned char*>(data) == file.getWritableData() + expectedHeaderSize &&
+                           file.getSize() == expectedHeaderSize + sizeof(samples);
+                std::memcpy(data, samples, sizeof(samples));
+                file.flush();
+            }
+        }
+        std::vector<unsigned char> mapped = readFile(PATH);
+
+        writeWavFile(PATH, samples, 3, 1, 44100, threshold);
+        std::vector<unsigned char> written = readFile(PATH);
+
+        bool isLaidOut = mapped.size() == expectedHeaderSize + sizeof(samples) &&
+                         std::memcmp(mapped.data(), header, headerSize) == 0 &&
+                         std::memcmp(mapped.data() + expectedHeaderSize, samples, sizeof(samples)) == 0;
+
+        if (threshold == 0)
+        {
+            expect("mapped RF64 file has its samples at byte 80", isPlaced && isLaidOut);
+            expect("written RF64 file matches the mapped one", written == mapped);
+        }
+        else
+        {
+            expect("mapped RIFF file has its samples at byte 44", isPlaced && isLaidOut);
+            expect("written RIFF file matches the mapped one", written == mapped);
+        }
+    }
+
+    std::remove(PATH);
+
+    std::cout << (failures == 0 ? "All checks passed." : "WAV checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
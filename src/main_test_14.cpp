@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "envelope_generator.hpp"
+
+/*
+    Checks every Envelope::Taps output against a reference made one sample
+    at a time from the plain amplitude render and the envelope's getters:
+    inverted is 1 - amplitude, each phase gate is 1 while the envelope is
+    in its phase after the sample, endOfCycle marks the sample a release
+    (or AD decay) ends on, and progress is getProgress() after the sample.
+    Tapped renders use uneven block sizes, so segments end on block edges
+    and inside blocks, and include looping envelopes over many cycles.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+const float SAMPLE_RATE = 48000.f;
+
+// trigger() or release() before the given sample
+struct GateEvent
+{
+    int sample;
+    bool isOn;
+};
+
+struct Signals
+{
+    std::vector<float> amplitude;
+    std::vector<float> inverted;
+    std::vector<float> endOfCycle;
+    std::vector<float> gates[4];    // attack, decay, sustain, release
+    std::vector<float> progress;
+
+    explicit Signals(int length)
+    : amplitude(length)
+    , inverted(length)
+    , endOfCycle(length)
+    , gates{std::vector<float>(length), std::vector<float>(length), std::vector<float>(length), std::vector<float>(length)}
+    , progress(length)
+    {
+    }
+};
+
+void setUp(Envelope& envelope, Envelope::EnvelopeType type, bool isLooping)
+{
+    envelope.setTimingMode(Envelope::TimingMode::SAMPLE_COUNT);
+    envelope.setEnvelopeType(type);
+    envelope.setLooping(isLooping);
+    envelope.setAttackTime(0.01f);
+    envelope.setAttackCurve(3.f);
+    envelope.setDecayTime(0.023f);
+    envelope.setDecayCurve(-4.f);
+    envelope.setSustainLevel(0.6f);
+    envelope.setReleaseTime(0.017f);
+    envelope.setReleaseCurve(2.f);
+}
+
+void applyEvents(Envelope& envelope, const std::vector<GateEvent>& events, int sample)
+{
+    for (const GateEvent& event : events)
+    {
+        if (event.sample == sample)
+        {
+            if (event.isOn)
+            {
+                envelope.trigger();
+            }
+            else
+            {
+                envelope.release();
+            }
+        }
+    }
+}
+
+// one sample per renderBlock(), taps worked out from the getters
+Signals renderReference(Envelope::EnvelopeType type, bool isLooping, const std::vector<GateEvent>& events, int length)
+{
+    const Envelope::Phase GATE_PHASES[] = {Envelope::Phase::ATTACK, Envelope::Phase::DECAY,
+                                           Envelope::Phase::SUSTAIN, Envelope::Phase::RELEASE};
+
+    Envelope envelope;
+    setUp(envelope, type, isLooping);
+    Signals signals(length);
+
+    for (int i = 0; i < length; i++)
+    {
+        applyEvents(envelope, events, i);
+
+        Envelope::Phase before = envelope.getPhase();
+        envelope.renderBlock(&signals.amplitude[i], 1, SAMPLE_RATE);
+        Envelope::Phase after = envelope.getPhase();
+
+        bool isCycleEnd = before == Envelope::Phase::RELEASE ||
+                          (before == Envelope::Phase::DECAY && type == Envelope::EnvelopeType::AD);
+
+        signals.inverted[i] = 1.0f - signals.amplitude[i];
+        signals.endOfCycle[i] = (isCycleEnd && after != before) ? 1.0f : 0.0f;
+        for (int gate = 0; gate < 4; gate++)
+        {
+            signals.gates[gate][i] = (after == GATE_PHASES[gate]) ? 1.0f : 0.0f;
+        }
+        signals.progress[i] = envelope.getProgress();
+    }
+    return signals;
+}
+
+// every tap at once, blocks of the given sizes in turn, split at the gate events
+Signals renderTapped(Envelope::EnvelopeType type, bool isLooping, const std::vector<GateEvent>& events, int length,
+                     const std::vector<int>& blockSizes)
+{
+    Envelope envelope;
+    setUp(envelope, type, isLooping);
+    Signals signals(length);
+
+    int i = 0;
+    for (std::size_t block = 0; i < length; block++)
+    {
+        applyEvents(envelope, events, i);
+
+        int end = std::min(i + blockSizes[block % blockSizes.size()], length);
+        for (const GateEvent& event : events)
+        {
+            if (event.sample > i && event.sample < end)
+            {
+                end = event.sample;
+            }
+        }
+
+        Envelope::Taps taps;
+        taps.amplitude = &signals.amplitude[i];
+        taps.inverted = &signals.inverted[i];
+        taps.endOfCycle = &signals.endOfCycle[i];
+        taps.attackGate = &signals.gates[0][i];
+        taps.decayGate = &signals.gates[1][i];
+        taps.sustainGate = &signals.gates[2][i];
+        taps.releaseGate = &signals.gates[3][i];
+        taps.progress = &signals.progress[i];
+
+        envelope.renderBlock(taps, end - i, SAMPLE_RATE);
+        i = end;
+    }
+    return signals;
+}
+
+bool isClose(const std::vector<float>& a, const std::vector<float>& b, float tolerance)
+{
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        if (std::abs(a[i] - b[i]) > tolerance)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int countOnes(const std::vector<float>& signal)
+{
+    return static_cast<int>(std::count(signal.begin(), signal.end(), 1.0f));
+}
+
+void checkTaps(const char* name, Envelope::EnvelopeType type, bool isLooping, const std::vector<GateEvent>& events,
+               int length, int expectedCycleEnds)
+{
+    // single samples, powers of two, and odd sizes that land anywhere in a segment
+    const std::vector<std::vector<int>> SPLITS = {{1}, {64}, {4096}, {7, 1, 130, 3, 61, 1000, 2}};
+
+    Signals expected = renderReference(type, isLooping, events, length);
+
+    bool isAmplitudeOk = true;
+    bool isInvertedOk = true;
+    bool isEndOfCycleOk = true;
+    bool isGateOk = true;
+    bool isProgressOk = true;
+
+    for (const std::vector<int>& blockSizes : SPLITS)
+    {
+        Signals actual = renderTapped(type, isLooping, events, length, blockSizes);
+
+        isAmplitudeOk = isAmplitudeOk && actual.amplitude == expected.amplitude;
+        isInvertedOk = isInvertedOk && actual.inverted == expected.inverted;
+        isEndOfCycleOk = isEndOfCycleOk && actual.endOfCycle == expected.endOfCycle;
+        for (int gate = 0; gate < 4; gate++)
+        {
+            isGateOk = isGateOk && actual.gates[gate] == expected.gates[gate];
+        }
+        isProgressOk = isProgressOk && isClose(actual.progress, expected.progress, 1e-5f);
+    }
+
+    std::cout << name << "\n";
+    expect("  amplitude matches the one sample render", isAmplitudeOk);
+    expect("  inverted is 1 - amplitude", isInvertedOk);
+    expect("  endOfCycle marks the samples cycles end on", isEndOfCycleOk &&
+                                                          countOnes(expected.endOfCycle) == expectedCycleEnds);
+    expect("  phase gates follow the phase", isGateOk);
+    expect("  progress follows getProgress()", isProgressOk);
+}
+
+int main()
+{
+    // 10 ms attack, 23 ms decay, 17 ms release at 48 kHz: 480, 1104 and 816 samples
+    const int LENGTH = 24000;
+
+    // held into sustain, released, retriggered during the release and released again
+    std::vector<GateEvent> notes = {{0, true}, {3000, false}, {3500, true}, {9000, false}};
+
+    checkTaps("ADSR", Envelope::EnvelopeType::ADSR, false, notes, LENGTH, 1);
+    checkTaps("ASR", Envelope::EnvelopeType::ASR, false, notes, LENGTH, 1);
+    checkTaps("AD", Envelope::EnvelopeType::AD, false, notes, LENGTH, 2);
+
+    // one trigger, then cycles of 1584 samples to the end
+    checkTaps("looping AD", Envelope::EnvelopeType::AD, true, {{0, true}}, LENGTH, LENGTH / 1584);
+    checkTaps("looping ADSR, released", Envelope::EnvelopeType::ADSR, true, {{0, true}, {2000, false}}, LENGTH, 1);
+
+    std::cout << (failures == 0 ? "All checks passed." : "Tap checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "envelope_generator.hpp"
+
+/*
+    Checks time and curve modulation through renderBlock(taps, modulation):
+    attack, decay and release time and curve buffers, stepped, audio rate,
+    and single-sample changes between held stretches, against a reference
+    that calls the setters before every one sample render. The output has
+    to be identical with TimingMode::SAMPLE_COUNT, and within a small
+    tolerance with CONTINUOUS, where a run adds up its time differently.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+const float SAMPLE_RATE = 48000.f;
+const int LENGTH = 12000;
+
+enum class Pattern
+{
+    STEPPED,        // held for 100 samples at a time
+    AUDIO_RATE,     // new value every sample
+    MIXED           // audio rate, then held with single-sample blips
+};
+
+// the six time and curve buffers
+struct ModulationBuffers
+{
+    std::vector<float> values[6];
+
+    explicit ModulationBuffers(Pattern pattern)
+    {
+        const float CENTRES[] = {0.01f, 0.f, 0.02f, 0.f, 0.015f, 0.f};
+        const float DEPTHS[] = {0.005f, 5.f, 0.01f, 5.f, 0.005f, 5.f};
+
+        for (int buffer = 0; buffer < 6; buffer++)
+        {
+            values[buffer].resize(LENGTH);
+            for (int i = 0; i < LENGTH; i++)
+            {
+                int position = i;
+                if (pattern == Pattern::STEPPED)
+                {
+                    position = i / 100 * 100;
+                }
+                else if (pattern == Pattern::MIXED && i >= 2000)
+                {
+                    position = (i % 300 == 150) ? i : 2000;
+                }
+                values[buffer][i] = CENTRES[buffer] + DEPTHS[buffer] * std::sin(position * 0.003f + buffer);
+            }
+        }
+    }
+
+    Envelope::Modulation at(int offset) const
+    {
+        Envelope::Modulation modulation;
+        modulation.attackTime = values[0].data() + offset;
+        modulation.attackCurve = values[1].data() + offset;
+        modulation.decayTime = values[2].data() + offset;
+        modulation.decayCurve = values[3].data() + offset;
+        modulation.releaseTime = values[4].data() + offset;
+        modulation.releaseCurve = values[5].data() + offset;
+        return modulation;
+    }
+};
+
+void setUp(Envelope& envelope, Envelope::EnvelopeType type, Envelope::TimingMode timingMode)
+{
+    envelope.setTimingMode(timingMode);
+    envelope.setEnvelopeType(type);
+    envelope.setLooping(type == Envelope::EnvelopeType::AD);
+    envelope.setSustainLevel(0.6f);
+}
+
+// trigger at 0, release at 4000, again at 6000 and 9000; AD loops the whole time
+void applyGate(Envelope& envelope, int sample)
+{
+    if (sample == 0 || sample == 6000)
+    {
+        envelope.trigger();
+    }
+    else if (sample == 4000 || sample == 9000)
+    {
+        envelope.release();
+    }
+}
+
+std::vector<float> renderReference(Envelope::EnvelopeType type, Envelope::TimingMode timingMode,
+                                   const ModulationBuffers& buffers)
+{
+    Envelope envelope;
+    setUp(envelope, type, timingMode);
+    std::vector<float> output(LENGTH);
+
+    for (int i = 0; i < LENGTH; i++)
+    {
+        applyGate(envelope, i);
+        envelope.setAttackTime(buffers.values[0][i]);
+        envelope.setAttackCurve(buffers.values[1][i]);
+        envelope.setDecayTime(buffers.values[2][i]);
+        envelope.setDecayCurve(buffers.values[3][i]);
+        envelope.setReleaseTime(buffers.values[4][i]);
+        envelope.setReleaseCurve(buffers.values[5][i]);
+        envelope.renderBlock(&output[i], 1, SAMPLE_RATE);
+    }
+    return output;
+}
+
+// blocks of the given sizes in turn, split at the gate changes
+std::vector<float> renderModulated(Envelope::EnvelopeType type, Envelope::TimingMode timingMode,
+                                   const ModulationBuffers& buffers, const std::vector<int>& blockSizes)
+{
+    const int GATE_CHANGES[] = {4000, 6000, 9000};
+
+    Envelope envelope;
+    setUp(envelope, type, timingMode);
+    std::vector<float> output(LENGTH);
+
+    int i = 0;
+    for (std::size_t block = 0; i < LENGTH; block++)
+    {
+        applyGate(envelope, i);
+
+        int end = std::min(i + blockSizes[block % blockSizes.size()], LENGTH);
+        for (int change : GATE_CHANGES)
+        {
+            if (change > i && change < end)
+            {
+                end = change;
+            }
+        }
+
+        Envelope::Taps taps;
+        taps.amplitude = &output[i];
+        envelope.renderBlock(taps, buffers.at(i), end - i, SAMPLE_RATE);
+        i = end;
+    }
+    return output;
+}
+
+float getMaxError(const std::vector<float>& a, const std::vector<float>& b)
+{
+    float maxError = 0.0f;
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        maxError = std::max(maxError, std::abs(a[i] - b[i]));
+    }
+    return maxError;
+}
+
+int main()
+{
+    const std::vector<std::vector<int>> SPLITS = {{256}, {1}, {7, 1, 130, 3, 61, 1000, 2}};
+    const Envelope::EnvelopeType TYPES[] = {Envelope::EnvelopeType::ADSR, Envelope::EnvelopeType::AD};
+    const char* TYPE_NAMES[] = {"ADSR", "looping AD"};
+    const Pattern PATTERNS[] = {Pattern::STEPPED, Pattern::AUDIO_RATE, Pattern::MIXED};
+    const char* PATTERN_NAMES[] = {"stepped", "audio rate", "single samples between holds"};
+
+    for (int pattern = 0; pattern < 3; pattern++)
+    {
+        ModulationBuffers buffers(PATTERNS[pattern]);
+
+        for (int type = 0; type < 2; type++)
+        {
+            std::vector<float> counted = renderReference(TYPES[type], Envelope::TimingMode::SAMPLE_COUNT, buffers);
+            std::vector<float> continuous = renderReference(TYPES[type], Envelope::TimingMode::CONTINUOUS, buffers);
+
+            bool isExact = true;
+            float continuousError = 0.0f;
+            for (const std::vector<int>& blockSizes : SPLITS)
+            {
+                isExact = isExact && renderModulated(TYPES[type], Envelope::TimingMode::SAMPLE_COUNT, buffers, blockSizes) == counted;
+                continuousError = std::max(continuousError, getMaxError(continuous,
+                    renderModulated(TYPES[type], Envelope::TimingMode::CONTINUOUS, buffers, blockSizes)));
+            }
+
+            std::cout << TYPE_NAMES[type] << ", " << PATTERN_NAMES[pattern] << "\n";
+            expect("  sample count timing matches the setters exactly", isExact);
+            expect("  continuous timing is within 1e-4 of them", continuousError <= 1e-4f);
+        }
+    }
+
+    std::cout << (failures == 0 ? "All checks passed." : "Modulation checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
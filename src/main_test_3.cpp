@@ -0,0 +1,151 @@
+#include <iostream>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+#include "alloc_tracker.hpp"
+#include "envelope_generator.hpp"
+#include "envelope_visualizer.hpp"
+#include "knob.hpp"
+#include "slider.hpp"
+#include "voice_pool.hpp"
+
+/*
+    Checks that the hot paths don't allocate once warmed up: the block and
+    voice renderers, the visualizer update, and the widget setters the frame
+    loop calls while a value holds (OSC repeats, held automation, the value
+    text refresh on every event). A new value rebuilds the widget's text,
+    and SFML allocates for that, so value changes aren't covered.
+    Build with ENVELOPE_TRACK_ALLOCATIONS defined and alloc_tracker.cpp linked in.
+*/
+
+static int failures = 0;
+
+void expectNoAllocations(const char* name, const AllocScope& scope)
+{
+    if (scope.getAllocations() != 0)
+    {
+        std::cout << "FAIL: " << name << " allocated " << scope.getAllocations()
+                  << " times (" << scope.getBytes() << " bytes)\n";
+        failures++;
+    }
+    else
+    {
+        std::cout << "ok:   " << name << "\n";
+    }
+}
+
+int main()
+{
+    if (!AllocTracker::isEnabled())
+    {
+        std::cout << "Allocation tracking is not compiled in, nothing to check." << std::endl;
+        return 0;
+    }
+
+    const float sampleRate = 48000.f;
+    const int blockSize = 256;
+    std::vector<float> block(blockSize);
+
+    Envelope envelope;
+    envelope.setAttackTime(0.01f);
+    envelope.setDecayTime(0.02f);
+    envelope.setReleaseTime(0.05f);
+    envelope.setAttackCurve(3.f);
+    envelope.setDecayCurve(-2.f);
+    envelope.setReleaseCurve(5.f);
+    envelope.setLooping(true);
+
+    // block renderer, every envelope type through every phase
+    for (auto type : {Envelope::EnvelopeType::ADSR, Envelope::EnvelopeType::ASR, Envelope::EnvelopeType::AD})
+    {
+        envelope.setEnvelopeType(type);
+        envelope.trigger();
+
+        AllocScope scope;
+        for (int i = 0; i < 100; i++)
+        {
+            if (i == 50)
+            {
+                envelope.release();
+            }
+            envelope.renderBlock(block.data(), blockSize, sampleRate);
+        }
+        expectNoAllocations("Envelope::renderBlock", scope);
+    }
+
+    // polyphonic rendering, voices starting, tails cut short and voices going back to the pool
+    {
+        VoicePool pool(16, blockSize);
+        pool.setSilenceThreshold(-96.f);
+        envelope.setLooping(false);
+        envelope.setEnvelopeType(Envelope::EnvelopeType::ADSR);
+
+        AllocScope scope;
+        for (int i = 0; i < 400; i++)
+        {
+            if (i % 10 == 0)
+            {
+                pool.noteOff(pool.noteOn(envelope));
+            }
+            pool.render(block.data(), blockSize, sampleRate);
+        }
+        expectNoAllocations("VoicePool::render", scope);
+    }
+
+    // UI frame loop, minus the window
+    EnvelopeVisualizer visualizer(envelope);
+    visualizer.setPosition(sf::Vector2f(0.f, 0.f), sf::Vector2f(500.f, 300.f), envelope);
+    envelope.setLooping(false);
+
+    for (auto type : {Envelope::EnvelopeType::ADSR, Envelope::EnvelopeType::ASR, Envelope::EnvelopeType::AD})
+    {
+        // first frame for each type may grow the vertex arrays
+        envelope.setEnvelopeType(type);
+        envelope.trigger();
+        visualizer.update(envelope);
+    }
+
+    AllocScope frames;
+    for (int frame = 0; frame < 600; frame++)
+    {
+        envelope.setEnvelopeType(static_cast<Envelope::EnvelopeType>((frame / 100) % 3));
+        envelope.setAttackCurve(static_cast<float>(frame % 20) - 10.f);
+
+        if (frame % 100 == 0)
+        {
+            envelope.trigger();
+        }
+        else if (frame % 100 == 60)
+        {
+            envelope.release();
+        }
+
+        envelope.update(1.f / 60.f);
+        visualizer.update(envelope);
+    }
+    expectNoAllocations("EnvelopeVisualizer::update", frames);
+
+    // widget values that hold, set every frame like OSC and automation do,
+    // after the first setValue() has built the text for them
+    Slider slider(0.01f, 3.f, "Attack");
+    Knob knob(Knob::KnobType::Centered, -10.f, 10.f, 0.f, 22.f, "");
+    slider.setPosition(sf::Vector2f(20.f, 30.f), sf::Vector2f(200.f, 30.f));
+    knob.setPosition(sf::Vector2f(250.f, 30.f));
+    slider.setValue(0.25f);
+    knob.setValue(-3.5f);
+
+    AllocScope widgets;
+    for (int frame = 0; frame < 600; frame++)
+    {
+        slider.setValue(0.25f);
+        knob.setValue(-3.5f);
+
+        // the knob ignores values out of its range and keeps showing the last one
+        knob.setValue(20.f);
+    }
+    expectNoAllocations("Slider::setValue and Knob::setValue, unchanged values", widgets);
+
+    std::cout << (failures == 0 ? "All checks passed." : "Allocation checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
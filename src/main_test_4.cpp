@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "automation.hpp"
+
+/*
+    Checks automation lanes: the cursor based player against a plain
+    per-sample interpolation, block sizes and seeking, time and curve
+    ramps held over control intervals, and the CSV and
+    binary formats loading the same lanes, and a corrupt binary file
+    failing to load instead of allocating what its header claims.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+// the straightforward version: search the lane for every sample,
+// time and curve ramps held from the start of each control interval
+float evaluate(const AutomationLane& lane, std::uint64_t sample)
+{
+    const std::vector<AutomationPoint>& points = lane.points;
+
+    if (sample <= points.front().sample)
+    {
+        return points.front().value;
+    }
+    for (std::size_t i = 1; i < points.size(); i++)
+    {
+        if (sample < points[i].sample)
+        {
+            const AutomationPoint& from = points[i - 1];
+            const AutomationPoint& to = points[i];
+            double slope = (static_cast<double>(to.value) - from.value) / static_cast<double>(to.sample - from.sample);
+            if (lane.parameter != AutomationParameter::SUSTAIN_LEVEL)
+            {
+                sample = std::max(from.sample, sample / AutomationPlayer::CONTROL_INTERVAL * AutomationPlayer::CONTROL_INTERVAL);
+            }
+            return static_cast<float>(from.value + slope * static_cast<double>(sample - from.sample));
+        }
+    }
+    return points.back().value;
+}
+
+// worst difference between the player and evaluate() over length samples, starting at start
+float compare(const std::vector<AutomationLane>& lanes, std::uint64_t start, std::uint64_t length, int blockSize)
+{
+    AutomationPlayer player(lanes);
+    player.seek(start);
+
+    const float* buffers[] = {nullptr, nullptr};
+    float worst = 0.0f;
+
+    for (std::uint64_t position = start; position < start + length; position += blockSize)
+    {
+        const Envelope::Modulation& modulation = player.renderBlock(blockSize);
+        buffers[0] = modulation.sustainLevel;
+        buffers[1] = modulation.releaseCurve;
+
+        for (int lane = 0; lane < 2; lane++)
+        {
+            for (int i = 0; i < blockSize; i++)
+            {
+                float expected = evaluate(lanes[lane], position + i);
+                worst = std::max(worst, std::fabs(buffers[lane][i] - expected) / std::max(1.0f, std::fabs(expected)));
+            }
+        }
+    }
+    return worst;
+}
+
+// the curve lane's value only changes on a control interval boundary or a breakpoint
+bool isStepped(const AutomationLane& lane, std::uint64_t length, int blockSize)
+{
+    std::vector<AutomationLane> lanes = {lane};    // the player keeps pointers to the lanes
+    AutomationPlayer player(lanes);
+    float previous = lane.points.front().value;
+
+    for (std::uint64_t position = 0; position < length; position += blockSize)
+    {
+        const float* buffer = player.renderBlock(blockSize).releaseCurve;
+
+        for (int i = 0; i < blockSize; i++)
+        {
+            std::uint64_t sample = position + i;
+            bool isBreakpoint = std::any_of(lane.points.begin(), lane.points.end(),
+                                            [sample](const AutomationPoint& point) { return point.sample == sample; });
+
+            if (buffer[i] != previous && sample % AutomationPlayer::CONTROL_INTERVAL != 0 && !isBreakpoint)
+            {
+                return false;
+            }
+            previous = buffer[i];
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    const float sampleRate = 48000.f;
+    const char* csvPath = "automation_test.csv";
+    const char* binaryPath = "automation_test.enva";
+
+    {
+        std::ofstream csv(csvPath);
+        csv << "# parameter,time,value\n"
+            << "sustainLevel,0.5,0.2\n"
+            << "sustainLevel,0.1,0.8\n"       // out of order on purpose
+            << "sustainLevel,0.5,0.9\n"       // a jump
+            << "sustainLevel,2.0,0.4\n"
+            << "releaseCurve,0.0,-5\n";
+
+        for (int i = 1; i <= 1000; i++)
+        {
+            csv << "releaseCurve," << i * 0.003 << "," << ((i % 2) ? 5 : -5) << "\n";
+        }
+    }
+
+    std::vector<AutomationLane> lanes;
+    expect("load CSV", loadAutomation(csvPath, sampleRate, lanes) && lanes.size() == 2);
+    expect("CSV points sorted", lanes.size() == 2 && lanes[0].points.front().value == 0.8f && lanes[0].points[1].value == 0.2f);
+
+    std::uint64_t length = static_cast<std::uint64_t>(3.5 * sampleRate);
+    expect("player matches interpolation, 256 blocks", compare(lanes, 0, length, 256) < 1e-5f);
+    expect("player matches interpolation, 1 sample blocks", compare(lanes, 0, 20000, 1) < 1e-5f);
+    expect("player matches interpolation, odd blocks", compare(lanes, 0, length, 77) < 1e-5f);
+    expect("player matches interpolation after seek", compare(lanes, 61234, 48000, 128) < 1e-5f);
+    expect("curve ramps change only at control intervals and breakpoints", isStepped(lanes[1], length, 77));
+
+    std::vector<AutomationLane> reloaded;
+    expect("save binary", saveAutomation(binaryPath, sampleRate, lanes));
+    expect("load binary", loadAutomation(binaryPath, sampleRate, reloaded));
+    expect("binary matches CSV", hashAutomation(lanes, 0) == hashAutomation(reloaded, 0));
+
+    // the first lane's point count (after the 16 byte header and the parameter) says 4 billion
+    {
+        std::fstream binary(binaryPath, std::ios::in | std::ios::out | std::ios::binary);
+        const std::uint32_t pointCount = 0xFFFFFFFF;
+        binary.seekp(16 + 4);
+        binary.write(reinterpret_cast<const char*>(&pointCount), sizeof(pointCount));
+    }
+    expect("a corrupt point count is refused, not allocated", !loadAutomation(binaryPath, sampleRate, reloaded) && reloaded.empty());
+
+    std::remove(csvPath);
+    std::remove(binaryPath);
+
+    std::cout << (failures == 0 ? "All checks passed." : "Automation checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
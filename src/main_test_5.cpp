@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "envelope_generator.hpp"
+#include "stage_envelope.hpp"
+
+/*
+    Checks that the ADSR, ASR and AD presets of StageEnvelope render the
+    same samples as Envelope::renderBlock(), looping or not, with release
+    at different points, and that a DAHDSR table does what it says.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+// renders both with the same gate, blocks of blockSize, releasing at block releaseBlock
+bool matches(Envelope& envelope, int blockSize, int releaseBlock, int blockCount)
+{
+    const float sampleRate = 48000.f;
+    std::vector<float> expected(blockSize);
+    std::vector<float> actual(blockSize);
+
+    StageEnvelope stages;
+    stages.setFromEnvelope(envelope);
+
+    envelope.reset();
+    envelope.trigger();
+    stages.trigger();
+
+    for (int block = 0; block < blockCount; block++)
+    {
+        if (block == releaseBlock)
+        {
+            envelope.release();
+            stages.release();
+        }
+
+        Envelope::BlockInfo expectedInfo = envelope.renderBlock(expected.data(), blockSize, sampleRate);
+        StageEnvelope::BlockInfo actualInfo = stages.renderBlock(actual.data(), blockSize, sampleRate);
+
+        if (expected != actual || expectedInfo.isConstant != actualInfo.isConstant)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    Envelope envelope;
+    envelope.setAttackTime(0.01f);
+    envelope.setDecayTime(0.023f);
+    envelope.setSustainLevel(0.6f);
+    envelope.setReleaseTime(0.031f);
+    envelope.setAttackCurve(3.f);
+    envelope.setDecayCurve(-2.f);
+    envelope.setReleaseCurve(5.f);
+
+    for (bool isLooping : {false, true})
+    {
+        envelope.setLooping(isLooping);
+
+        for (auto type : {Envelope::EnvelopeType::ADSR, Envelope::EnvelopeType::ASR, Envelope::EnvelopeType::AD})
+        {
+            envelope.setEnvelopeType(type);
+
+            bool isOk = true;
+            for (int blockSize : {1, 7, 64, 256})
+            {
+                // released during the attack, the decay, the sustain, and never
+                for (int releaseSample : {240, 960, 4800, 48000})
+                {
+                    isOk = isOk && matches(envelope, blockSize, releaseSample / blockSize, 48000 / blockSize);
+                }
+            }
+
+            const char* names[] = {"ADSR", "ASR", "AD"};
+            std::cout << names[static_cast<int>(type)] << (isLooping ? " looping" : "") << ": ";
+            expect("preset matches Envelope::renderBlock", isOk);
+        }
+    }
+
+    // delay, attack, hold, decay, sustain, release
+    {
+        const float sampleRate = 1000.f;
+        std::vector<float> output(400);
+
+        StageEnvelope stages;
+        stages.setDAHDSR(0.05f, 0.05f, 1.f, 0.1f, 0.05f, 1.f, 0.5f, 0.05f, 1.f);
+        stages.trigger();
+        stages.renderBlock(output.data(), 300, sampleRate);
+
+        expect("DAHDSR silent during the delay", output[0] == 0.f && output[48] == 0.f);
+        expect("DAHDSR peaks after the attack", std::fabs(output[99] - 1.f) < 1e-6f);
+        expect("DAHDSR holds the peak", output[120] == 1.f && output[198] == 1.f);
+        expect("DAHDSR sustains after the decay", stages.isSustaining() && output[299] == 0.5f);
+
+        stages.release();
+        stages.renderBlock(output.data(), 100, sampleRate);
+        expect("DAHDSR goes inactive after the release", !stages.isActive() && output[99] == 0.f);
+    }
+
+    {
+        StageEnvelope stages;
+        std::vector<EnvelopeStage> tooMany(StageEnvelope::MAX_STAGES + 1, EnvelopeStage{1.f, 1.f, 1.f, 0});
+        expect("too many stages refused", !stages.setStages(tooMany.data(), static_cast<int>(tooMany.size())));
+        expect("no stages refused", !stages.setStages(tooMany.data(), 0));
+    }
+
+    std::cout << (failures == 0 ? "All checks passed." : "Stage envelope checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "envelope_generator.hpp"
+
+/*
+    Checks TimingMode::SAMPLE_COUNT: the same gates rendered with any
+    block size give bit-identical amplitude and taps, with and without
+    modulation, and a looping envelope keeps the exact same period for
+    an hour.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+const float SAMPLE_RATE = 48000.f;
+
+struct Render
+{
+    std::vector<float> amplitude;
+    std::vector<float> progress;
+    std::vector<float> endOfCycle;
+};
+
+// gate on at 1000, off at 30000, on again at 50000 mid-release, off at 90000
+Render render(Envelope::EnvelopeType type, bool isLooping, int blockSize, const std::vector<float>* sustainLevel)
+{
+    const int length = 150000;
+    const int edges[] = {1000, 30000, 50000, 90000};
+
+    Envelope envelope;
+    envelope.setTimingMode(Envelope::TimingMode::SAMPLE_COUNT);
+    envelope.setEnvelopeType(type);
+    envelope.setAttackTime(0.0123f);
+    envelope.setAttackCurve(3.f);
+    envelope.setDecayTime(0.0456f);
+    envelope.setDecayCurve(-2.f);
+    envelope.setSustainLevel(0.6f);
+    envelope.setReleaseTime(0.789f);
+    envelope.setReleaseCurve(5.f);
+    envelope.setLooping(isLooping);
+    envelope.setSilenceThreshold(-60.f);
+
+    Render result{std::vector<float>(length), std::vector<float>(length), std::vector<float>(length)};
+    int position = 0;
+    int edge = 0;
+
+    while (position < length)
+    {
+        if (edge < 4 && position == edges[edge])
+        {
+            (edge % 2 == 0) ? envelope.trigger() : envelope.release();
+            edge++;
+        }
+
+        // blocks end early on a gate edge, like renderGateTimeline()
+        int end = std::min(position + blockSize, length);
+        if (edge < 4)
+        {
+            end = std::min(end, edges[edge]);
+        }
+
+        Envelope::Taps taps;
+        taps.amplitude = result.amplitude.data() + position;
+        taps.progress = result.progress.data() + position;
+        taps.endOfCycle = result.endOfCycle.data() + position;
+
+        if (sustainLevel)
+        {
+            Envelope::Modulation modulation;
+            modulation.sustainLevel = sustainLevel->data() + position;
+            envelope.renderBlock(taps, modulation, end - position, SAMPLE_RATE);
+        }
+        else
+        {
+            envelope.renderBlock(taps, end - position, SAMPLE_RATE);
+        }
+        position = end;
+    }
+    return result;
+}
+
+bool isSame(const Render& a, const Render& b)
+{
+    return a.amplitude == b.amplitude && a.progress == b.progress && a.endOfCycle == b.endOfCycle;
+}
+
+int main()
+{
+    // a sustain sweep then a hold, so modulation goes through single samples and runs
+    std::vector<float> sustainLevel(150000);
+    for (std::size_t i = 0; i < sustainLevel.size(); i++)
+    {
+        sustainLevel[i] = (i < 60000) ? 0.3f + 0.5f * static_cast<float>(i) / 60000.f : 0.5f;
+    }
+
+    const char* names[] = {"ADSR", "ASR", "AD"};
+    const std::vector<float>* modulations[] = {nullptr, &sustainLevel};
+
+    for (int type = 0; type < 3; type++)
+    {
+        for (bool isLooping : {false, true})
+        {
+            for (const std::vector<float>* modulation : modulations)
+            {
+                auto envelopeType = static_cast<Envelope::EnvelopeType>(type);
+                Render reference = render(envelopeType, isLooping, 150000, modulation);
+
+                bool isOk = true;
+                for (int blockSize : {1, 7, 64, 256, 1000})
+                {
+                    isOk = isOk && isSame(reference, render(envelopeType, isLooping, blockSize, modulation));
+                }
+
+                std::cout << names[type] << (isLooping ? " looping" : "") << (modulation ? " modulated" : "") << ": ";
+                expect("bit-identical for every block size", isOk);
+            }
+        }
+    }
+
+    // an hour of a looping AD, every cycle exactly round(attack) + round(decay) samples
+    {
+        Envelope envelope;
+        envelope.setTimingMode(Envelope::TimingMode::SAMPLE_COUNT);
+        envelope.setEnvelopeType(Envelope::EnvelopeType::AD);
+        envelope.setAttackTime(0.0123f);
+        envelope.setDecayTime(0.0456f);
+        envelope.setLooping(true);
+        envelope.trigger();
+
+        const long long period = std::llround(0.0123 * SAMPLE_RATE) + std::llround(0.0456 * SAMPLE_RATE);
+        const long long length = 3600LL * 48000;
+        const int blockSize = 333;
+
+        std::vector<float> endOfCycle(blockSize);
+        std::vector<float> amplitude(blockSize);
+        long long cycles = 0;
+        bool isOk = true;
+
+        for (long long position = 0; position < length; position += blockSize)
+        {
+            Envelope::Taps taps;
+            taps.amplitude = amplitude.data();
+            taps.endOfCycle = endOfCycle.data();
+            envelope.renderBlock(taps, blockSize, SAMPLE_RATE);
+
+            for (int i = 0; i < blockSize; i++)
+            {
+                if (endOfCycle[i] == 1.f)
+                {
+                    cycles++;
+                    isOk = isOk && (position + i + 1 == cycles * period);
+                }
+            }
+        }
+        expect("an hour of looping keeps the exact period", isOk && cycles == length / period);
+    }
+
+    std::cout << (failures == 0 ? "All checks passed." : "Timing checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "gate_timeline.hpp"
+
+/*
+    Checks renderGateTimelineRange(): a timeline cut into ranges, each
+    rendered by a fresh envelope in reverse order, gives the same bits and
+    the same skipped sample count as renderGateTimeline() in one go, for
+    every type, looping or not, with and without a silence threshold.
+    Chunk edges land on gate edges, inside segments and in sustains.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+const float SAMPLE_RATE = 48000.f;
+
+void setup(Envelope& envelope, Envelope::EnvelopeType type, bool isLooping, float silence)
+{
+    envelope.setTimingMode(Envelope::TimingMode::SAMPLE_COUNT);
+    envelope.setEnvelopeType(type);
+    envelope.setAttackTime(0.0123f);
+    envelope.setAttackCurve(3.f);
+    envelope.setDecayTime(0.0456f);
+    envelope.setDecayCurve(-2.f);
+    envelope.setSustainLevel(0.6f);
+    envelope.setReleaseTime(0.789f);
+    envelope.setReleaseCurve(5.f);
+    envelope.setLooping(isLooping);
+    envelope.setSilenceThreshold(silence);
+}
+
+// renders the timeline in chunks of chunkSize, last chunk first, adds up the skipped samples
+std::vector<float> renderChunks(const GateTimeline& timeline, Envelope::EnvelopeType type, bool isLooping, float silence,
+                                std::uint64_t chunkSize, std::uint64_t& skippedSamples)
+{
+    std::vector<float> output(timeline.lengthSamples);
+    std::uint64_t chunkCount = (timeline.lengthSamples + chunkSize - 1) / chunkSize;
+    skippedSamples = 0;
+
+    for (std::uint64_t chunk = chunkCount; chunk-- > 0;)
+    {
+        Envelope envelope;
+        setup(envelope, type, isLooping, silence);
+
+        std::uint64_t begin = chunk * chunkSize;
+        std::uint64_t end = std::min(begin + chunkSize, timeline.lengthSamples);
+        skippedSamples += renderGateTimelineRange(envelope, timeline, SAMPLE_RATE, begin, end, output.data() + begin);
+    }
+    return output;
+}
+
+int main()
+{
+    // two notes, the second one retriggers mid-release, then a long tail
+    GateTimeline timeline{"test", 300000, {{1000, true}, {30000, false}, {50000, true}, {90000, false}, {200000, true}, {200000, false}}};
+
+    const char* names[] = {"ADSR", "ASR", "AD"};
+
+    for (int type = 0; type < 3; type++)
+    {
+        for (bool isLooping : {false, true})
+        {
+            for (float silence : {-INFINITY, -60.f})
+            {
+                auto envelopeType = static_cast<Envelope::EnvelopeType>(type);
+
+                Envelope envelope;
+                setup(envelope, envelopeType, isLooping, silence);
+                std::vector<float> reference(timeline.lengthSamples);
+                renderGateTimeline(envelope, timeline, SAMPLE_RATE, reference.data());
+
+                bool isOk = true;
+                for (std::uint64_t chunkSize : {1000, 4801, 29999, 50000, 65536, 300000})
+                {
+                    std::uint64_t skippedSamples = 0;
+                    isOk = isOk && reference == renderChunks(timeline, envelopeType, isLooping, silence, chunkSize, skippedSamples);
+                    isOk = isOk && skippedSamples == envelope.getSkippedSampleCount();
+                }
+
+                std::cout << names[type] << (isLooping ? " looping" : "") << (silence > -INFINITY ? " silence" : "") << ": ";
+                expect("chunks match the full render", isOk);
+            }
+        }
+    }
+
+    // ten minutes of a looping AD, where advance() jumps whole cycles
+    {
+        GateTimeline looping{"looping", 600ull * 48000, {{0, true}}};
+
+        Envelope envelope;
+        setup(envelope, Envelope::EnvelopeType::AD, true, -INFINITY);
+        std::vector<float> reference(looping.lengthSamples);
+        renderGateTimeline(envelope, looping, SAMPLE_RATE, reference.data());
+
+        std::uint64_t skippedSamples = 0;
+        std::vector<float> chunks = renderChunks(looping, Envelope::EnvelopeType::AD, true, -INFINITY, 1234567, skippedSamples);
+        expect("ten minutes of looping AD in chunks", reference == chunks);
+    }
+
+    std::cout << (failures == 0 ? "All checks passed." : "Range checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "segment_codec.hpp"
+
+/*
+    Checks the segment codec: encoding a gate timeline and decoding it
+    again gives the rendered samples back (to float rounding, and the
+    SSE2 pow approximation when it's on) for every type, looping or not,
+    with and without a silence threshold. Decoding any range gives the
+    same samples as decoding everything, and a saved file loads back
+    the same.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+const float SAMPLE_RATE = 48000.f;
+
+void setup(Envelope& envelope, Envelope::EnvelopeType type, bool isLooping, float silence)
+{
+    envelope.setTimingMode(Envelope::TimingMode::SAMPLE_COUNT);
+    envelope.setEnvelopeType(type);
+    envelope.setAttackTime(0.0123f);
+    envelope.setAttackCurve(3.f);
+    envelope.setDecayTime(0.0456f);
+    envelope.setDecayCurve(-2.f);
+    envelope.setSustainLevel(0.6f);
+    envelope.setReleaseTime(0.789f);
+    envelope.setReleaseCurve(5.f);
+    envelope.setLooping(isLooping);
+    envelope.setSilenceThreshold(silence);
+}
+
+int main()
+{
+    // two notes, the second one retriggers mid-release, a gate on while active and a long tail
+    GateTimeline timeline{"test", 300000, {{1000, true}, {30000, false}, {50000, true}, {60000, true}, {90000, false}, {200000, true}, {200000, false}}};
+
+    const char* names[] = {"ADSR", "ASR", "AD"};
+    double worstError = 0.0;
+
+    for (int type = 0; type < 3; type++)
+    {
+        for (bool isLooping : {false, true})
+        {
+            for (float silence : {-INFINITY, -60.f})
+            {
+                auto envelopeType = static_cast<Envelope::EnvelopeType>(type);
+
+                Envelope envelope;
+                setup(envelope, envelopeType, isLooping, silence);
+                std::vector<float> reference(timeline.lengthSamples);
+                renderGateTimeline(envelope, timeline, SAMPLE_RATE, reference.data());
+
+                Envelope encoder;
+                setup(encoder, envelopeType, isLooping, silence);
+                EncodedEnvelope encoded;
+                encodeGateTimeline(encoder, timeline, SAMPLE_RATE, encoded);
+
+                std::vector<float> decoded(timeline.lengthSamples);
+                decodeSegments(encoded, 0, decoded.size(), decoded.data());
+
+                double maxError = 0.0;
+                for (std::size_t i = 0; i < decoded.size(); i++)
+                {
+                    maxError = std::max(maxError, static_cast<double>(std::fabs(decoded[i] - reference[i])));
+                }
+                worstError = std::max(worstError, maxError);
+
+                // ranges that start and end inside segments, in odd sizes
+                bool isSameRange = true;
+                std::vector<float> range;
+                for (std::uint64_t begin = 0; begin < timeline.lengthSamples; begin += 7919)
+                {
+                    std::uint64_t count = std::min<std::uint64_t>(begin % 5003 + 1, timeline.lengthSamples - begin);
+                    range.resize(count);
+                    decodeSegments(encoded, begin, count, range.data());
+                    isSameRange = isSameRange && std::equal(range.begin(), range.end(), decoded.begin() + begin);
+                }
+
+                std::cout << names[type] << (isLooping ? " looping" : "") << (silence > -INFINITY ? " silence" : "")
+                          << ": " << encoded.segments.size() << " segments, " << getEncodedSize(encoded) << " bytes, max error "
+                          << maxError << "\n";
+                expect("decodes to the render", maxError < 1e-5 && encoded.lengthSamples == timeline.lengthSamples);
+                expect("ranges decode the same", isSameRange);
+                expect("same skipped sample count", encoder.getSkippedSampleCount() == envelope.getSkippedSampleCount());
+            }
+        }
+    }
+
+    // a file round trip
+    {
+        Envelope envelope;
+        setup(envelope, Envelope::EnvelopeType::ADSR, false, -60.f);
+        EncodedEnvelope encoded;
+        encodeGateTimeline(envelope, timeline, SAMPLE_RATE, encoded);
+
+        EncodedEnvelope loaded;
+        const char* path = "main_test_8.envs";
+        bool isOk = saveEncodedEnvelope(path, encoded) && loadEncodedEnvelope(path, loaded);
+        std::remove(path);
+
+        std::vector<float> a(timeline.lengthSamples);
+        std::vector<float> b(timeline.lengthSamples);
+        decodeSegments(encoded, 0, a.size(), a.data());
+        decodeSegments(loaded, 0, b.size(), b.data());
+
+        expect("saved segments load back the same", isOk && a == b && loaded.segments.size() == encoded.segments.size());
+    }
+
+    std::cout << "worst error " << worstError << "\n";
+    std::cout << (failures == 0 ? "All checks passed." : "Codec checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "cv_bus.hpp"
+#include "voice_pool.hpp"
+
+/*
+    Checks the CV bus: a reader hammering readLatest() while a publisher
+    thread writes frames as fast as it can never sees a torn frame, old
+    frames stop reading once the ring laps them, and a VoicePool publishes
+    its voices after every block. A second publisher can't take over a
+    name in use or remove it, a stale block is replaced, and readers
+    refuse headers whose sizes don't add up.
+*/
+
+static int failures = 0;
+
+void expect(const char* name, bool isOk)
+{
+    std::cout << (isOk ? "ok:   " : "FAIL: ") << name << "\n";
+    failures += isOk ? 0 : 1;
+}
+
+const char* BUS_NAME = "envelope_cv_test";
+
+int main()
+{
+    // every voice of frame n holds n + voice, a torn copy mixes two frames
+    {
+        CvBus bus;
+        CvBusReader reader;
+        bool isOpen = bus.create(BUS_NAME, 64, 8) && reader.open(BUS_NAME);
+        expect("bus opens", isOpen);
+        if (!isOpen)
+        {
+            return 1;
+        }
+
+        const std::uint64_t frameCount = 200000;
+        std::atomic<bool> isDone(false);
+
+        std::thread publisher([&]
+        {
+            for (std::uint64_t frame = 0; frame < frameCount; frame++)
+            {
+                CvVoiceState* states = bus.beginFrame();
+                for (std::uint32_t voice = 0; voice < 64; voice++)
+                {
+                    states[voice] = CvVoiceState{static_cast<float>(frame + voice), 0.5f, voice % 5};
+                }
+                bus.endFrame();
+            }
+            isDone = true;
+        });
+
+        CvSnapshot snapshot;
+        std::uint64_t reads = 0;
+        std::uint64_t torn = 0;
+        std::uint64_t lastFrame = 0;
+        bool isInOrder = true;
+
+        while (!isDone)
+        {
+            if (!reader.readLatest(snapshot))
+            {
+                continue;
+            }
+            reads++;
+
+            for (std::uint32_t voice = 0; voice < snapshot.voiceCount; voice++)
+            {
+                torn += (snapshot.voices[voice].amplitude != static_cast<float>(snapshot.frameNumber + voice)) ? 1 : 0;
+            }
+            isInOrder = isInOrder && snapshot.frameNumber >= lastFrame;
+            lastFrame = snapshot.frameNumber;
+        }
+        publisher.join();
+
+        std::cout << reads << " reads while publishing\n";
+        expect("no torn frames", torn == 0 && reads > 0);
+        expect("frames only move forward", isInOrder);
+
+        expect("newest frame reads", reader.readLatest(snapshot) && snapshot.frameNumber == frameCount - 1);
+        expect("frames still in the ring read", reader.readFrame(frameCount - 8, snapshot) && snapshot.frameNumber == frameCount - 8);
+        expect("frames the ring lapped don't", !reader.readFrame(frameCount - 9, snapshot));
+    }
+
+    // a voice pool publishing its voices
+    {
+        CvBus bus;
+        CvBusReader reader;
+        bool isOpen = bus.create(BUS_NAME, 4) && reader.open(BUS_NAME);
+
+        VoicePool pool(4, 256);
+        pool.setCvBus(&bus);
+
+        Envelope settings;
+        settings.setAttackTime(0.1f);
+        pool.noteOn(settings);
+
+        std::vector<float> mix(256);
+        pool.render(mix.data(), 256, 48000.f);
+
+        CvSnapshot snapshot;
+        bool isOk = isOpen && reader.readLatest(snapshot) && snapshot.voiceCount == 4 &&
+                    snapshot.voices[0].phase == Envelope::ATTACK && snapshot.voices[0].amplitude == mix[255] &&
+                    snapshot.voices[1].phase == Envelope::INACTIVE && reader.getFramesPublished() == 1;
+        expect("voice pool publishes every block", isOk);
+    }
+
+    // one owner per name
+    {
+        CvBus first;
+        CvBus second;
+        CvBusReader reader;
+        bool isFirstOpen = first.create(BUS_NAME, 2);
+        expect("a name in use can't be created again", isFirstOpen && !second.create(BUS_NAME, 2));
+
+        second.close();
+        expect("a failed create doesn't remove the owner's block", reader.open(BUS_NAME));
+
+        first.close();
+        reader.close();
+        expect("the name is free once the owner closes", second.create(BUS_NAME, 2) && reader.open(BUS_NAME));
+    }
+
+#ifndef _WIN32
+    // a block nobody holds, like one a crashed publisher left behind
+    {
+        std::string systemName = std::string("/") + BUS_NAME;
+        int descriptor = shm_open(systemName.c_str(), O_RDWR | O_CREAT, 0644);
+        bool isLeft = descriptor >= 0 && ftruncate(descriptor, 4096) == 0;
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+
+        CvBus bus;
+        CvBusReader reader;
+        expect("a stale block is replaced", isLeft && bus.create(BUS_NAME, 2) && reader.open(BUS_NAME));
+    }
+#endif
+
+    // headers a reader has to refuse
+    {
+        const char magic[8] = {'E', 'N', 'V', 'C', 'V', 'B', 'U', 'S'};
+        const std::uint32_t goodFrameSize = sizeof(CvFrameHeader) + 2 * sizeof(CvVoiceState);
+        const std::uint32_t cases[][2] = {{0, goodFrameSize}, {4, 8}, {4, goodFrameSize - 8}, {4, goodFrameSize + 4}};
+
+        bool isEveryoneRefused = true;
+        for (const std::uint32_t* sizes : cases)
+        {
+            SharedMemory memory;
+            CvBusReader reader;
+            if (!memory.create(BUS_NAME, 4096))
+            {
+                isEveryoneRefused = false;
+                break;
+            }
+
+            CvBusHeader* header = new (memory.getData()) CvBusHeader();
+            std::memcpy(header->magic, magic, sizeof(magic));
+            header->formatVersion = CV_BUS_FORMAT_VERSION;
+            header->voiceCount = 2;
+            header->frameCount = sizes[0];
+            header->frameSize = sizes[1];
+
+            isEveryoneRefused = isEveryoneRefused && !reader.open(BUS_NAME);
+        }
+        expect("bad frame counts and sizes are refused", isEveryoneRefused);
+    }
+
+    std::cout << (failures == 0 ? "All checks passed." : "CV bus checks failed.") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+
+MappedFile::MappedFile()
+: m_data(nullptr)
+, m_size(0)
+, m_isWritable(false)
+#ifdef _WIN32
+, m_fileHandle(INVALID_HANDLE_VALUE)
+, m_mappingHandle(nullptr)
+#else
+, m_fileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+: MappedFile()
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_isWritable, other.m_isWritable);
+#ifdef _WIN32
+        std::swap(m_fileHandle, other.m_fileHandle);
+        std::swap(m_mappingHandle, other.m_mappingHandle);
+#else
+        std::swap(m_fileDescriptor, other.m_fileDescriptor);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::openRead(const std::string& path)
+{
+    close();
+
+    m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        std::cerr << "Cannot map empty file " << path << std::endl;
+        close();
+        return false;
+    }
+    m_size = static_cast<std::size_t>(fileSize.QuadPart);
+
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    m_data = m_mappingHandle ? MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (m_data == nullptr)
+    {
+        std::cerr << "Failed to map " << path << std::endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MappedFile::create(const std::string& path, std::size_t size)
+{
+    close();
+
+    m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                               CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE || size == 0)
+    {
+        std::cerr << "Failed to create " << path << std::endl;
+        close();
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    fileSize.QuadPart = static_cast<LONGLONG>(size);
+
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READWRITE,
+                                         fileSize.HighPart, fileSize.LowPart, nullptr);
+    m_data = m_mappingHandle ? MapViewOfFile(m_mappingHandle, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+    if (m_data == nullptr)
+    {
+        std::cerr << "Failed to map " << path << std::endl;
+        close();
+        return false;
+    }
+
+    m_size = size;
+    m_isWritable = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle != nullptr)
+    {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_fileHandle);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_isWritable = false;
+    m_mappingHandle = nullptr;
+    m_fileHandle = INVALID_HANDLE_VALUE;
+}
+
+bool MappedFile::flush(bool wait)
+{
+    if (m_data == nullptr || !m_isWritable)
+    {
+        return false;
+    }
+    // FlushViewOfFile() only queues the writes, FlushFileBuffers() waits for them
+    return FlushViewOfFile(m_data, 0) && (!wait || FlushFileBuffers(m_fileHandle));
+}
+
+#else
+
+bool MappedFile::openRead(const std::string& path)
+{
+    close();
+
+    m_fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (m_fileDescriptor < 0)
+    {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    struct stat fileInfo;
+    if (fstat(m_fileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0)
+    {
+        std::cerr << "Cannot map empty file " << path << std::endl;
+        close();
+        return false;
+    }
+    m_size = static_cast<std::size_t>(fileInfo.st_size);
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map " << path << std::endl;
+        close();
+        return false;
+    }
+    m_data = data;
+
+    return true;
+}
+
+bool MappedFile::create(const std::string& path, std::size_t size)
+{
+    close();
+
+    m_fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fileDescriptor < 0 || size == 0 ||
+        ftruncate(m_fileDescriptor, static_cast<off_t>(size)) != 0)
+    {
+        std::cerr << "Failed to create " << path << std::endl;
+        close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map " << path << std::endl;
+        close();
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_isWritable = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr)
+    {
+        munmap(m_data, m_size);
+    }
+    if (m_fileDescriptor >= 0)
+    {
+        ::close(m_fileDescriptor);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_isWritable = false;
+    m_fileDescriptor = -1;
+}
+
+bool MappedFile::flush(bool wait)
+{
+    if (m_data == nullptr || !m_isWritable)
+    {
+        return false;
+    }
+    return msync(m_data, m_size, wait ? MS_SYNC : MS_ASYNC) == 0;
+}
+
+#endif // _WIN32
+
+const unsigned char* MappedFile::getData() const
+{
+    return static_cast<const unsigned char*>(m_data);
+}
+unsigned char* MappedFile::getWritableData()
+{
+    return m_isWritable ? static_cast<unsigned char*>(m_data) : nullptr;
+}
+std::size_t MappedFile::getSize() const
+{
+    return m_size;
+}
+
+bool MappedFile::isOpen() const
+{
+    return m_data != nullptr;
+}
+bool MappedFile::isWritable() const
+{
+    return m_isWritable;
+}
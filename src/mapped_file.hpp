@@ -0,0 +1,52 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+/*
+    A file mapped into memory.
+
+    openRead() maps an existing file read-only, create() makes
+    (or truncates) a file of the given size and maps it read-write.
+    The mapping is released by close() or the destructor.
+*/
+
+class MappedFile
+{
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool openRead(const std::string& path);
+        bool create(const std::string& path, std::size_t size);
+        void close();
+
+        bool flush(bool wait = true);   // write dirty pages of a writable mapping back to disk, or only start it
+
+        const unsigned char* getData() const;
+        unsigned char* getWritableData();   // nullptr for read-only mappings
+        std::size_t getSize() const;
+
+        bool isOpen() const;
+        bool isWritable() const;
+
+    private:
+        void* m_data;
+        std::size_t m_size;
+        bool m_isWritable;
+
+#ifdef _WIN32
+        void* m_fileHandle;
+        void* m_mappingHandle;
+#else
+        int m_fileDescriptor;
+#endif
+};
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,558 @@
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "osc_endpoint.hpp"
+#include "trace.hpp"
+
+namespace
+{
+    const std::size_t MAX_PACKET_SIZE = 65536;
+    const int MAX_BUNDLE_DEPTH = 8;
+    const int RECEIVE_TIMEOUT_MS = 100;     // how often the I/O thread looks at m_isRunning
+
+    const char BUNDLE_TAG[8] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', '\0'};
+    const char ADDRESS_PREFIX[] = "/envelope/";
+
+#ifdef _WIN32
+    using SocketHandle = std::uintptr_t;
+    const SocketHandle NO_SOCKET = INVALID_SOCKET;
+
+    // every socket holds a Winsock reference of its own
+    SocketHandle createSocket()
+    {
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+        {
+            return NO_SOCKET;
+        }
+        SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (handle == NO_SOCKET)
+        {
+            WSACleanup();
+        }
+        return handle;
+    }
+    void closeSocket(SocketHandle handle)
+    {
+        closesocket(handle);
+        WSACleanup();
+    }
+    bool setReceiveTimeout(SocketHandle handle, int milliseconds)
+    {
+        DWORD timeout = static_cast<DWORD>(milliseconds);
+        return setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout)) == 0;
+    }
+#else
+    using SocketHandle = int;
+    const SocketHandle NO_SOCKET = -1;
+
+    SocketHandle createSocket()
+    {
+        return socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    }
+    void closeSocket(SocketHandle handle)
+    {
+        ::close(handle);
+    }
+    bool setReceiveTimeout(SocketHandle handle, int milliseconds)
+    {
+        timeval timeout;
+        timeout.tv_sec = milliseconds / 1000;
+        timeout.tv_usec = (milliseconds % 1000) * 1000;
+        return setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0;
+    }
+#endif
+
+    sockaddr_in getLoopbackAddress(unsigned short port)
+    {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        return address;
+    }
+
+    std::int64_t getSteadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // OSC is big-endian throughout
+    std::uint32_t readBigEndian(const unsigned char* data)
+    {
+        return (static_cast<std::uint32_t>(data[0]) << 24) | (static_cast<std::uint32_t>(data[1]) << 16) |
+               (static_cast<std::uint32_t>(data[2]) << 8) | static_cast<std::uint32_t>(data[3]);
+    }
+    void writeBigEndian(unsigned char* data, std::uint32_t value)
+    {
+        data[0] = static_cast<unsigned char>(value >> 24);
+        data[1] = static_cast<unsigned char>(value >> 16);
+        data[2] = static_cast<unsigned char>(value >> 8);
+        data[3] = static_cast<unsigned char>(value);
+    }
+
+    // a null terminated string padded to 4 bytes, position moves past the padding
+    bool readString(const unsigned char* data, std::size_t size, std::size_t& position, const char*& text)
+    {
+        const void* terminator = std::memchr(data + position, 0, size - position);
+        if (terminator == nullptr)
+        {
+            return false;
+        }
+
+        text = reinterpret_cast<const char*>(data + position);
+        position = (static_cast<const unsigned char*>(terminator) - data + 4) & ~static_cast<std::size_t>(3);
+        return position <= size;
+    }
+
+    bool parseMessage(const unsigned char* data, std::size_t size, std::int64_t arrivalTime,
+                      std::vector<ControlMessage>& messages, std::size_t& ignored)
+    {
+        std::size_t position = 0;
+        const char* address = nullptr;
+        const char* typeTags = ",";
+
+        if (!readString(data, size, position, address))
+        {
+            return false;
+        }
+        // very old senders leave the type tags out, that's a message without arguments
+        if (position < size && (!readString(data, size, position, typeTags) || typeTags[0] != ','))
+        {
+            return false;
+        }
+
+        // only the first argument is used
+        bool hasValue = true;
+        float value = 0.0f;
+        std::uint32_t bits = 0;
+
+        switch (typeTags[1])
+        {
+            case 'i':
+            case 'f':
+                if (position + 4 > size)
+                {
+                    return false;
+                }
+                bits = readBigEndian(data + position);
+                if (typeTags[1] == 'i')
+                {
+                    value = static_cast<float>(static_cast<std::int32_t>(bits));
+                }
+                else
+                {
+                    std::memcpy(&value, &bits, sizeof(value));
+                }
+                break;
+            case 'T':
+                value = 1.0f;
+                break;
+            case 'F':
+                value = 0.0f;
+                break;
+            default:
+                hasValue = false;
+                break;
+        }
+        hasValue = hasValue && std::isfinite(value);
+
+        if (std::strncmp(address, ADDRESS_PREFIX, sizeof(ADDRESS_PREFIX) - 1) != 0)
+        {
+            ignored++;
+            return true;
+        }
+        const char* name = address + sizeof(ADDRESS_PREFIX) - 1;
+
+        ControlMessage message = {ControlMessage::GATE_ON, AutomationParameter::COUNT, value, arrivalTime};
+        bool isKnown = true;
+
+        if (std::strcmp(name, "trigger") == 0)
+        {
+            message.type = ControlMessage::GATE_ON;
+        }
+        else if (std::strcmp(name, "release") == 0)
+        {
+            message.type = ControlMessage::GATE_OFF;
+        }
+        else if (std::strcmp(name, "reset") == 0)
+        {
+            message.type = ControlMessage::RESET;
+        }
+        else if (std::strcmp(name, "gate") == 0 && hasValue)
+        {
+            message.type = value != 0.0f ? ControlMessage::GATE_ON : ControlMessage::GATE_OFF;
+        }
+        else if (std::strcmp(name, "type") == 0 && hasValue)
+        {
+            message.type = ControlMessage::ENVELOPE_TYPE;
+        }
+        else if (std::strcmp(name, "loop") == 0 && hasValue)
+        {
+            message.type = ControlMessage::LOOPING;
+        }
+        else if (hasValue && findAutomationParameter(name, message.parameter))
+        {
+            message.type = ControlMessage::PARAMETER;
+        }
+        else
+        {
+            isKnown = false;
+        }
+
+        if (isKnown)
+        {
+            messages.push_back(message);
+        }
+        else
+        {
+            ignored++;
+        }
+        return true;
+    }
+
+    bool parseElement(const unsigned char* data, std::size_t size, int depth, std::int64_t arrivalTime,
+                      std::vector<ControlMessage>& messages, std::size_t& ignored)
+    {
+        if (size >= sizeof(BUNDLE_TAG) && std::memcmp(data, BUNDLE_TAG, sizeof(BUNDLE_TAG)) == 0)
+        {
+            // tag, 8 byte timetag, then size prefixed elements
+            if (depth >= MAX_BUNDLE_DEPTH || size < 16)
+            {
+                return false;
+            }
+
+            std::size_t position = 16;
+            while (position < size)
+            {
+                if (position + 4 > size)
+                {
+                    return false;
+                }
+                std::uint32_t elementSize = readBigEndian(data + position);
+                position += 4;
+
+                if (elementSize % 4 != 0 || elementSize > size - position ||
+                    !parseElement(data + position, elementSize, depth + 1, arrivalTime, messages, ignored))
+                {
+                    return false;
+                }
+                position += elementSize;
+            }
+            return true;
+        }
+
+        if (size == 0 || size % 4 != 0 || data[0] != '/')
+        {
+            return false;
+        }
+        return parseMessage(data, size, arrivalTime, messages, ignored);
+    }
+}
+
+bool parseOscPacket(const unsigned char* data, std::size_t size, std::int64_t arrivalTime,
+                    std::vector<ControlMessage>& messages, std::size_t& ignored)
+{
+    // a packet is taken whole or not at all
+    std::size_t firstMessage = messages.size();
+    std::size_t ignoredBefore = ignored;
+
+    if (!parseElement(data, size, 0, arrivalTime, messages, ignored))
+    {
+        messages.resize(firstMessage);
+        ignored = ignoredBefore;
+        return false;
+    }
+    return true;
+}
+
+// writer
+
+void OscWriter::beginBundle()
+{
+    beginElement();
+    m_data.insert(m_data.end(), BUNDLE_TAG, BUNDLE_TAG + sizeof(BUNDLE_TAG));
+    writeInt(0);
+    writeInt(1);
+    m_bundleDepth++;
+}
+
+void OscWriter::endBundle()
+{
+    if (m_bundleDepth == 0)
+    {
+        return;
+    }
+    m_bundleDepth--;
+    endElement();
+}
+
+void OscWriter::addMessage(const char* address)
+{
+    beginElement();
+    writeString(address);
+    writeString(",");
+    endElement();
+}
+
+void OscWriter::addMessage(const char* address, float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    beginElement();
+    writeString(address);
+    writeString(",f");
+    writeInt(bits);
+    endElement();
+}
+
+void OscWriter::addMessage(const char* address, std::int32_t value)
+{
+    beginElement();
+    writeString(address);
+    writeString(",i");
+    writeInt(static_cast<std::uint32_t>(value));
+    endElement();
+}
+
+const unsigned char* OscWriter::getData() const
+{
+    return m_data.data();
+}
+std::size_t OscWriter::getSize() const
+{
+    return m_data.size();
+}
+
+void OscWriter::clear()
+{
+    m_data.clear();
+    m_elementStarts.clear();
+    m_bundleDepth = 0;
+}
+
+void OscWriter::beginElement()
+{
+    // inside a bundle every element is prefixed with its size, filled in by endElement()
+    if (m_bundleDepth > 0)
+    {
+        m_elementStarts.push_back(m_data.size());
+        writeInt(0);
+    }
+}
+
+void OscWriter::endElement()
+{
+    if (m_bundleDepth > 0)
+    {
+        std::size_t start = m_elementStarts.back();
+        m_elementStarts.pop_back();
+        writeBigEndian(m_data.data() + start, static_cast<std::uint32_t>(m_data.size() - start - 4));
+    }
+}
+
+void OscWriter::writeString(const char* text)
+{
+    std::size_t length = std::strlen(text);
+    m_data.insert(m_data.end(), text, text + length);
+    m_data.resize(m_data.size() + 4 - length % 4, 0);
+}
+
+void OscWriter::writeInt(std::uint32_t value)
+{
+    m_data.resize(m_data.size() + 4);
+    writeBigEndian(m_data.data() + m_data.size() - 4, value);
+}
+
+// endpoint
+
+OscEndpoint::OscEndpoint()
+: m_socket(NO_SOCKET)
+, m_port(0)
+, m_isRunning(false)
+, m_packets(0)
+, m_messages(0)
+, m_malformedPackets(0)
+, m_ignoredMessages(0)
+, m_droppedPackets(0)
+{
+}
+
+OscEndpoint::~OscEndpoint()
+{
+    close();
+}
+
+bool OscEndpoint::open(unsigned short port)
+{
+    close();
+
+    m_socket = createSocket();
+    if (m_socket == NO_SOCKET)
+    {
+        std::cerr << "Failed to create a UDP socket" << std::endl;
+        return false;
+    }
+
+    sockaddr_in address = getLoopbackAddress(port);
+    socklen_t addressSize = sizeof(address);
+
+    if (bind(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        getsockname(m_socket, reinterpret_cast<sockaddr*>(&address), &addressSize) != 0 ||
+        !setReceiveTimeout(m_socket, RECEIVE_TIMEOUT_MS))
+    {
+        std::cerr << "Failed to listen for OSC on port " << port << std::endl;
+        closeSocket(m_socket);
+        m_socket = NO_SOCKET;
+        return false;
+    }
+
+    m_port = ntohs(address.sin_port);
+    m_isRunning = true;
+    m_thread = std::thread(&OscEndpoint::receiveLoop, this);
+    return true;
+}
+
+void OscEndpoint::close()
+{
+    // the thread notices within one receive timeout
+    if (m_thread.joinable())
+    {
+        m_isRunning = false;
+        m_thread.join();
+    }
+    if (m_socket != NO_SOCKET)
+    {
+        closeSocket(m_socket);
+        m_socket = NO_SOCKET;
+    }
+    m_port = 0;
+}
+
+bool OscEndpoint::isOpen() const
+{
+    return m_socket != NO_SOCKET;
+}
+
+unsigned short OscEndpoint::getPort() const
+{
+    return m_port;
+}
+
+bool OscEndpoint::pop(ControlMessage& message)
+{
+    return m_queue.pop(message);
+}
+
+OscEndpoint::Stats OscEndpoint::getStats() const
+{
+    return {m_packets.load(), m_messages.load(), m_malformedPackets.load(), m_ignoredMessages.load(), m_droppedPackets.load()};
+}
+
+void OscEndpoint::receiveLoop()
+{
+    TRACE_THREAD_NAME("osc");
+
+    // everything this thread needs is allocated up front
+    std::vector<unsigned char> buffer(MAX_PACKET_SIZE);
+    std::vector<ControlMessage> messages;
+    messages.reserve(QUEUE_SIZE);
+
+    while (m_isRunning.load(std::memory_order_relaxed))
+    {
+        int received = static_cast<int>(recv(m_socket, reinterpret_cast<char*>(buffer.data()), static_cast<int>(buffer.size()), 0));
+        if (received < 0)
+        {
+            continue;   // timed out
+        }
+
+        std::int64_t arrivalTime = getSteadyNanoseconds();
+        TRACE_SCOPE("OSC packet");
+        m_packets.fetch_add(1, std::memory_order_relaxed);
+
+        messages.clear();
+        std::size_t ignored = 0;
+        if (!parseOscPacket(buffer.data(), static_cast<std::size_t>(received), arrivalTime, messages, ignored))
+        {
+            m_malformedPackets.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        m_ignoredMessages.fetch_add(ignored, std::memory_order_relaxed);
+
+        if (messages.empty())
+        {
+            continue;
+        }
+        // counted before they're queued, so a message the app has popped is in the stats already
+        m_messages.fetch_add(messages.size(), std::memory_order_relaxed);
+        if (!m_queue.push(messages.data(), messages.size()))
+        {
+            m_messages.fetch_sub(messages.size(), std::memory_order_relaxed);
+            m_droppedPackets.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// sender
+
+OscSender::OscSender()
+: m_socket(NO_SOCKET)
+{
+}
+
+OscSender::~OscSender()
+{
+    close();
+}
+
+bool OscSender::open(unsigned short port)
+{
+    close();
+
+    m_socket = createSocket();
+    sockaddr_in address = getLoopbackAddress(port);
+
+    if (m_socket == NO_SOCKET || connect(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        std::cerr << "Failed to open a UDP socket to port " << port << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void OscSender::close()
+{
+    if (m_socket != NO_SOCKET)
+    {
+        closeSocket(m_socket);
+        m_socket = NO_SOCKET;
+    }
+}
+
+bool OscSender::send(const OscWriter& packet)
+{
+    return send(packet.getData(), packet.getSize());
+}
+
+bool OscSender::send(const unsigned char* data, std::size_t size)
+{
+    return m_socket != NO_SOCKET &&
+           ::send(m_socket, reinterpret_cast<const char*>(data), static_cast<int>(size), 0) == static_cast<int>(size);
+}
@@ -0,0 +1,165 @@
+#ifndef OSC_ENDPOINT_HPP
+#define OSC_ENDPOINT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "automation.hpp"
+#include "spsc_queue.hpp"
+
+/*
+    Envelope control from other programs on the same machine, as OSC
+    messages over UDP on the loopback interface.
+
+    Addresses (arguments are int32 or float32, T and F for flags):
+
+        /envelope/trigger               gate on
+        /envelope/release               gate off
+        /envelope/gate <on>             nonzero on, zero off
+        /envelope/reset
+        /envelope/type <0|1|2>          Envelope::EnvelopeType
+        /envelope/loop <on>
+        /envelope/<parameter> <value>   attackTime, attackCurve, decayTime,
+                                        decayCurve, sustainLevel, releaseTime,
+                                        releaseCurve (the automation names)
+
+    OSC bundles batch updates: everything in one packet, nested bundles
+    included, reaches the envelope thread in one piece. Timetags are
+    ignored, a bundle applies as soon as it arrives.
+
+    OscEndpoint reads the socket on its own thread and parses packets
+    there. Messages go to the envelope thread through a lock-free single
+    producer, single consumer queue, which pop() drains without locking
+    or allocating. Every message carries the time its packet came off the
+    socket, so the consumer can measure the latency to the first sample
+    it affects.
+*/
+
+struct ControlMessage
+{
+    enum Type : std::uint8_t
+    {
+        GATE_ON,
+        GATE_OFF,
+        RESET,
+        ENVELOPE_TYPE,
+        LOOPING,
+        PARAMETER
+    };
+
+    Type type;
+    AutomationParameter parameter;      // PARAMETER only
+    float value;
+    std::int64_t arrivalTime;           // steady_clock nanoseconds
+};
+
+// false for a malformed packet, ignored counts messages with an unknown address or arguments
+bool parseOscPacket(const unsigned char* data, std::size_t size, std::int64_t arrivalTime,
+                    std::vector<ControlMessage>& messages, std::size_t& ignored);
+
+// builds OSC packets, for senders and tests
+class OscWriter
+{
+    public:
+        void beginBundle();     // timetag "immediately"
+        void endBundle();
+
+        void addMessage(const char* address);
+        void addMessage(const char* address, float value);
+        void addMessage(const char* address, std::int32_t value);
+
+        const unsigned char* getData() const;
+        std::size_t getSize() const;
+        void clear();
+
+    private:
+        void beginElement();
+        void endElement();
+        void writeString(const char* text);
+        void writeInt(std::uint32_t value);
+
+        std::vector<unsigned char> m_data;
+        std::vector<std::size_t> m_elementStarts;   // size fields of open bundle elements
+        std::size_t m_bundleDepth = 0;
+};
+
+class OscEndpoint
+{
+    public:
+        static constexpr std::size_t QUEUE_SIZE = 1024;
+        static constexpr unsigned short DEFAULT_PORT = 9000;
+
+        struct Stats
+        {
+            std::uint64_t packets;
+            std::uint64_t messages;
+            std::uint64_t malformedPackets;
+            std::uint64_t ignoredMessages;
+            std::uint64_t droppedPackets;   // queue full
+        };
+
+        OscEndpoint();
+        ~OscEndpoint();
+
+        OscEndpoint(const OscEndpoint&) = delete;
+        OscEndpoint& operator=(const OscEndpoint&) = delete;
+
+        bool open(unsigned short port);     // 127.0.0.1 only, port 0 picks a free one
+        void close();
+        bool isOpen() const;
+        unsigned short getPort() const;
+
+        // the envelope thread
+        bool pop(ControlMessage& message);
+
+        Stats getStats() const;
+
+    private:
+        void receiveLoop();
+
+#ifdef _WIN32
+        std::uintptr_t m_socket;
+#else
+        int m_socket;
+#endif
+        unsigned short m_port;
+
+        std::thread m_thread;
+        std::atomic<bool> m_isRunning;
+        SpscQueue<ControlMessage, QUEUE_SIZE> m_queue;
+
+        std::atomic<std::uint64_t> m_packets;
+        std::atomic<std::uint64_t> m_messages;
+        std::atomic<std::uint64_t> m_malformedPackets;
+        std::atomic<std::uint64_t> m_ignoredMessages;
+        std::atomic<std::uint64_t> m_droppedPackets;
+};
+
+// sends packets to an endpoint on this machine
+class OscSender
+{
+    public:
+        OscSender();
+        ~OscSender();
+
+        OscSender(const OscSender&) = delete;
+        OscSender& operator=(const OscSender&) = delete;
+
+        bool open(unsigned short port);
+        void close();
+
+        bool send(const OscWriter& packet);
+        bool send(const unsigned char* data, std::size_t size);
+
+    private:
+#ifdef _WIN32
+        std::uintptr_t m_socket;
+#else
+        int m_socket;
+#endif
+};
+
+#endif // OSC_ENDPOINT_HPP
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "hash.hpp"
+#include "preset.hpp"
+
+namespace
+{
+    const char LIBRARY_MAGIC[8] = {'E', 'N', 'V', 'P', 'R', 'L', 'I', 'B'};
+
+    struct LibraryHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t recordSize;
+        std::uint64_t recordCount;
+        std::uint64_t indexOffset;
+    };
+
+    static_assert(sizeof(LibraryHeader) == 32, "LibraryHeader layout is part of the file format");
+
+    std::uint64_t hashName(const char* name, std::size_t maxLength)
+    {
+        return fnv1a64(name, strnlen(name, maxLength));
+    }
+}
+
+// preset record
+
+void PresetRecord::setName(const std::string& presetName)
+{
+    std::memset(name, 0, sizeof(name));
+    std::memcpy(name, presetName.data(), std::min(presetName.size(), sizeof(name) - 1));
+}
+std::string PresetRecord::getName() const
+{
+    return std::string(name, strnlen(name, sizeof(name)));
+}
+
+bool PresetRecord::isValid() const
+{
+    return version >= 1 && version <= PRESET_RECORD_VERSION &&
+           envelopeType <= static_cast<std::uint8_t>(Envelope::EnvelopeType::AD);
+}
+
+bool PresetRecord::applyTo(Envelope& envelope) const
+{
+    if (!isValid())
+    {
+        return false;
+    }
+
+    envelope.setEnvelopeType(static_cast<Envelope::EnvelopeType>(envelopeType));
+    envelope.setAttackTime(attackTime);
+    envelope.setAttackCurve(attackCurve);
+    envelope.setDecayTime(decayTime);
+    envelope.setDecayCurve(decayCurve);
+    envelope.setSustainLevel(sustainLevel);
+    envelope.setReleaseTime(releaseTime);
+    envelope.setReleaseCurve(releaseCurve);
+    envelope.setLooping((flags & LOOPING) != 0);
+    return true;
+}
+
+// preset library
+
+PresetLibrary::PresetLibrary()
+: m_records(nullptr)
+, m_index(nullptr)
+, m_presetCount(0)
+{
+}
+
+bool PresetLibrary::write(const std::string& path, const std::vector<PresetRecord>& presets)
+{
+    LibraryHeader header;
+    std::memcpy(header.magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+    header.version = PRESET_LIBRARY_VERSION;
+    header.recordSize = sizeof(PresetRecord);
+    header.recordCount = presets.size();
+    header.indexOffset = sizeof(LibraryHeader) + presets.size() * sizeof(PresetRecord);
+
+    std::vector<IndexEntry> index(presets.size());
+    for (std::size_t i = 0; i < presets.size(); i++)
+    {
+        index[i].nameHash = hashName(presets[i].name, sizeof(presets[i].name));
+        index[i].recordIndex = i;
+    }
+    std::sort(index.begin(), index.end(), [](const IndexEntry& a, const IndexEntry& b)
+    {
+        return a.nameHash < b.nameHash || (a.nameHash == b.nameHash && a.recordIndex < b.recordIndex);
+    });
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Failed to write preset library " << path << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(presets.data()), presets.size() * sizeof(PresetRecord));
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(IndexEntry));
+
+    return static_cast<bool>(file);
+}
+
+bool PresetLibrary::open(const std::string& path)
+{
+    close();
+
+    if (!m_file.openRead(path))
+    {
+        return false;
+    }
+
+    // only the header is read, so opening doesn't depend on the library size
+    LibraryHeader header;
+    if (m_file.getSize() < sizeof(header))
+    {
+        std::cerr << path << " is not a preset library" << std::endl;
+        close();
+        return false;
+    }
+    std::memcpy(&header, m_file.getData(), sizeof(header));
+
+    if (std::memcmp(header.magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC)) != 0 ||
+        header.recordSize != sizeof(PresetRecord))
+    {
+        std::cerr << path << " is not a preset library" << std::endl;
+        close();
+        return false;
+    }
+    if (header.version > PRESET_LIBRARY_VERSION)
+    {
+        std::cerr << path << " was written by a newer version (" << header.version << ")" << std::endl;
+        close();
+        return false;
+    }
+
+    // more records than the file could hold would overflow the sizes below
+    std::uint64_t maxRecords = (m_file.getSize() - sizeof(LibraryHeader)) / (sizeof(PresetRecord) + sizeof(IndexEntry));
+    std::uint64_t recordBytes = header.recordCount * sizeof(PresetRecord);
+    std::uint64_t indexBytes = header.recordCount * sizeof(IndexEntry);
+
+    if (header.recordCount > maxRecords ||
+        header.indexOffset != sizeof(LibraryHeader) + recordBytes ||
+        header.indexOffset + indexBytes > m_file.getSize())
+    {
+        std::cerr << path << " is truncated" << std::endl;
+        close();
+        return false;
+    }
+
+    m_records = reinterpret_cast<const PresetRecord*>(m_file.getData() + sizeof(LibraryHeader));
+    m_index = reinterpret_cast<const IndexEntry*>(m_file.getData() + header.indexOffset);
+    m_presetCount = static_cast<std::size_t>(header.recordCount);
+
+    return true;
+}
+
+void PresetLibrary::close()
+{
+    m_file.close();
+    m_records = nullptr;
+    m_index = nullptr;
+    m_presetCount = 0;
+}
+
+bool PresetLibrary::isOpen() const
+{
+    return m_file.isOpen();
+}
+std::size_t PresetLibrary::getPresetCount() const
+{
+    return m_presetCount;
+}
+const PresetRecord& PresetLibrary::getPreset(std::size_t index) const
+{
+    return m_records[index];
+}
+
+const PresetRecord* PresetLibrary::findPreset(const std::string& name) const
+{
+    std::uint64_t nameHash = fnv1a64(name.substr(0, sizeof(PresetRecord::name) - 1));
+
+    const IndexEntry* first = std::lower_bound(m_index, m_index + m_presetCount, nameHash,
+        [](const IndexEntry& entry, std::uint64_t hash) { return entry.nameHash < hash; });
+
+    // names that share a hash sit next to each other
+    for (const IndexEntry* entry = first; entry != m_index + m_presetCount && entry->nameHash == nameHash; entry++)
+    {
+        if (entry->recordIndex >= m_presetCount)
+        {
+            continue;   // a damaged index, the records themselves were checked
+        }
+
+        const PresetRecord& preset = m_records[entry->recordIndex];
+        if (name.compare(0, sizeof(preset.name) - 1, preset.name, strnlen(preset.name, sizeof(preset.name))) == 0)
+        {
+            return &preset;
+        }
+    }
+    return nullptr;
+}
+
+const PresetRecord* PresetLibrary::begin() const
+{
+    return m_records;
+}
+const PresetRecord* PresetLibrary::end() const
+{
+    return m_records + m_presetCount;
+}
@@ -0,0 +1,97 @@
+#ifndef PRESET_HPP
+#define PRESET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envelope_generator.hpp"
+#include "mapped_file.hpp"
+
+/*
+    Binary envelope presets.
+
+    A preset is a fixed size 64 byte record. A library file is a header,
+    the records back to back, then an index of name hashes sorted for
+    binary search. Libraries are memory mapped, so opening one only
+    checks the header and records are read straight from the mapping.
+
+    Records and headers are stored in native layout, which is little-endian
+    on every host this builds for; big-endian hosts are refused at compile
+    time rather than reading byte-swapped values.
+*/
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Preset files are little-endian, big-endian hosts aren't supported"
+#endif
+
+constexpr std::uint16_t PRESET_RECORD_VERSION = 1;
+constexpr std::uint32_t PRESET_LIBRARY_VERSION = 1;
+
+struct PresetRecord
+{
+    enum Flags : std::uint8_t
+    {
+        LOOPING = 1 << 0
+    };
+
+    std::uint16_t version;          // PRESET_RECORD_VERSION it was written with
+    std::uint8_t envelopeType;      // Envelope::EnvelopeType
+    std::uint8_t flags;
+
+    float attackTime;
+    float attackCurve;              // curves are the setter/knob values (-10 to 10)
+    float decayTime;
+    float decayCurve;
+    float sustainLevel;
+    float releaseTime;
+    float releaseCurve;
+
+    char name[32];                  // null terminated, unused bytes are zero
+
+    void setName(const std::string& presetName);
+    std::string getName() const;
+
+    bool isValid() const;      // a version and envelope type this build knows
+
+    // false for an invalid record, the envelope is left alone then
+    bool applyTo(Envelope& envelope) const;
+};
+
+static_assert(sizeof(PresetRecord) == 64, "PresetRecord layout is part of the file format");
+
+class PresetLibrary
+{
+    public:
+        PresetLibrary();
+
+        static bool write(const std::string& path, const std::vector<PresetRecord>& presets);
+
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const;
+        std::size_t getPresetCount() const;
+        const PresetRecord& getPreset(std::size_t index) const;
+        const PresetRecord* findPreset(const std::string& name) const;  // nullptr if missing
+
+        // records live in the mapping, iterate without copying
+        const PresetRecord* begin() const;
+        const PresetRecord* end() const;
+
+    private:
+        struct IndexEntry
+        {
+            std::uint64_t nameHash;
+            std::uint64_t recordIndex;
+        };
+
+        MappedFile m_file;
+
+        const PresetRecord* m_records;
+        const IndexEntry* m_index;
+        std::size_t m_presetCount;
+};
+
+#endif // PRESET_HPP
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "hash.hpp"
+#include "render_cache.hpp"
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    const char CACHE_MAGIC[8] = {'E', 'N', 'V', 'C', 'A', 'C', 'H', 'E'};
+    const std::uint32_t CACHE_FORMAT_VERSION = 1;
+    const char* CACHE_EXTENSION = ".envc";
+
+    struct CacheHeader
+    {
+        char magic[8];
+        std::uint32_t formatVersion;
+        std::uint32_t engineVersion;
+        std::uint64_t key;
+        std::uint64_t sampleCount;
+    };
+
+    static_assert(sizeof(CacheHeader) == 32, "CacheHeader layout is part of the file format");
+
+    template <typename T>
+    std::uint64_t hashValue(const T& value, std::uint64_t hash)
+    {
+        return fnv1a64(&value, sizeof(value), hash);
+    }
+}
+
+// cached render
+
+const float* CachedRender::getSamples() const
+{
+    return m_samples;
+}
+std::uint64_t CachedRender::getSampleCount() const
+{
+    return m_sampleCount;
+}
+
+// render cache
+
+RenderCache::RenderCache(const std::string& directory, std::uint64_t maxBytes)
+: m_directory(directory)
+, m_maxBytes(maxBytes)
+, m_sizeBytes(0)
+, m_hits(0)
+, m_misses(0)
+{
+    std::error_code error;
+    fs::create_directories(m_directory, error);
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(m_directory, error))
+    {
+        if (entry.path().extension() == CACHE_EXTENSION)
+        {
+            m_sizeBytes += entry.file_size(error);
+        }
+    }
+
+    if (error)
+    {
+        std::cerr << "Render cache " << m_directory << ": " << error.message() << std::endl;
+    }
+}
+
+std::uint64_t RenderCache::makeKey(const Envelope& envelope, const GateTimeline& timeline,
+                                   const std::vector<AutomationLane>& automation, float sampleRate)
+{
+    // every input that changes the rendered samples, field by field so
+    // struct padding never ends up in the key
+    std::uint64_t hash = hashValue(ENVELOPE_ENGINE_VERSION, FNV_OFFSET_BASIS);
+
+    // table curves render slightly different samples, keep them apart from pow() ones
+#ifdef ENVELOPE_CURVE_TABLES
+    hash = hashValue(true, hash);
+#else
+    hash = hashValue(false, hash);
+#endif
+
+    hash = hashValue(static_cast<int>(envelope.getEnvelopeType()), hash);
+    hash = hashValue(envelope.getAttackTime(), hash);
+    hash = hashValue(envelope.getAttackCurve(), hash);
+    hash = hashValue(envelope.getDecayTime(), hash);
+    hash = hashValue(envelope.getDecayCurve(), hash);
+    hash = hashValue(envelope.getSustainLevel(), hash);
+    hash = hashValue(envelope.getReleaseTime(), hash);
+    hash = hashValue(envelope.getReleaseCurve(), hash);
+    hash = hashValue(envelope.isLooping(), hash);
+    hash = hashValue(envelope.getSilenceThreshold(), hash);
+    hash = hashValue(static_cast<int>(envelope.getTimingMode()), hash);
+
+    hash = hashValue(sampleRate, hash);
+    hash = hashValue(timeline.lengthSamples, hash);
+    for (const GateEvent& event : timeline.events)
+    {
+        hash = hashValue(event.sample, hash);
+        hash = hashValue(event.isOn, hash);
+    }
+    hash = hashAutomation(automation, hash);
+
+    return hash;
+}
+
+bool RenderCache::lookup(std::uint64_t key, CachedRender& render)
+{
+    std::string path = getPath(key);
+
+    std::error_code error;
+    if (!fs::exists(path, error) || !render.m_file.openRead(path))
+    {
+        m_misses++;
+        return false;
+    }
+
+    CacheHeader header;
+    bool isValid = render.m_file.getSize() >= sizeof(header);
+
+    if (isValid)
+    {
+        std::memcpy(&header, render.m_file.getData(), sizeof(header));
+
+        isValid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                  header.formatVersion == CACHE_FORMAT_VERSION &&
+                  header.engineVersion == ENVELOPE_ENGINE_VERSION &&
+                  header.key == key &&
+                  render.m_file.getSize() == sizeof(header) + header.sampleCount * sizeof(float);
+    }
+
+    if (!isValid)
+    {
+        render.m_file.close();
+        m_misses++;
+        return false;
+    }
+
+    render.m_samples = reinterpret_cast<const float*>(render.m_file.getData() + sizeof(header));
+    render.m_sampleCount = header.sampleCount;
+
+    // the modification time doubles as the last use for eviction
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+
+    m_hits++;
+    return true;
+}
+
+bool RenderCache::store(std::uint64_t key, const float* samples, std::uint64_t sampleCount)
+{
+    std::string path = getPath(key);
+
+    // write next to the final name, then rename so readers never see a partial file
+    std::ostringstream tempPath;
+    tempPath << path << "." << std::this_thread::get_id() << ".tmp";
+
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.formatVersion = CACHE_FORMAT_VERSION;
+    header.engineVersion = ENVELOPE_ENGINE_VERSION;
+    header.key = key;
+    header.sampleCount = sampleCount;
+
+    {
+        std::ofstream file(tempPath.str(), std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(samples), static_cast<std::streamsize>(sampleCount * sizeof(float)));
+
+        if (!file)
+        {
+            std::cerr << "Failed to write render cache entry " << tempPath.str() << std::endl;
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::error_code error;
+    std::uint64_t replacedBytes = fs::exists(path, error) ? fs::file_size(path, error) : 0;
+
+    fs::rename(tempPath.str(), path, error);
+    if (error)
+    {
+        std::cerr << "Failed to store render cache entry " << path << ": " << error.message() << std::endl;
+        fs::remove(tempPath.str(), error);
+        return false;
+    }
+
+    m_sizeBytes += sizeof(header) + sampleCount * sizeof(float);
+    m_sizeBytes -= std::min(m_sizeBytes, replacedBytes);
+
+    if (m_sizeBytes > m_maxBytes)
+    {
+        evict();
+    }
+    return true;
+}
+
+void RenderCache::evict()
+{
+    struct Entry
+    {
+        fs::path path;
+        fs::file_time_type lastUse;
+        std::uint64_t size;
+    };
+
+    std::error_code error;
+    std::vector<Entry> entries;
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(m_directory, error))
+    {
+        if (entry.path().extension() == CACHE_EXTENSION)
+        {
+            entries.push_back({entry.path(), entry.last_write_time(error), entry.file_size(error)});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+
+    // recount while we're here, other processes may share the directory
+    m_sizeBytes = 0;
+    for (const Entry& entry : entries)
+    {
+        m_sizeBytes += entry.size;
+    }
+
+    // least recently used first, files still mapped elsewhere stay readable on POSIX
+    // and fail to delete on Windows, either way they're simply skipped
+    for (const Entry& entry : entries)
+    {
+        if (m_sizeBytes <= m_maxBytes)
+        {
+            break;
+        }
+        if (fs::remove(entry.path, error))
+        {
+            m_sizeBytes -= entry.size;
+        }
+    }
+}
+
+std::string RenderCache::getPath(std::uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+    return (fs::path(m_directory) / (std::string(name) + CACHE_EXTENSION)).string();
+}
+
+std::uint64_t RenderCache::getHitCount() const
+{
+    return m_hits;
+}
+std::uint64_t RenderCache::getMissCount() const
+{
+    return m_misses;
+}
+std::uint64_t RenderCache::getSizeBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sizeBytes;
+}
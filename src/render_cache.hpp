@@ -0,0 +1,70 @@
+#ifndef RENDER_CACHE_HPP
+#define RENDER_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "automation.hpp"
+#include "envelope_generator.hpp"
+#include "gate_timeline.hpp"
+#include "mapped_file.hpp"
+
+/*
+    On-disk cache of rendered gate timelines.
+
+    Renders are keyed by a stable hash of the envelope parameters, the
+    timeline, any automation, the sample rate and ENVELOPE_ENGINE_VERSION, and stored one
+    file per key. A hit maps the file and hands out its samples in place.
+
+    The directory is kept under a byte budget by deleting the least
+    recently used files. Lookups and stores are safe from several threads.
+*/
+
+// a cache hit, the samples stay valid while this object lives
+class CachedRender
+{
+    public:
+        const float* getSamples() const;
+        std::uint64_t getSampleCount() const;
+
+    private:
+        friend class RenderCache;
+
+        MappedFile m_file;
+        const float* m_samples = nullptr;
+        std::uint64_t m_sampleCount = 0;
+};
+
+class RenderCache
+{
+    public:
+        RenderCache(const std::string& directory, std::uint64_t maxBytes);
+
+        static std::uint64_t makeKey(const Envelope& envelope, const GateTimeline& timeline,
+                                     const std::vector<AutomationLane>& automation, float sampleRate);
+
+        bool lookup(std::uint64_t key, CachedRender& render);
+        bool store(std::uint64_t key, const float* samples, std::uint64_t sampleCount);
+
+        std::uint64_t getHitCount() const;
+        std::uint64_t getMissCount() const;
+        std::uint64_t getSizeBytes() const;
+
+    private:
+        std::string getPath(std::uint64_t key) const;
+        void evict();   // call with m_mutex held
+
+        std::string m_directory;
+        std::uint64_t m_maxBytes;
+
+        mutable std::mutex m_mutex;
+        std::uint64_t m_sizeBytes;
+
+        std::atomic<std::uint64_t> m_hits;
+        std::atomic<std::uint64_t> m_misses;
+};
+
+#endif // RENDER_CACHE_HPP
@@ -0,0 +1,53 @@
+#ifndef RENDER_STATS_HPP
+#define RENDER_STATS_HPP
+
+#include <cstddef>
+
+/*
+    Per-frame rendering counters for the HUD (hud_overlay.hpp): draw calls
+    made through drawCounted(), and vertices regenerated on the CPU.
+
+    UI thread only. AppManager clears them at the start of every frame.
+*/
+
+class RenderStats
+{
+    public:
+        static void countDrawCall()
+        {
+            s_drawCalls++;
+        }
+        static void countRebuiltVertices(std::size_t count)
+        {
+            s_rebuiltVertices += count;
+        }
+
+        static std::size_t getDrawCalls()
+        {
+            return s_drawCalls;
+        }
+        static std::size_t getRebuiltVertices()
+        {
+            return s_rebuiltVertices;
+        }
+
+        static void reset()
+        {
+            s_drawCalls = 0;
+            s_rebuiltVertices = 0;
+        }
+
+    private:
+        static inline std::size_t s_drawCalls = 0;
+        static inline std::size_t s_rebuiltVertices = 0;
+};
+
+// target.draw() that counts itself
+template <typename Target, typename Drawable>
+void drawCounted(Target& target, const Drawable& drawable)
+{
+    target.draw(drawable);
+    RenderStats::countDrawCall();
+}
+
+#endif // RENDER_STATS_HPP
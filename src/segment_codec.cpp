@@ -0,0 +1,404 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "segment_codec.hpp"
+#include "simd.hpp"
+
+#ifdef ENVELOPE_CURVE_TABLES
+#include "curve_table.hpp"
+#endif
+
+namespace
+{
+    const char SEGMENTS_MAGIC[8] = {'E', 'N', 'V', 'S', 'E', 'G', 'M', 'T'};
+    const std::uint32_t SEGMENTS_FORMAT_VERSION = 1;
+
+    struct SegmentsHeader
+    {
+        char magic[8];
+        std::uint32_t formatVersion;
+        float sampleRate;
+        std::uint64_t lengthSamples;
+        std::uint64_t segmentCount;
+    };
+
+    static_assert(sizeof(SegmentsHeader) == 32, "SegmentsHeader layout is part of the file format");
+
+    const std::uint64_t SEGMENT_RECORD_SIZE = 25;
+
+    template <typename T>
+    bool readValue(std::istream& in, T& value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+
+    template <typename T>
+    void writeValue(std::ostream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // a segment as offset + scale * pow(base + direction * t, curve), like Envelope::renderSegment()
+    struct Shape
+    {
+        float offset;
+        float scale;
+        float base;
+        float direction;
+        float curve;
+    };
+
+    Shape getShape(const EncodedSegment& segment)
+    {
+        if (segment.phase == Envelope::RELEASE)
+        {
+            return Shape{segment.endLevel, segment.startLevel - segment.endLevel, 1.0f, -1.0f, segment.curve};
+        }
+        return Shape{segment.startLevel, segment.endLevel - segment.startLevel, 0.0f, 1.0f, segment.curve};
+    }
+
+#if defined(ENVELOPE_SSE2) && !defined(ENVELOPE_CURVE_TABLES)
+    // log2(x) for positive normal x: exponent plus ln(mantissa) as 2 * atanh((m - 1) / (m + 1))
+    __m128 log2Approx(__m128 x)
+    {
+        __m128i bits = _mm_castps_si128(x);
+        __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+        __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                                        _mm_set1_epi32(0x3F800000)));
+
+        // mantissa into [sqrt(0.5), sqrt(2)) keeps the series short
+        __m128 isLarge = _mm_cmpgt_ps(mantissa, _mm_set1_ps(1.41421356f));
+        mantissa = _mm_or_ps(_mm_and_ps(isLarge, _mm_mul_ps(mantissa, _mm_set1_ps(0.5f))), _mm_andnot_ps(isLarge, mantissa));
+        exponent = _mm_add_ps(exponent, _mm_and_ps(isLarge, _mm_set1_ps(1.0f)));
+
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 s = _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one));
+        __m128 s2 = _mm_mul_ps(s, s);
+
+        __m128 series = _mm_set1_ps(1.0f / 9.0f);
+        series = _mm_add_ps(_mm_mul_ps(series, s2), _mm_set1_ps(1.0f / 7.0f));
+        series = _mm_add_ps(_mm_mul_ps(series, s2), _mm_set1_ps(1.0f / 5.0f));
+        series = _mm_add_ps(_mm_mul_ps(series, s2), _mm_set1_ps(1.0f / 3.0f));
+        series = _mm_add_ps(_mm_mul_ps(series, s2), one);
+
+        // 2 * s * series is ln(mantissa), times log2(e)
+        return _mm_add_ps(exponent, _mm_mul_ps(_mm_mul_ps(s, series), _mm_set1_ps(2.0f * 1.44269504f)));
+    }
+
+    // 2^y as 2^round(y) * e^(f * ln 2), f in [-0.5, 0.5]
+    __m128 exp2Approx(__m128 y)
+    {
+        y = _mm_max_ps(_mm_min_ps(y, _mm_set1_ps(126.0f)), _mm_set1_ps(-126.0f));
+
+        __m128i whole = _mm_cvtps_epi32(y);
+        __m128 u = _mm_mul_ps(_mm_sub_ps(y, _mm_cvtepi32_ps(whole)), _mm_set1_ps(0.693147181f));
+
+        __m128 series = _mm_set1_ps(1.0f / 720.0f);
+        series = _mm_add_ps(_mm_mul_ps(series, u), _mm_set1_ps(1.0f / 120.0f));
+        series = _mm_add_ps(_mm_mul_ps(series, u), _mm_set1_ps(1.0f / 24.0f));
+        series = _mm_add_ps(_mm_mul_ps(series, u), _mm_set1_ps(1.0f / 6.0f));
+        series = _mm_add_ps(_mm_mul_ps(series, u), _mm_set1_ps(0.5f));
+        series = _mm_add_ps(_mm_mul_ps(series, u), _mm_set1_ps(1.0f));
+        series = _mm_add_ps(_mm_mul_ps(series, u), _mm_set1_ps(1.0f));
+
+        __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+        return _mm_mul_ps(series, scale);
+    }
+
+    // four samples from index on, every lane on its own so any grouping gives the same values
+    __m128 decodeFour(const Shape& shape, std::uint64_t index, double inverseLength)
+    {
+        __m128d low = _mm_set_pd(static_cast<double>(index + 2), static_cast<double>(index + 1));
+        __m128d high = _mm_set_pd(static_cast<double>(index + 4), static_cast<double>(index + 3));
+        __m128d inverse = _mm_set1_pd(inverseLength);
+        __m128d one = _mm_set1_pd(1.0);
+
+        low = _mm_min_pd(_mm_mul_pd(low, inverse), one);
+        high = _mm_min_pd(_mm_mul_pd(high, inverse), one);
+        __m128 t = _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+
+        __m128 x = _mm_add_ps(_mm_set1_ps(shape.base), _mm_mul_ps(_mm_set1_ps(shape.direction), t));
+        __m128 curved = exp2Approx(_mm_mul_ps(log2Approx(x), _mm_set1_ps(shape.curve)));
+
+        // pow(0, curve) is 0, and 1 stays exactly 1 through the approximation
+        curved = _mm_and_ps(curved, _mm_cmpgt_ps(x, _mm_setzero_ps()));
+
+        return _mm_add_ps(_mm_set1_ps(shape.offset), _mm_mul_ps(_mm_set1_ps(shape.scale), curved));
+    }
+#endif
+
+    // count samples of segment from local sample first on
+    void decodeSegment(const EncodedSegment& segment, float deltaTime, std::uint64_t first, std::uint64_t count, float* output)
+    {
+        if (segment.duration <= 0.0f)
+        {
+            std::fill(output, output + count, segment.endLevel);
+            return;
+        }
+
+        // the same normalized time as Envelope::renderSegment() with TimingMode::SAMPLE_COUNT
+        Shape shape = getShape(segment);
+        double inverseLength = deltaTime / static_cast<double>(segment.duration);
+        auto normalizedTime = [&](std::uint64_t i)
+        {
+            return static_cast<float>(std::min(static_cast<double>(first + i + 1) * inverseLength, 1.0));
+        };
+
+#ifdef ENVELOPE_CURVE_TABLES
+        // the renderer's tables, linear curves included, or decoding wouldn't give its samples back
+        int curve = findCurveTable(shape.curve);
+        for (std::uint64_t i = 0; i < count; i++)
+        {
+            output[i] = shape.offset + shape.scale * lookupCurve(curve, shape.base + shape.direction * normalizedTime(i));
+        }
+#else
+        if (shape.curve == 1.0f)
+        {
+            for (std::uint64_t i = 0; i < count; i++)
+            {
+                output[i] = shape.offset + shape.scale * (shape.base + shape.direction * normalizedTime(i));
+            }
+            return;
+        }
+
+#ifdef ENVELOPE_SSE2
+        std::uint64_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(output + i, decodeFour(shape, first + i, inverseLength));
+        }
+        if (i < count)
+        {
+            float tail[4];
+            _mm_storeu_ps(tail, decodeFour(shape, first + i, inverseLength));
+            std::copy(tail, tail + (count - i), output + i);
+        }
+#else
+        for (std::uint64_t i = 0; i < count; i++)
+        {
+            output[i] = shape.offset + shape.scale * std::pow(shape.base + shape.direction * normalizedTime(i), shape.curve);
+        }
+#endif
+#endif
+    }
+}
+
+SegmentEncoder::SegmentEncoder(Envelope& envelope, float sampleRate, EncodedEnvelope& output)
+: m_envelope(envelope)
+, m_output(output)
+{
+    m_output.sampleRate = sampleRate;
+    m_envelope.setTimingMode(Envelope::TimingMode::SAMPLE_COUNT);     // what the decoder reproduces
+}
+
+void SegmentEncoder::encode(std::uint64_t numSamples)
+{
+    /*
+        The walk renderBlock() does: a run per segment, or what's left of it,
+        then Envelope::advance() over it to keep the state exactly in step.
+    */
+    Envelope& envelope = m_envelope;
+    float deltaTime = 1.0f / m_output.sampleRate;
+
+    while (numSamples > 0)
+    {
+        std::uint64_t start = m_output.lengthSamples;
+        std::uint8_t phase = static_cast<std::uint8_t>(envelope.m_currentPhase);
+
+        if (envelope.m_currentPhase == Envelope::SUSTAIN || envelope.m_currentPhase == Envelope::INACTIVE)
+        {
+            float level = (envelope.m_currentPhase == Envelope::SUSTAIN) ? envelope.m_sustainLevel : 0.0f;
+            append(EncodedSegment{start, numSamples, 0.0f, level, level, 1.0f, phase});
+
+            envelope.advance(numSamples, m_output.sampleRate);
+            m_output.lengthSamples += numSamples;
+            return;
+        }
+
+        Envelope::Segment segment = envelope.getSegment();
+        double samplesLeft = envelope.getSamplesLeft(segment, deltaTime);
+        std::uint64_t runLength = static_cast<std::uint64_t>(std::min(samplesLeft, static_cast<double>(numSamples)));
+
+        float fromLevel = segment.isFalling ? segment.offset + segment.scale : segment.offset;
+        float toLevel = segment.isFalling ? segment.offset : segment.offset + segment.scale;
+
+        // a segment going on from the last encode() call is already written down
+        if (envelope.m_elapsedSamples > 0 && !m_output.segments.empty())
+        {
+            m_output.segments.back().length += runLength;
+        }
+        else
+        {
+            append(EncodedSegment{start, runLength, segment.duration, fromLevel, toLevel, segment.curve, phase});
+        }
+
+        envelope.advance(runLength, m_output.sampleRate);
+        m_output.lengthSamples += runLength;
+        numSamples -= runLength;
+
+        // renderBlock() writes the last sample of a finished envelope as 0, a silenced tail would end above it
+        if (runLength == samplesLeft && envelope.m_currentPhase == Envelope::INACTIVE)
+        {
+            EncodedSegment& last = m_output.segments.back();
+            if (--last.length == 0)
+            {
+                m_output.segments.pop_back();
+            }
+            append(EncodedSegment{m_output.lengthSamples - 1, 1, 0.0f, 0.0f, 0.0f, 1.0f, Envelope::INACTIVE});
+        }
+    }
+}
+
+void SegmentEncoder::append(const EncodedSegment& segment)
+{
+    if (!m_output.segments.empty())
+    {
+        EncodedSegment& last = m_output.segments.back();
+        bool isSameConstant = last.duration <= 0.0f && segment.duration <= 0.0f &&
+                              last.phase == segment.phase && last.endLevel == segment.endLevel;
+
+        if (isSameConstant && last.start + last.length == segment.start)
+        {
+            last.length += segment.length;
+            return;
+        }
+    }
+    m_output.segments.push_back(segment);
+}
+
+void encodeGateTimeline(Envelope& envelope, const GateTimeline& timeline, float sampleRate, EncodedEnvelope& encoded)
+{
+    envelope.reset();
+    encoded = EncodedEnvelope();
+
+    SegmentEncoder encoder(envelope, sampleRate, encoded);
+    std::uint64_t position = 0;
+
+    // the same edges as renderGateTimeline()
+    for (const GateEvent& event : timeline.events)
+    {
+        std::uint64_t eventSample = std::min(event.sample, timeline.lengthSamples);
+
+        encoder.encode(eventSample - position);
+        position = eventSample;
+
+        applyGateEdge(envelope, event.isOn);
+    }
+
+    encoder.encode(timeline.lengthSamples - position);
+}
+
+void decodeSegments(const EncodedEnvelope& encoded, std::uint64_t begin, std::uint64_t count, float* output)
+{
+    float deltaTime = 1.0f / encoded.sampleRate;
+    std::uint64_t end = begin + count;
+
+    // the last segment starting at or before begin
+    auto segment = std::upper_bound(encoded.segments.begin(), encoded.segments.end(), begin,
+        [](std::uint64_t sample, const EncodedSegment& s) { return sample < s.start; });
+    if (segment != encoded.segments.begin())
+    {
+        --segment;
+    }
+
+    std::uint64_t position = begin;
+
+    for (; segment != encoded.segments.end() && position < end; ++segment)
+    {
+        std::uint64_t segmentEnd = std::min(segment->start + segment->length, end);
+        if (segmentEnd <= position)
+        {
+            continue;
+        }
+        decodeSegment(*segment, deltaTime, position - segment->start, segmentEnd - position, output + (position - begin));
+        position = segmentEnd;
+    }
+
+    // past the encoded length
+    std::fill(output + (position - begin), output + count, 0.0f);
+}
+
+bool saveEncodedEnvelope(const std::string& path, const EncodedEnvelope& encoded)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    SegmentsHeader header;
+    std::memcpy(header.magic, SEGMENTS_MAGIC, sizeof(SEGMENTS_MAGIC));
+    header.formatVersion = SEGMENTS_FORMAT_VERSION;
+    header.sampleRate = encoded.sampleRate;
+    header.lengthSamples = encoded.lengthSamples;
+    header.segmentCount = encoded.segments.size();
+    writeValue(file, header);
+
+    // field by field, the start is the sum of the lengths before it
+    for (const EncodedSegment& segment : encoded.segments)
+    {
+        writeValue(file, segment.length);
+        writeValue(file, segment.duration);
+        writeValue(file, segment.startLevel);
+        writeValue(file, segment.endLevel);
+        writeValue(file, segment.curve);
+        writeValue(file, segment.phase);
+    }
+
+    if (!file)
+    {
+        std::cerr << "Failed to write segments " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadEncodedEnvelope(const std::string& path, EncodedEnvelope& encoded)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open segments " << path << std::endl;
+        return false;
+    }
+
+    SegmentsHeader header;
+    if (!readValue(file, header) || std::memcmp(header.magic, SEGMENTS_MAGIC, sizeof(SEGMENTS_MAGIC)) != 0 ||
+        header.formatVersion != SEGMENTS_FORMAT_VERSION)
+    {
+        std::cerr << path << ": not an encoded envelope" << std::endl;
+        return false;
+    }
+
+    encoded = EncodedEnvelope();
+    encoded.sampleRate = header.sampleRate;
+
+    for (std::uint64_t i = 0; i < header.segmentCount; i++)
+    {
+        EncodedSegment segment;
+        segment.start = encoded.lengthSamples;
+
+        if (!readValue(file, segment.length) || !readValue(file, segment.duration) || !readValue(file, segment.startLevel) ||
+            !readValue(file, segment.endLevel) || !readValue(file, segment.curve) || !readValue(file, segment.phase))
+        {
+            std::cerr << path << ": truncated after " << i << " segments" << std::endl;
+            encoded = EncodedEnvelope();
+            return false;
+        }
+
+        encoded.lengthSamples += segment.length;
+        encoded.segments.push_back(segment);
+    }
+
+    if (encoded.lengthSamples != header.lengthSamples)
+    {
+        std::cerr << path << ": segments don't add up to the length" << std::endl;
+        encoded = EncodedEnvelope();
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t getEncodedSize(const EncodedEnvelope& encoded)
+{
+    return sizeof(SegmentsHeader) + encoded.segments.size() * SEGMENT_RECORD_SIZE;
+}
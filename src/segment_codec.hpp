@@ -0,0 +1,79 @@
+#ifndef SEGMENT_CODEC_HPP
+#define SEGMENT_CODEC_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envelope_generator.hpp"
+#include "gate_timeline.hpp"
+
+/*
+    Envelope output as the segments it is made of instead of samples.
+
+    Between gate edges an envelope is a handful of analytic curves, so a
+    render is stored as one record per segment: where it starts, how many
+    samples it covers, the phase, the levels it runs between and the curve
+    exponent. A minute long note is a few records instead of megabytes.
+
+    SegmentEncoder drives an Envelope the way renderGateTimeline() does,
+    with Envelope::advance(), and writes down the segments it goes through.
+    It uses TimingMode::SAMPLE_COUNT, so a sample only depends on its
+    position in the segment and the decoder can start anywhere.
+
+    decodeSegments() turns any range back into samples. Constant and
+    linear segments are filled directly, curves go through pow(), four
+    samples at a time with SSE2 (ENVELOPE_SSE2, simd.hpp) using a log2/exp2
+    approximation good to about 1e-7. With ENVELOPE_CURVE_TABLES every curve
+    goes through the same tables as the renderer instead.
+
+    Files (saveEncodedEnvelope()) are a header, then per segment its length
+    (uint64), duration, start level, end level, curve (float32) and phase
+    (uint8), 25 bytes. Envelopes with automation aren't piecewise, they
+    can't be encoded.
+*/
+
+struct EncodedSegment
+{
+    std::uint64_t start;        // first sample
+    std::uint64_t length;       // samples covered, less than the duration when cut short
+    float duration;             // seconds the full curve takes, 0 = constant at endLevel
+    float startLevel;           // where the curve starts and ends, even if length cuts it short
+    float endLevel;
+    float curve;                // exponent, 1 = linear
+    std::uint8_t phase;         // Envelope::Phase, RELEASE curves are shaped from the end
+};
+
+struct EncodedEnvelope
+{
+    float sampleRate = 48000.f;
+    std::uint64_t lengthSamples = 0;
+    std::vector<EncodedSegment> segments;   // back to back, sorted by start
+};
+
+class SegmentEncoder
+{
+    public:
+        // appends to output, which has to be empty or encoded at the same sample rate
+        SegmentEncoder(Envelope& envelope, float sampleRate, EncodedEnvelope& output);
+
+        void encode(std::uint64_t numSamples);  // like renderBlock(), the envelope moves on
+
+    private:
+        void append(const EncodedSegment& segment);     // extends the last segment where it continues
+
+        Envelope& m_envelope;
+        EncodedEnvelope& m_output;
+};
+
+// renderGateTimeline() as segments, replaces encoded
+void encodeGateTimeline(Envelope& envelope, const GateTimeline& timeline, float sampleRate, EncodedEnvelope& encoded);
+
+// samples [begin, begin + count) of the render, output holds count samples
+void decodeSegments(const EncodedEnvelope& encoded, std::uint64_t begin, std::uint64_t count, float* output);
+
+bool saveEncodedEnvelope(const std::string& path, const EncodedEnvelope& encoded);
+bool loadEncodedEnvelope(const std::string& path, EncodedEnvelope& encoded);
+std::uint64_t getEncodedSize(const EncodedEnvelope& encoded);  // bytes saveEncodedEnvelope() writes
+
+#endif // SEGMENT_CODEC_HPP
@@ -0,0 +1,15 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+/*
+    Defines ENVELOPE_SSE2 when the hot loops may use SSE2 intrinsics:
+    ENVELOPE_USE_SIMD is set (the CMake option) and the target has SSE2.
+    Every use keeps a plain loop for the other case.
+*/
+
+#if defined(ENVELOPE_USE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ENVELOPE_SSE2
+#include <emmintrin.h>
+#endif
+
+#endif // SIMD_HPP
@@ -1,11 +1,14 @@
 
 
 #include <iostream>
-#include <sstream>
+#include <cstdio>
 #include <cmath>
+#include <limits>
 
 #include "theme.hpp"
 #include "slider.hpp"
+#include "render_stats.hpp"
+#include "trace.hpp"
 
 // for envelope generator
 Slider::Slider(float minValue, float maxValue, const std::string& title)
@@ -15,6 +18,7 @@ Slider::Slider(float minValue, float maxValue, const std::string& title)
 , m_minValue(minValue)
 , m_maxValue(maxValue)
 , m_value(minValue)
+, m_displayedValue(std::numeric_limits<float>::quiet_NaN())
 , m_dragging(false)
 , m_step(0.01f)
 , m_isHorizontal(true)
@@ -65,6 +69,7 @@ Slider::Slider(float x, float y, float width, float height, float minValue, floa
 , m_minValue(minValue)
 , m_maxValue(maxValue)
 , m_value(minValue)
+, m_displayedValue(std::numeric_limits<float>::quiet_NaN())
 , m_dragging(false)
 , m_step(0.01f)
 , m_isHorizontal(isHorizontal)
@@ -129,6 +134,8 @@ Slider::Slider(float x, float y, float width, float height, float minValue, floa
 
 void Slider::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
 {
+    TRACE_SCOPE("Slider::handleEvent");
+
     if (m_isDisabled)
     {
         m_titleText.setFillColor(m_disabledColor);
@@ -300,10 +307,15 @@ void Slider::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
 
 void Slider::updateValueText()
 {
-    // format as string
-    std::stringstream ss_current;
-    ss_current << m_value;
-    m_valueText.setString(ss_current.str());
+    // only rebuild the string when the value changed,
+    // handleEvent() calls this for every event
+    if (m_value != m_displayedValue)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%g", m_value);
+        m_valueText.setString(buffer);
+        m_displayedValue = m_value;
+    }
 
     // current value positioning
     sf::FloatRect text_bounds = m_valueText.getLocalBounds();
@@ -348,13 +360,15 @@ void Slider::updateTitleText()
     }
 
 }
-void Slider::draw(sf::RenderWindow& window)
+void Slider::draw(sf::RenderTarget& target)
 {
-    window.draw(m_background);
-    window.draw(m_handle);
+    TRACE_SCOPE("Slider::draw");
 
-    window.draw(m_titleText);
-    window.draw(m_valueText);
+    drawCounted(target, m_background);
+    drawCounted(target, m_handle);
+
+    drawCounted(target, m_titleText);
+    drawCounted(target, m_valueText);
 }
 
 // setters
@@ -463,4 +477,4 @@ bool Slider::isDragging() const
 bool Slider::isDisabled() const
 {
     return m_isDisabled;
-}
\ No newline at end of file
+}
@@ -13,7 +13,7 @@ class Slider
         Slider(float x, float y, float width, float height, float minValue, float maxValue, bool isHorizontal, const std::string& title);
         
         void handleEvent(const sf::Event& event, const sf::RenderWindow& window);
-        void draw(sf::RenderWindow& window);
+        void draw(sf::RenderTarget& target);
 
         void setPosition(sf::Vector2f startPoint, sf::Vector2f endPoint);
         void setValue(float value);
@@ -33,6 +33,7 @@ class Slider
         float m_minValue;          // min value of slider
         float m_maxValue;          // max value of slider
         float m_value;              // value setting of slider
+        float m_displayedValue;     // value currently shown by m_valueText
         float m_step;               // for setting precision of slider
         float m_padding;            // distance between elements, taken from theme
 
@@ -0,0 +1,74 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+/*
+    Fixed capacity lock-free queue for exactly one producer thread and
+    one consumer thread. Neither side ever blocks or allocates: push()
+    fails when the queue is full, pop() when it's empty.
+
+    push(items, count) publishes all of them at once or none, so the
+    consumer never sees half of a batch.
+
+    CAPACITY has to be a power of two, one slot is never used.
+*/
+
+template <typename T, std::size_t CAPACITY>
+class SpscQueue
+{
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    public:
+        SpscQueue() : m_head(0), m_tail(0) {}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // producer
+        bool push(const T& item)
+        {
+            return push(&item, 1);
+        }
+        bool push(const T* items, std::size_t count)
+        {
+            std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            std::size_t head = m_head.load(std::memory_order_acquire);
+            if (count > CAPACITY - 1 - ((tail - head) & MASK))
+            {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                m_items[(tail + i) & MASK] = items[i];
+            }
+            m_tail.store((tail + count) & MASK, std::memory_order_release);
+            return true;
+        }
+
+        // consumer
+        bool pop(T& item)
+        {
+            std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            item = m_items[head];
+            m_head.store((head + 1) & MASK, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        static constexpr std::size_t MASK = CAPACITY - 1;
+
+        // each index on its own cache line, the two threads don't share one
+        alignas(64) std::atomic<std::size_t> m_head;
+        alignas(64) std::atomic<std::size_t> m_tail;
+        alignas(64) T m_items[CAPACITY];
+};
+
+#endif // SPSC_QUEUE_HPP
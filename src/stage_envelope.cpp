@@ -0,0 +1,458 @@
+#include <algorithm>
+#include <cmath>
+
+#include "curve_table.hpp"
+#include "stage_envelope.hpp"
+
+namespace
+{
+    /*
+        The arithmetic the render loop needs, per sample type. The float
+        version is exactly what Envelope::renderBlock() does, the others
+        follow it as closely as their type allows.
+    */
+    template <typename Sample>
+    struct SampleMath;
+
+    template <>
+    struct SampleMath<float>
+    {
+        using Time = float;
+        using Inverse = float;
+
+        static float fromFloat(float value)
+        {
+            return value;
+        }
+        static float getDeltaTime(float sampleRate)
+        {
+            return 1.0f / sampleRate;
+        }
+        static float getEndTime(float seconds, float)
+        {
+            return seconds;
+        }
+        static float getInverse(float seconds, float)
+        {
+            return (seconds > 0.0f) ? 1.0f / seconds : INFINITY;
+        }
+        static float advance(float start, int count, float deltaTime)
+        {
+            return start + count * deltaTime;
+        }
+        static double getSamplesUntil(float end, float elapsed, float deltaTime)
+        {
+            return std::ceil((end - elapsed) / deltaTime);
+        }
+        static float normalize(float elapsed, float inverse)
+        {
+            return std::min(elapsed * inverse, 1.0f);
+        }
+        static int findCurve(float exponent)
+        {
+#ifdef ENVELOPE_CURVE_TABLES
+            return findCurveTable(exponent);
+#else
+            (void)exponent;
+            return 0;
+#endif
+        }
+        static float shape(float x, float exponent, int curve)
+        {
+#ifdef ENVELOPE_CURVE_TABLES
+            (void)exponent;
+            return lookupCurve(curve, x);
+#else
+            (void)curve;
+            return std::pow(x, exponent);
+#endif
+        }
+    };
+
+    template <>
+    struct SampleMath<double>
+    {
+        using Time = double;
+        using Inverse = double;
+
+        static double fromFloat(float value)
+        {
+            return value;
+        }
+        static double getDeltaTime(float sampleRate)
+        {
+            return 1.0 / sampleRate;
+        }
+        static double getEndTime(float seconds, float)
+        {
+            return seconds;
+        }
+        static double getInverse(float seconds, float)
+        {
+            return (seconds > 0.0f) ? 1.0 / seconds : INFINITY;
+        }
+        static double advance(double start, int count, double deltaTime)
+        {
+            return start + count * deltaTime;
+        }
+        static double getSamplesUntil(double end, double elapsed, double deltaTime)
+        {
+            return std::ceil((end - elapsed) / deltaTime);
+        }
+        static double normalize(double elapsed, double inverse)
+        {
+            return std::min(elapsed * inverse, 1.0);
+        }
+        static int findCurve(float)
+        {
+            return 0;
+        }
+        static double shape(double x, float exponent, int)
+        {
+            return std::pow(x, static_cast<double>(exponent));
+        }
+    };
+
+    /*
+        Q11.20 can't hold one sample's worth of seconds precisely enough,
+        22 steps at 48 kHz is 0.7% off, so fixed point counts samples
+        instead. Stage lengths and 1 / length are worked out once per run,
+        the loop itself is all integer.
+    */
+    template <>
+    struct SampleMath<EnvelopeFixed>
+    {
+        static constexpr int FRACTION_BITS = 20;
+
+        using Time = std::int64_t;
+        using Inverse = std::int64_t;      // 1 / samples with FRACTION_BITS more bits
+
+        static EnvelopeFixed fromFloat(float value)
+        {
+            return EnvelopeFixed::fromDouble(value);
+        }
+        static std::int64_t getDeltaTime(float)
+        {
+            return 1;
+        }
+        static std::int64_t getEndTime(float seconds, float sampleRate)
+        {
+            return static_cast<std::int64_t>(std::ceil(static_cast<double>(seconds) * sampleRate));
+        }
+        static std::int64_t getInverse(float seconds, float sampleRate)
+        {
+            double samples = std::max(static_cast<double>(seconds) * sampleRate, 1.0);
+            return static_cast<std::int64_t>(static_cast<double>(std::int64_t(1) << (2 * FRACTION_BITS)) / samples);
+        }
+        static std::int64_t advance(std::int64_t start, int count, std::int64_t)
+        {
+            return start + count;
+        }
+        static double getSamplesUntil(std::int64_t end, std::int64_t elapsed, std::int64_t)
+        {
+            return static_cast<double>(end - elapsed);
+        }
+        static EnvelopeFixed normalize(std::int64_t elapsed, std::int64_t inverse)
+        {
+            // elapsed never gets much past the stage length, so this stays inside 64 bits
+            std::int64_t normalized = (elapsed * inverse) >> FRACTION_BITS;
+            return EnvelopeFixed::fromRaw(static_cast<std::int32_t>(std::min<std::int64_t>(normalized, EnvelopeFixed::ONE)));
+        }
+        static int findCurve(float exponent)
+        {
+            return findCurveTable(exponent);
+        }
+        static EnvelopeFixed shape(EnvelopeFixed x, float, int curve)
+        {
+            return EnvelopeFixed::fromRaw(lookupCurveFixed<FRACTION_BITS>(curve, x.raw()));
+        }
+    };
+}
+
+template <typename Sample>
+BasicStageEnvelope<Sample>::BasicStageEnvelope()
+: m_stageCount(0)
+, m_releaseStage(-1)
+, m_loopStage(0)
+, m_isLooping(false)
+, m_currentStage(-1)
+, m_isSustaining(false)
+, m_level(SampleMath<Sample>::fromFloat(0.0f))
+, m_elapsedTime(0)
+, m_offset(SampleMath<Sample>::fromFloat(0.0f))
+, m_scale(SampleMath<Sample>::fromFloat(0.0f))
+, m_base(SampleMath<Sample>::fromFloat(0.0f))
+, m_direction(SampleMath<Sample>::fromFloat(1.0f))
+{
+    setADSR(1.0f, 1.0f, 1.0f, 1.0f, 0.8f, 1.0f, 1.0f);    // same defaults as Envelope
+}
+
+template <typename Sample>
+bool BasicStageEnvelope<Sample>::setStages(const EnvelopeStage* stages, int count)
+{
+    if (count < 1 || count > MAX_STAGES)
+    {
+        return false;
+    }
+
+    std::copy(stages, stages + count, m_stages);
+    m_stageCount = count;
+    m_releaseStage = -1;
+    m_loopStage = 0;
+
+    for (int i = count - 1; i >= 0; i--)
+    {
+        if (m_stages[i].flags & EnvelopeStage::RELEASE)
+        {
+            m_releaseStage = i;
+        }
+        if (m_stages[i].flags & EnvelopeStage::LOOP_START)
+        {
+            m_loopStage = i;
+        }
+    }
+
+    reset();
+    return true;
+}
+template <typename Sample>
+void BasicStageEnvelope<Sample>::setLooping(bool isLooping)
+{
+    m_isLooping = isLooping;
+}
+
+// presets
+
+template <typename Sample>
+void BasicStageEnvelope<Sample>::setADSR(float attackTime, float attackCurve, float decayTime, float decayCurve,
+                                         float sustainLevel, float releaseTime, float releaseCurve)
+{
+    const EnvelopeStage stages[] = {
+        {1.0f,         attackTime,  attackCurve,  0},
+        {sustainLevel, decayTime,   decayCurve,   EnvelopeStage::SUSTAIN},
+        {0.0f,         releaseTime, releaseCurve, EnvelopeStage::RELEASE | EnvelopeStage::FALLING}
+    };
+    setStages(stages, 3);
+}
+template <typename Sample>
+void BasicStageEnvelope<Sample>::setASR(float attackTime, float attackCurve, float sustainLevel,
+                                        float releaseTime, float releaseCurve)
+{
+    const EnvelopeStage stages[] = {
+        {sustainLevel, attackTime,  attackCurve,  EnvelopeStage::SUSTAIN},
+        {0.0f,         releaseTime, releaseCurve, EnvelopeStage::RELEASE | EnvelopeStage::FALLING}
+    };
+    setStages(stages, 2);
+}
+template <typename Sample>
+void BasicStageEnvelope<Sample>::setAD(float attackTime, float attackCurve, float decayTime, float decayCurve)
+{
+    // no release stage, an AD plays out whatever the gate does
+    const EnvelopeStage stages[] = {
+        {1.0f, attackTime, attackCurve, 0},
+        {0.0f, decayTime,  decayCurve,  0}
+    };
+    setStages(stages, 2);
+}
+template <typename Sample>
+void BasicStageEnvelope<Sample>::setDAHDSR(float delayTime, float attackTime, float attackCurve, float holdTime,
+                                           float decayTime, float decayCurve, float sustainLevel,
+                                           float releaseTime, float releaseCurve)
+{
+    const EnvelopeStage stages[] = {
+        {0.0f,         delayTime,   1.0f,         0},
+        {1.0f,         attackTime,  attackCurve,  0},
+        {1.0f,         holdTime,    1.0f,         0},
+        {sustainLevel, decayTime,   decayCurve,   EnvelopeStage::SUSTAIN},
+        {0.0f,         releaseTime, releaseCurve, EnvelopeStage::RELEASE | EnvelopeStage::FALLING}
+    };
+    setStages(stages, 5);
+}
+template <typename Sample>
+void BasicStageEnvelope<Sample>::setFromEnvelope(const Envelope& envelope)
+{
+    switch (envelope.getEnvelopeType())
+    {
+        case Envelope::EnvelopeType::ADSR:
+            setADSR(envelope.getAttackTime(), envelope.getAttackCurve(), envelope.getDecayTime(), envelope.getDecayCurve(),
+                    envelope.getSustainLevel(), envelope.getReleaseTime(), envelope.getReleaseCurve());
+            break;
+        case Envelope::EnvelopeType::ASR:
+            setASR(envelope.getAttackTime(), envelope.getAttackCurve(), envelope.getSustainLevel(),
+                   envelope.getReleaseTime(), envelope.getReleaseCurve());
+            break;
+        case Envelope::EnvelopeType::AD:
+            setAD(envelope.getAttackTime(), envelope.getAttackCurve(), envelope.getDecayTime(), envelope.getDecayCurve());
+            break;
+    }
+    setLooping(envelope.isLooping());
+}
+
+// getters
+
+template <typename Sample>
+int BasicStageEnvelope<Sample>::getStageCount() const
+{
+    return m_stageCount;
+}
+template <typename Sample>
+const EnvelopeStage& BasicStageEnvelope<Sample>::getStage(int index) const
+{
+    return m_stages[index];
+}
+template <typename Sample>
+int BasicStageEnvelope<Sample>::getCurrentStage() const
+{
+    return m_currentStage;
+}
+template <typename Sample>
+Sample BasicStageEnvelope<Sample>::getLevel() const
+{
+    return m_level;
+}
+template <typename Sample>
+bool BasicStageEnvelope<Sample>::isActive() const
+{
+    return m_currentStage >= 0;
+}
+template <typename Sample>
+bool BasicStageEnvelope<Sample>::isSustaining() const
+{
+    return m_isSustaining;
+}
+template <typename Sample>
+bool BasicStageEnvelope<Sample>::isLooping() const
+{
+    return m_isLooping;
+}
+
+// methods
+
+template <typename Sample>
+void BasicStageEnvelope<Sample>::trigger()
+{
+    // from zero like Envelope::trigger()
+    enterStage(0, SampleMath<Sample>::fromFloat(0.0f));
+}
+template <typename Sample>
+void BasicStageEnvelope<Sample>::release()
+{
+    if (m_releaseStage < 0 || m_currentStage < 0 || m_currentStage >= m_releaseStage)
+    {
+        return;
+    }
+    enterStage(m_releaseStage, m_level);
+}
+template <typename Sample>
+void BasicStageEnvelope<Sample>::reset()
+{
+    m_currentStage = -1;
+    m_isSustaining = false;
+    m_level = SampleMath<Sample>::fromFloat(0.0f);
+    m_elapsedTime = 0;
+}
+
+template <typename Sample>
+typename BasicStageEnvelope<Sample>::BlockInfo BasicStageEnvelope<Sample>::renderBlock(Sample* output, int numSamples,
+                                                                                       float sampleRate)
+{
+    // the same segment runs as Envelope::renderBlock(), only the table decides what comes next
+    using Math = SampleMath<Sample>;
+
+    typename Math::Time deltaTime = Math::getDeltaTime(sampleRate);
+    int i = 0;
+
+    while (i < numSamples)
+    {
+        if (m_currentStage < 0 || m_isSustaining)
+        {
+            m_level = Math::fromFloat((m_currentStage < 0) ? 0.0f : m_stages[m_currentStage].level);
+            std::fill(output + i, output + numSamples, m_level);
+
+            return BlockInfo{i == 0, m_level};
+        }
+
+        const EnvelopeStage& stage = m_stages[m_currentStage];
+
+        // samples until the stage ends, the one that reaches the end included
+        typename Math::Time endTime = Math::getEndTime(stage.time - STAGE_END_TOLERANCE, sampleRate);
+        double samplesLeft = std::max(Math::getSamplesUntil(endTime, m_elapsedTime, deltaTime), 1.0);
+        int runLength = static_cast<int>(std::min(samplesLeft, static_cast<double>(numSamples - i)));
+
+        typename Math::Time startTime = m_elapsedTime;
+        typename Math::Inverse inverseTime = Math::getInverse(stage.time, sampleRate);
+        int curve = Math::findCurve(stage.curve);
+        Sample* run = output + i;
+
+        for (int j = 0; j < runLength; j++)
+        {
+            Sample normalizedTime = Math::normalize(Math::advance(startTime, j + 1, deltaTime), inverseTime);
+            run[j] = m_offset + m_scale * Math::shape(m_base + m_direction * normalizedTime, stage.curve, curve);
+        }
+
+        m_elapsedTime = Math::advance(startTime, runLength, deltaTime);
+        m_level = run[runLength - 1];
+        i += runLength;
+
+        if (runLength == samplesLeft)
+        {
+            finishStage();
+            output[i - 1] = m_level;
+        }
+    }
+
+    return BlockInfo{false, Math::fromFloat(0.0f)};
+}
+
+template <typename Sample>
+void BasicStageEnvelope<Sample>::enterStage(int index, Sample startLevel)
+{
+    using Math = SampleMath<Sample>;
+
+    const EnvelopeStage& stage = m_stages[index];
+    Sample target = Math::fromFloat(stage.level);
+
+    m_currentStage = index;
+    m_isSustaining = false;
+    m_elapsedTime = 0;
+
+    // rising shapes start at the current level, falling ones end at the target
+    bool isFalling = (stage.flags & EnvelopeStage::FALLING) != 0;
+
+    m_offset = isFalling ? target : startLevel;
+    m_scale = isFalling ? startLevel - target : target - startLevel;
+    m_base = Math::fromFloat(isFalling ? 1.0f : 0.0f);
+    m_direction = Math::fromFloat(isFalling ? -1.0f : 1.0f);
+}
+
+template <typename Sample>
+void BasicStageEnvelope<Sample>::finishStage()
+{
+    if (m_stages[m_currentStage].flags & EnvelopeStage::SUSTAIN)
+    {
+        m_isSustaining = true;
+        return;
+    }
+
+    // the next stage carries on from this one's target, not from the last sample,
+    // which can stop just short of it
+    int next = m_currentStage + 1;
+    Sample target = SampleMath<Sample>::fromFloat(m_stages[m_currentStage].level);
+
+    if (next < m_stageCount && next != m_releaseStage)
+    {
+        enterStage(next, target);
+    }
+    else if (m_isLooping)
+    {
+        enterStage(m_loopStage, target);
+    }
+    else
+    {
+        reset();
+    }
+}
+
+template class BasicStageEnvelope<float>;
+template class BasicStageEnvelope<double>;
+template class BasicStageEnvelope<EnvelopeFixed>;
@@ -0,0 +1,150 @@
+#ifndef STAGE_ENVELOPE_HPP
+#define STAGE_ENVELOPE_HPP
+
+#include <cstdint>
+
+#include "envelope_generator.hpp"
+#include "fixed_point.hpp"
+
+/*
+    Envelope engine driven by a table of stages instead of fixed phases.
+
+    Each stage moves from the previous stage's target level (from the
+    current level after release(), from 0 after trigger()) to its own
+    target level over its time, shaped by its curve (an exponent, 1 is
+    linear). Flags on a stage say what happens around it:
+
+        SUSTAIN     hold the target level once reached until release()
+        RELEASE     release() jumps here, from the current level
+        LOOP_START  where a looping envelope starts its next cycle
+        FALLING     shape the stage like a release, (1 - t)^curve from
+                    the end, instead of t^curve from the start
+
+    After the last stage the cycle ends: a looping envelope goes back to
+    the LOOP_START stage (the first one if none is marked), otherwise it
+    goes inactive at level 0.
+
+    ADSR, ASR and AD are presets of it and render the same samples as
+    Envelope::renderBlock(). DAHDSR and anything else up to MAX_STAGES
+    stages is just a different table. The table lives inside the object,
+    so there's nothing to chase or allocate while rendering.
+
+    The engine is a template on the sample type, which levels and time
+    are also kept in while rendering; the stage table stays in float.
+    stage_envelope.cpp builds three of them:
+
+        StageEnvelope       float, matches Envelope
+        StageEnvelopeDouble double, keeps long stages on time
+        StageEnvelopeFixed  Q11.20 (fixed_point.hpp), integer only in
+                            the render loop: time is counted in samples
+                            and curves come from the Q format tables in
+                            curve_table.hpp
+
+    Envelope itself is float only and nothing renders through the double
+    or fixed point builds yet, envelope_bench_sample_types compares them.
+    Long renders with Envelope stay on time through
+    Envelope::TimingMode::SAMPLE_COUNT instead, which counts whole
+    samples rather than adding up float seconds.
+*/
+
+struct EnvelopeStage
+{
+    enum Flags : std::uint32_t
+    {
+        SUSTAIN    = 1 << 0,
+        RELEASE    = 1 << 1,
+        LOOP_START = 1 << 2,
+        FALLING    = 1 << 3
+    };
+
+    float level;            // target level at the end of the stage
+    float time;             // seconds
+    float curve;            // exponent, 1 = linear
+    std::uint32_t flags;
+};
+
+// what elapsed time is kept in while rendering: seconds, or whole samples for fixed point
+template <typename Sample>
+struct StageClock
+{
+    using Time = Sample;
+};
+
+template <>
+struct StageClock<EnvelopeFixed>
+{
+    using Time = std::int64_t;
+};
+
+template <typename Sample>
+class BasicStageEnvelope
+{
+    public:
+        static constexpr int MAX_STAGES = 16;
+
+        struct BlockInfo
+        {
+            bool isConstant;
+            Sample constantValue;
+        };
+
+        BasicStageEnvelope();
+
+        bool setStages(const EnvelopeStage* stages, int count);    // false if count is out of range
+        void setLooping(bool isLooping);
+
+        // presets, curves are exponents like Envelope's getters return
+        void setADSR(float attackTime, float attackCurve, float decayTime, float decayCurve,
+                     float sustainLevel, float releaseTime, float releaseCurve);
+        void setASR(float attackTime, float attackCurve, float sustainLevel, float releaseTime, float releaseCurve);
+        void setAD(float attackTime, float attackCurve, float decayTime, float decayCurve);
+        void setDAHDSR(float delayTime, float attackTime, float attackCurve, float holdTime, float decayTime,
+                       float decayCurve, float sustainLevel, float releaseTime, float releaseCurve);
+        void setFromEnvelope(const Envelope& envelope);    // the matching preset, with Envelope's settings
+
+        int getStageCount() const;
+        const EnvelopeStage& getStage(int index) const;
+        int getCurrentStage() const;    // -1 when inactive
+        Sample getLevel() const;
+        bool isActive() const;
+        bool isSustaining() const;
+        bool isLooping() const;
+
+        void trigger();
+        void release();
+        void reset();
+        BlockInfo renderBlock(Sample* output, int numSamples, float sampleRate);
+
+    private:
+        void enterStage(int index, Sample startLevel);
+        void finishStage();
+
+        static constexpr float STAGE_END_TOLERANCE = 0.0001f;
+
+        EnvelopeStage m_stages[MAX_STAGES];
+        int m_stageCount;
+        int m_releaseStage;         // -1 = release() does nothing
+        int m_loopStage;
+        bool m_isLooping;
+
+        int m_currentStage;         // -1 = inactive
+        bool m_isSustaining;
+        Sample m_level;
+        typename StageClock<Sample>::Time m_elapsedTime;
+
+        // the current stage as offset + scale * pow(base + direction * t, curve)
+        Sample m_offset;
+        Sample m_scale;
+        Sample m_base;
+        Sample m_direction;
+};
+
+extern template class BasicStageEnvelope<float>;
+extern template class BasicStageEnvelope<double>;
+extern template class BasicStageEnvelope<EnvelopeFixed>;
+
+using StageEnvelope = BasicStageEnvelope<float>;
+using StageEnvelopeDouble = BasicStageEnvelope<double>;
+using StageEnvelopeFixed = BasicStageEnvelope<EnvelopeFixed>;
+
+#endif // STAGE_ENVELOPE_HPP
@@ -0,0 +1,203 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "trace.hpp"
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name;
+        std::int64_t start;
+        std::int64_t end;
+    };
+
+    struct ThreadBuffer
+    {
+        std::unique_ptr<TraceEvent[]> events;
+
+        // capture number in the high half, event count in the low half, so a
+        // reader never pairs a count with the wrong capture
+        std::atomic<std::uint64_t> state{0};
+        std::atomic<std::size_t> dropped{0};
+
+        std::atomic<const char*> name{nullptr};
+        std::uint32_t threadId = 0;
+    };
+
+    // buffers outlive their threads, a capture keeps the events of threads that have exited
+    std::mutex s_registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+
+    std::atomic<std::uint32_t> s_capture{0};
+    std::atomic<std::int64_t> s_captureStart{0};
+
+    thread_local ThreadBuffer* t_buffer = nullptr;
+
+    ThreadBuffer& getThreadBuffer()
+    {
+        if (t_buffer == nullptr)
+        {
+            std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+            buffer->events.reset(new TraceEvent[Trace::EVENTS_PER_THREAD]);
+
+            std::lock_guard<std::mutex> lock(s_registryMutex);
+            buffer->threadId = static_cast<std::uint32_t>(s_buffers.size() + 1);
+            t_buffer = buffer.get();
+            s_buffers.push_back(std::move(buffer));
+        }
+        return *t_buffer;
+    }
+
+    // events recorded in the current capture
+    std::size_t getCapturedCount(const ThreadBuffer& buffer, std::uint32_t capture)
+    {
+        std::uint64_t state = buffer.state.load(std::memory_order_acquire);
+        return (state >> 32) == capture ? static_cast<std::size_t>(state & 0xFFFFFFFF) : 0;
+    }
+
+    void writeJsonString(std::ostream& out, const char* text)
+    {
+        out << '"';
+        for (const char* c = text; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                out << '\\';
+            }
+            out << *c;
+        }
+        out << '"';
+    }
+}
+
+void Trace::start()
+{
+    // threads notice the new capture number on their next event and start their buffer over
+    s_captureStart.store(now(), std::memory_order_relaxed);
+    s_capture.fetch_add(1, std::memory_order_release);
+    s_isRunning.store(true, std::memory_order_release);
+}
+
+void Trace::stop()
+{
+    s_isRunning.store(false, std::memory_order_release);
+}
+
+std::int64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char* name, std::int64_t start, std::int64_t end)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::uint32_t capture = s_capture.load(std::memory_order_acquire);
+
+    // only this thread writes the state
+    std::uint64_t state = buffer.state.load(std::memory_order_relaxed);
+    if ((state >> 32) != capture)
+    {
+        state = static_cast<std::uint64_t>(capture) << 32;
+        buffer.dropped.store(0, std::memory_order_relaxed);
+    }
+
+    std::size_t count = static_cast<std::size_t>(state & 0xFFFFFFFF);
+    if (count == EVENTS_PER_THREAD)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer.events[count] = {name, start, end};
+    buffer.state.store(state + 1, std::memory_order_release);
+}
+
+void Trace::setThreadName(const char* name)
+{
+    getThreadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+std::size_t Trace::getEventCount()
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    std::uint32_t capture = s_capture.load(std::memory_order_acquire);
+
+    std::size_t count = 0;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : s_buffers)
+    {
+        count += getCapturedCount(*buffer, capture);
+    }
+    return count;
+}
+
+std::size_t Trace::getDroppedCount()
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    std::uint32_t capture = s_capture.load(std::memory_order_acquire);
+
+    std::size_t count = 0;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : s_buffers)
+    {
+        count += (buffer->state.load(std::memory_order_acquire) >> 32) == capture ? buffer->dropped.load() : 0;
+    }
+    return count;
+}
+
+bool Trace::write(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    std::uint32_t capture = s_capture.load(std::memory_order_acquire);
+    std::int64_t captureStart = s_captureStart.load(std::memory_order_relaxed);
+    std::size_t dropped = 0;
+
+    // timestamps in microseconds from the start of the capture
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"envelope\"}}";
+
+    for (const std::unique_ptr<ThreadBuffer>& buffer : s_buffers)
+    {
+        const char* name = buffer->name.load(std::memory_order_relaxed);
+        if (name != nullptr)
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+            writeJsonString(file, name);
+            file << "}}";
+        }
+
+        std::size_t count = getCapturedCount(*buffer, capture);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const TraceEvent& event = buffer->events[i];
+            file << ",\n{\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"cat\":\"envelope\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                 << ",\"ts\":" << (event.start - captureStart) / 1000.0
+                 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+        }
+        dropped += count > 0 ? buffer->dropped.load() : 0;
+    }
+
+    file << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":\"" << dropped << "\"}}\n";
+
+    if (!file)
+    {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
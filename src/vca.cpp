@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "simd.hpp"
+#include "vca.hpp"
+
+namespace
+{
+    // small enough to stay in L1 next to the audio going through
+    const int CHUNK_FRAMES = 64;
+
+    void scaleSamples(float* audio, int numSamples, float gain)
+    {
+        if (gain == 1.0f)
+        {
+            return;
+        }
+        if (gain == 0.0f)
+        {
+            std::fill(audio, audio + numSamples, 0.0f);
+            return;
+        }
+
+        int i = 0;
+#ifdef ENVELOPE_SSE2
+        __m128 gains = _mm_set1_ps(gain);
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            _mm_storeu_ps(audio + i, _mm_mul_ps(_mm_loadu_ps(audio + i), gains));
+        }
+#endif
+        for (; i < numSamples; i++)
+        {
+            audio[i] *= gain;
+        }
+    }
+
+    void multiplyMono(float* audio, const float* gains, int numFrames)
+    {
+        int i = 0;
+#ifdef ENVELOPE_SSE2
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            _mm_storeu_ps(audio + i, _mm_mul_ps(_mm_loadu_ps(audio + i), _mm_loadu_ps(gains + i)));
+        }
+#endif
+        for (; i < numFrames; i++)
+        {
+            audio[i] *= gains[i];
+        }
+    }
+
+    void multiplyStereo(float* audio, const float* gains, int numFrames)
+    {
+        int i = 0;
+#ifdef ENVELOPE_SSE2
+        // four frames at a time, each gain duplicated for left and right
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            __m128 frameGains = _mm_loadu_ps(gains + i);
+            float* frames = audio + 2 * i;
+
+            _mm_storeu_ps(frames, _mm_mul_ps(_mm_loadu_ps(frames), _mm_unpacklo_ps(frameGains, frameGains)));
+            _mm_storeu_ps(frames + 4, _mm_mul_ps(_mm_loadu_ps(frames + 4), _mm_unpackhi_ps(frameGains, frameGains)));
+        }
+#endif
+        for (; i < numFrames; i++)
+        {
+            audio[2 * i] *= gains[i];
+            audio[2 * i + 1] *= gains[i];
+        }
+    }
+
+    void multiplyInterleaved(float* audio, const float* gains, int numFrames, int numChannels)
+    {
+        for (int i = 0; i < numFrames; i++)
+        {
+            float* frame = audio + i * numChannels;
+            for (int channel = 0; channel < numChannels; channel++)
+            {
+                frame[channel] *= gains[i];
+            }
+        }
+    }
+}
+
+Envelope::BlockInfo applyEnvelope(Envelope& envelope, float* audio, int numFrames, int numChannels, float sampleRate)
+{
+    float gains[CHUNK_FRAMES];
+    int frame = 0;
+
+    while (frame < numFrames)
+    {
+        int chunkFrames = std::min(CHUNK_FRAMES, numFrames - frame);
+        float* chunk = audio + frame * numChannels;
+
+        Envelope::BlockInfo info = envelope.renderBlock(gains, chunkFrames, sampleRate);
+
+        if (info.isConstant)
+        {
+            // sustain or inactive, which lasts until the next trigger() or release()
+            // so the rest of the block gets the same gain
+            scaleSamples(chunk, (numFrames - frame) * numChannels, info.constantValue);
+            return Envelope::BlockInfo{frame == 0, info.constantValue};
+        }
+
+        switch (numChannels)
+        {
+            case 1:
+                multiplyMono(chunk, gains, chunkFrames);
+                break;
+            case 2:
+                multiplyStereo(chunk, gains, chunkFrames);
+                break;
+            default:
+                multiplyInterleaved(chunk, gains, chunkFrames, numChannels);
+                break;
+        }
+
+        frame += chunkFrames;
+    }
+
+    return Envelope::BlockInfo{false, 0.0f};
+}
+
+Envelope::BlockInfo applyEnvelope(Envelope& envelope, float* audio, int numSamples, float sampleRate)
+{
+    return applyEnvelope(envelope, audio, numSamples, 1, sampleRate);
+}
@@ -0,0 +1,23 @@
+#ifndef VCA_HPP
+#define VCA_HPP
+
+#include "envelope_generator.hpp"
+
+/*
+    Envelope-controlled amplifier: renders the envelope and multiplies it
+    into an audio buffer in the same pass, in place.
+
+    The envelope goes through a small chunk on the stack that stays in
+    cache, so the audio is only read and written once and the caller
+    doesn't need an envelope buffer. Sustain and inactive stretches are a
+    single gain for the rest of the block, so those become one scale (or
+    a clear) without rendering the envelope at all.
+*/
+
+// audio holds numFrames frames of numChannels interleaved samples
+Envelope::BlockInfo applyEnvelope(Envelope& envelope, float* audio, int numFrames, int numChannels, float sampleRate);
+
+// mono shorthand
+Envelope::BlockInfo applyEnvelope(Envelope& envelope, float* audio, int numSamples, float sampleRate);
+
+#endif // VCA_HPP
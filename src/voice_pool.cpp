@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cmath>
+
+#include "voice_pool.hpp"
+
+VoicePool::VoicePool(int voiceCount, int maxBlockSize)
+: m_voices(voiceCount)
+, m_skippedAtStart(voiceCount, 0)
+, m_voiceBuffer(maxBlockSize)
+, m_silenceThreshold(-INFINITY)
+, m_skippedSamples(0)
+, m_cvBus(nullptr)
+{
+    m_activeVoices.reserve(voiceCount);
+    m_freeVoices.reserve(voiceCount);
+
+    // highest index on top, so voice 0 is handed out first
+    for (int voice = voiceCount - 1; voice >= 0; voice--)
+    {
+        m_freeVoices.push_back(voice);
+    }
+}
+
+void VoicePool::setSilenceThreshold(float decibels)
+{
+    m_silenceThreshold = decibels;
+}
+
+void VoicePool::setCvBus(CvBus* bus)
+{
+    m_cvBus = bus;
+}
+
+int VoicePool::noteOn(const Envelope& settings)
+{
+    if (m_freeVoices.empty())
+    {
+        return -1;
+    }
+
+    int voice = m_freeVoices.back();
+    m_freeVoices.pop_back();
+    m_activeVoices.push_back(voice);
+
+    Envelope& envelope = m_voices[voice];
+    envelope = settings;
+    envelope.setSilenceThreshold(m_silenceThreshold);
+    envelope.reset();
+    envelope.trigger();
+
+    // the copy brings the settings' counter along, only count from here on
+    m_skippedAtStart[voice] = envelope.getSkippedSampleCount();
+
+    return voice;
+}
+
+void VoicePool::noteOff(int voice)
+{
+    if (voice >= 0 && voice < getVoiceCount())
+    {
+        m_voices[voice].release();
+    }
+}
+
+void VoicePool::render(float* mix, int numSamples, float sampleRate)
+{
+    int blockSize = static_cast<int>(m_voiceBuffer.size());
+    float* voiceOutput = m_voiceBuffer.data();
+
+    std::fill(mix, mix + numSamples, 0.0f);
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        int length = std::min(blockSize, numSamples - start);
+        float* mixBlock = mix + start;
+
+        for (std::size_t i = 0; i < m_activeVoices.size(); i++)
+        {
+            Envelope::BlockInfo info = m_voices[m_activeVoices[i]].renderBlock(voiceOutput, length, sampleRate);
+
+            if (!info.isConstant)
+            {
+                for (int j = 0; j < length; j++)
+                {
+                    mixBlock[j] += voiceOutput[j];
+                }
+            }
+            else if (info.constantValue != 0.0f)
+            {
+                for (int j = 0; j < length; j++)
+                {
+                    mixBlock[j] += info.constantValue;
+                }
+            }
+        }
+
+        if (m_cvBus)
+        {
+            publishVoices();
+        }
+
+        // back to the pool once they've finished, walk backwards since freeVoice() swaps in the last one
+        for (std::size_t i = m_activeVoices.size(); i > 0; i--)
+        {
+            if (!m_voices[m_activeVoices[i - 1]].isActive())
+            {
+                freeVoice(static_cast<int>(i - 1));
+            }
+        }
+    }
+}
+
+void VoicePool::reset()
+{
+    while (!m_activeVoices.empty())
+    {
+        m_voices[m_activeVoices.back()].reset();
+        freeVoice(static_cast<int>(m_activeVoices.size()) - 1);
+    }
+}
+
+void VoicePool::freeVoice(int activeIndex)
+{
+    int voice = m_activeVoices[activeIndex];
+    m_skippedSamples += m_voices[voice].getSkippedSampleCount() - m_skippedAtStart[voice];
+
+    m_activeVoices[activeIndex] = m_activeVoices.back();
+    m_activeVoices.pop_back();
+    m_freeVoices.push_back(voice);
+}
+
+void VoicePool::publishVoices()
+{
+    CvVoiceState* states = m_cvBus->beginFrame();
+    if (states == nullptr)
+    {
+        return;
+    }
+
+    // every voice, free ones read as inactive at 0
+    int count = std::min(getVoiceCount(), static_cast<int>(m_cvBus->getVoiceCount()));
+    for (int voice = 0; voice < count; voice++)
+    {
+        const Envelope& envelope = m_voices[voice];
+        states[voice] = CvVoiceState{envelope.getAmplitude(), envelope.getProgress(), static_cast<std::uint32_t>(envelope.getPhase())};
+    }
+    for (int voice = count; voice < static_cast<int>(m_cvBus->getVoiceCount()); voice++)
+    {
+        states[voice] = CvVoiceState{0.0f, 0.0f, Envelope::INACTIVE};
+    }
+
+    m_cvBus->endFrame();
+}
+
+int VoicePool::getVoiceCount() const
+{
+    return static_cast<int>(m_voices.size());
+}
+int VoicePool::getActiveVoiceCount() const
+{
+    return static_cast<int>(m_activeVoices.size());
+}
+std::uint64_t VoicePool::getSkippedSampleCount() const
+{
+    std::uint64_t skipped = m_skippedSamples;
+    for (int voice : m_activeVoices)
+    {
+        skipped += m_voices[voice].getSkippedSampleCount() - m_skippedAtStart[voice];
+    }
+    return skipped;
+}
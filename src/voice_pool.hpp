@@ -0,0 +1,58 @@
+#ifndef VOICE_POOL_HPP
+#define VOICE_POOL_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "cv_bus.hpp"
+#include "envelope_generator.hpp"
+
+/*
+    A fixed set of envelope voices for polyphonic rendering.
+
+    noteOn() takes a free voice, render() sums every active voice into a
+    mix buffer and hands voices that have gone inactive back to the free
+    list, so finished notes stop costing anything. With a silence
+    threshold set, tails are ended as soon as they drop below it instead
+    of running the full release time.
+
+    With a CvBus set, render() publishes every voice's state to it after
+    each block, for other processes to read.
+
+    Everything is allocated up front, noteOn(), noteOff() and render()
+    never allocate.
+*/
+
+class VoicePool
+{
+    public:
+        VoicePool(int voiceCount, int maxBlockSize);
+
+        void setSilenceThreshold(float decibels);   // used by voices started after this
+        void setCvBus(CvBus* bus);                  // null = don't publish, voices past the bus's count are left out
+
+        int noteOn(const Envelope& settings);       // voice index, -1 when every voice is busy
+        void noteOff(int voice);
+        void render(float* mix, int numSamples, float sampleRate);  // mix is overwritten with the sum
+        void reset();
+
+        int getVoiceCount() const;
+        int getActiveVoiceCount() const;
+        std::uint64_t getSkippedSampleCount() const;  // voice samples saved by the silence threshold
+
+    private:
+        void freeVoice(int activeIndex);
+        void publishVoices();
+
+        std::vector<Envelope> m_voices;
+        std::vector<std::uint64_t> m_skippedAtStart;    // each voice's counter at noteOn()
+        std::vector<int> m_activeVoices;
+        std::vector<int> m_freeVoices;
+        std::vector<float> m_voiceBuffer;
+
+        float m_silenceThreshold;
+        std::uint64_t m_skippedSamples;     // from voices already back in the pool
+        CvBus* m_cvBus;
+};
+
+#endif // VOICE_POOL_HPP
@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "wav_writer.hpp"
+
+namespace
+{
+    const std::uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+
+    // fields go in little-endian whatever the machine
+    class HeaderWriter
+    {
+        public:
+            explicit HeaderWriter(unsigned char* data) : m_data(data) {}
+
+            void tag(const char* id)
+            {
+                std::memcpy(m_data, id, 4);
+                m_data += 4;
+            }
+            void u16(std::uint16_t value) { put(value, 2); }
+            void u32(std::uint32_t value) { put(value, 4); }
+            void u64(std::uint64_t value) { put(value, 8); }
+
+        private:
+            void put(std::uint64_t value, int bytes)
+            {
+                for (int i = 0; i < bytes; i++)
+                {
+                    *m_data++ = static_cast<unsigned char>(value >> (8 * i));
+                }
+            }
+
+            unsigned char* m_data;
+    };
+}
+
+std::size_t makeWavHeader(unsigned char* header, std::size_t numFrames, unsigned int numChannels,
+                          unsigned int sampleRate, std::uint64_t rf64Threshold)
+{
+    std::uint64_t dataSize = static_cast<std::uint64_t>(numFrames) * numChannels * sizeof(float);
+
+    // past 4 GB the 32-bit sizes are set to 0xFFFFFFFF and the real ones go in ds64 (RF64, EBU Tech 3306)
+    bool isRF64 = dataSize > rf64Threshold;
+    std::size_t headerSize = isRF64 ? RF64_HEADER_SIZE : WAV_HEADER_SIZE;
+    std::uint64_t riffSize = headerSize - 8 + dataSize;
+
+    HeaderWriter writer(header);
+    writer.tag(isRF64 ? "RF64" : "RIFF");
+    writer.u32(isRF64 ? 0xFFFFFFFFu : static_cast<std::uint32_t>(riffSize));
+    writer.tag("WAVE");
+
+    if (isRF64)
+    {
+        writer.tag("ds64");
+        writer.u32(28);
+        writer.u64(riffSize);
+        writer.u64(dataSize);
+        writer.u64(numFrames);
+        writer.u32(0);      // no table of other large chunks
+    }
+
+    writer.tag("fmt ");
+    writer.u32(16);
+    writer.u16(WAVE_FORMAT_IEEE_FLOAT);
+    writer.u16(static_cast<std::uint16_t>(numChannels));
+    writer.u32(sampleRate);
+    writer.u32(sampleRate * numChannels * sizeof(float));
+    writer.u16(static_cast<std::uint16_t>(numChannels * sizeof(float)));
+    writer.u16(32);
+
+    writer.tag("data");
+    writer.u32(isRF64 ? 0xFFFFFFFFu : static_cast<std::uint32_t>(dataSize));
+
+    return headerSize;
+}
+
+bool writeWavFile(const std::string& path, const float* samples, std::size_t numFrames,
+                  unsigned int numChannels, unsigned int sampleRate, std::uint64_t rf64Threshold)
+{
+    unsigned char header[RF64_HEADER_SIZE];
+    std::size_t headerSize = makeWavHeader(header, numFrames, numChannels, sampleRate, rf64Threshold);
+    std::uint64_t dataSize = static_cast<std::uint64_t>(numFrames) * numChannels * sizeof(float);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(header), static_cast<std::streamsize>(headerSize));
+    file.write(reinterpret_cast<const char*>(samples), static_cast<std::streamsize>(dataSize));
+
+    return static_cast<bool>(file);
+}
+
+float* createMappedWavFile(MappedFile& file, const std::string& path, std::size_t numFrames,
+                           unsigned int numChannels, unsigned int sampleRate, std::uint64_t rf64Threshold)
+{
+    unsigned char header[RF64_HEADER_SIZE];
+    std::size_t headerSize = makeWavHeader(header, numFrames, numChannels, sampleRate, rf64Threshold);
+    std::uint64_t dataSize = static_cast<std::uint64_t>(numFrames) * numChannels * sizeof(float);
+
+    if (!file.create(path, static_cast<std::size_t>(headerSize + dataSize)))
+    {
+        return nullptr;
+    }
+
+    // both header sizes are multiples of 4, so the samples after them stay aligned
+    std::memcpy(file.getWritableData(), header, headerSize);
+
+    return reinterpret_cast<float*>(file.getWritableData() + headerSize);
+}
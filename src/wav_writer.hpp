@@ -0,0 +1,43 @@
+#ifndef WAV_WRITER_HPP
+#define WAV_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.hpp"
+
+/*
+    Writes rendered envelopes as 32-bit float WAV files. Files with
+    more than 4 GB of samples are written as RF64, the same layout with
+    64-bit sizes in a ds64 chunk, which most audio tools read.
+
+    writeWavFile() writes samples that are already rendered,
+    createMappedWavFile() makes the file first and maps it, so
+    samples can be rendered straight into their place in it.
+
+    rf64Threshold is the most sample data a plain RIFF file is written
+    with. It's only lowered by tests, to get RF64 files of a few bytes.
+*/
+
+// canonical 44 byte header, or 80 bytes for RF64 with its ds64 chunk
+const std::size_t WAV_HEADER_SIZE = 44;
+const std::size_t RF64_HEADER_SIZE = 80;
+
+// the most data bytes the 32-bit RIFF size fields can describe
+const std::uint64_t MAX_RIFF_DATA_SIZE = 0xFFFFFFFFull - WAV_HEADER_SIZE;
+
+// fills header, which needs RF64_HEADER_SIZE bytes, returns its size
+std::size_t makeWavHeader(unsigned char* header, std::size_t numFrames, unsigned int numChannels,
+                          unsigned int sampleRate, std::uint64_t rf64Threshold = MAX_RIFF_DATA_SIZE);
+
+bool writeWavFile(const std::string& path, const float* samples, std::size_t numFrames,
+                  unsigned int numChannels, unsigned int sampleRate,
+                  std::uint64_t rf64Threshold = MAX_RIFF_DATA_SIZE);
+
+// the interleaved samples inside the mapped file, nullptr on failure, flush() the file once they're written
+float* createMappedWavFile(MappedFile& file, const std::string& path, std::size_t numFrames,
+                           unsigned int numChannels, unsigned int sampleRate,
+                           std::uint64_t rf64Threshold = MAX_RIFF_DATA_SIZE);
+
+#endif // WAV_WRITER_HPP